@@ -26,6 +26,8 @@
 #endif
 
 #include <edge-ml-accelerator/utils/edge_ml_config.h>
+#include <edge-ml-accelerator/utils/frame_pool.h>
+#include <edge-ml-accelerator/utils/frame_pyramid.h>
 
 #include <nlohmann/json.hpp>
 
@@ -62,6 +64,20 @@ namespace edgeml
                 std::string getCaptureMode();
                 double getExposureTime();
                 int getGainValue();
+                bool getIsRoi();
+                void getRoi(int& offsetX, int& offsetY, int& roiWidth, int& roiHeight);
+                int getBinning();
+                int getDecimation();
+                bool getIsNegotiateSize();
+                void getRequiredModelSize(int& reqHeight, int& reqWidth);
+                void setRequiredModelSize(int reqHeight, int reqWidth);
+                int negotiateScaleFactor(int fullHeight, int fullWidth);
+                void getBurstPlan(MessageT2C& message, int& burstCount, std::vector<double>& exposureList);
+                void setBurstDetails(nlohmann::json& inferenceDetails, int burstCount, std::vector<double>& exposureList);
+                std::shared_ptr<unsigned char> acquireBurstFrame(size_t frameSize, int burstCount);
+                bool getIsFramePyramid();
+                void attachFramePyramids(MessageCaptureInference& message);
+                void attachRois(MessageCaptureInference& message);
                 nlohmann::json getInferenceDetailsJson();
                 void setGenericTrigger(bool value){genericTrigger_ = value;}
                 virtual int initCapture(int cameraIndex = -1){return -1;}
@@ -81,6 +97,16 @@ namespace edgeml
                 std::string captureType_, serialNumber_, captureMode_;
                 std::string colorSpace_;
                 int numInferences_;
+                int roiOffsetX_ = 0, roiOffsetY_ = 0, roiWidth_ = 0, roiHeight_ = 0;
+                int binning_ = 1, decimation_ = 1;
+                bool negotiateSize_ = false;
+                int requiredModelHeight_ = 0, requiredModelWidth_ = 0; // input shapes of the loaded models
+                bool framePyramid_ = false;
+                std::vector<RegionOfInterest> cameraRois_;
+                std::map<std::string, std::vector<RegionOfInterest>> subpipelineRois_;
+                int burstCount_ = 1;
+                std::vector<double> exposureList_;
+                std::unique_ptr<utils::FramePool> burstPool_;
                 bool genericTrigger_ = false;
                 nlohmann::json inferenceDetailsJson;
                 SharedMessage<MessageT2C> &trigger2camera_;
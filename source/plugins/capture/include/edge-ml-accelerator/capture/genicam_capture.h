@@ -56,6 +56,9 @@ namespace edgeml
 
             private:
                 int runCapture(unsigned char*& frameData, int& frameDataSize); // Running capture
+                void setSensorGeometry(); // Setting ROI, binning and decimation on the camera, else cropping in software
+                int setScaleFactor(int factor); // Setting binning or decimation and returning the factor applied by the camera
+                int64_t alignNodeValue(const char* name, int64_t value); // Aligning a value to the increment and limits of an integer node
 
                 std::string colorSpace_;
                 nlohmann::json inferenceDetailsBlank, inferenceDetailsFilled;
@@ -68,6 +71,9 @@ namespace edgeml
                 uint32_t npart_;
                 uint64_t format_;
                 size_t yoffset_, px;
+                bool softwareCrop_ = false;
+                int cropX_ = 0, cropY_ = 0, cropWidth_ = 0, cropHeight_ = 0;
+                std::vector<uint8_t> convertBuffer_;
                 bool firstFrame_ = true;
                 int ret_;
                 int delay_ = -1; //milliseconds
@@ -0,0 +1,68 @@
+/**
+ * @gstreamer_capture.h
+ * @brief Creating and Running Capture
+ *
+ * This contains the prototypes for creating and running capture by pulling samples from a GStreamer appsink.
+ * Mapped buffers are handed downstream without copying and released once the last consumer is done.
+ *
+ */
+
+#ifndef __GSTREAMER_CAPTURE_H__
+#define __GSTREAMER_CAPTURE_H__
+
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <gst/video/video.h>
+
+#include <opencv2/opencv.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <queue>
+#include <chrono>
+#include <mutex>
+
+#include <edge-ml-accelerator/capture/base_capture.h>
+#include <edge-ml-accelerator/utils/frame_pool.h>
+#include <edge-ml-accelerator/utils/image_preprocess.h>
+
+namespace edgeml
+{
+    namespace capture
+    {
+
+        class GstreamerCapture : public Capture
+        {
+            public:
+                static GstreamerCapture* instance(utils::jsonParser::jValue j, int cameraIndex, SharedMessage<MessageT2C> &);
+
+                GstreamerCapture(utils::jsonParser::jValue j, int cameraIndex, SharedMessage<MessageT2C> &);
+                ~GstreamerCapture();
+                int initCapture(int cameraIndex = -1) override; // launching the pipeline given as serialNumber
+                void getCapture(int& errc, unsigned char*& frameData, int& frameDataSize, int& iter) override; // For appsink -> bytes array
+                void getCaptureAtIndex(int& errc, unsigned char*& frameData, int& frameDataSize, int& iter, int cameraIndex); // For appsink -> bytes array
+
+            private:
+                int runCapture(std::shared_ptr<void>& owner, unsigned char*& frameData, int& frameDataSize, PixelFormat& pixelFormat, bool newest); // Pulling and mapping a sample
+                int convertFrame(GstVideoInfo& info, GstMapInfo& map, unsigned char* frameData); // Converting a padded frame once into a pooled frame
+                GstElement* findAppSink(); // Getting the appsink of the launched pipeline
+
+                std::string colorSpace_, pipelineDesc_;
+                nlohmann::json inferenceDetailsBlank, inferenceDetailsFilled;
+                GstElement *pipeline_ = nullptr, *appsink_ = nullptr;
+                GstClockTime pullTimeout_ = 5 * GST_SECOND;
+                bool loop_ = true, drop_ = true;
+                int poolSize_ = 4;
+                long int droppedFrames_ = 0;
+                std::unique_ptr<utils::FramePool> framePool_;
+                std::chrono::steady_clock::time_point capture_start_time_ = std::chrono::steady_clock::now();
+                std::chrono::steady_clock::time_point capture_end_time_ = std::chrono::steady_clock::now();
+                std::chrono::duration<double> capture_elapsed_seconds_;
+        };
+
+    }
+}
+#endif
@@ -52,7 +52,8 @@ namespace edgeml
                 int numInferences_;
                 std::mutex mtx_;
                 int gpioRet_, gpioRetCap_, gpioRetStrobe_, gpioValue_ = 0, gpioValueCap_ = 0, gpioValueStrobe_ = 0;
-                bool capTriggerState_ = false, isResize_ = false;
+                bool capTriggerState_ = false, isResize_ = false, isCrop_ = false;
+                cv::Rect cropRect_;
                 std::chrono::steady_clock::time_point start_timeout_ = std::chrono::steady_clock::now();
                 std::chrono::steady_clock::time_point end_timeout_ = std::chrono::steady_clock::now();
                 std::chrono::duration<double> duration_timeout_;
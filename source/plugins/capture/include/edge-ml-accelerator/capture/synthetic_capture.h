@@ -0,0 +1,73 @@
+/**
+ * @synthetic_capture.h
+ * @brief Creating and Running Capture
+ *
+ * This contains the prototypes for creating and running a synthetic capture that generates frames
+ * without any camera hardware, to be used for load generation of the downstream stages.
+ *
+ */
+
+#ifndef __SYNTHETIC_CAPTURE_H__
+#define __SYNTHETIC_CAPTURE_H__
+
+#include <opencv2/opencv.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <queue>
+#include <chrono>
+#include <mutex>
+#include <random>
+
+#include <edge-ml-accelerator/capture/base_capture.h>
+#include <edge-ml-accelerator/utils/frame_pool.h>
+
+namespace edgeml
+{
+    namespace capture
+    {
+
+        /* Define Synthetic patterns */
+        typedef enum SyntheticPattern
+        {
+            GRADIENT = 0,
+            NOISE = 1,
+            TEMPLATE = 2
+        } SyntheticPatternE;
+
+        class SyntheticCapture : public Capture
+        {
+            public:
+                static SyntheticCapture* instance(utils::jsonParser::jValue j, int cameraIndex, SharedMessage<MessageT2C> &);
+
+                SyntheticCapture(utils::jsonParser::jValue j, int cameraIndex, SharedMessage<MessageT2C> &);
+                ~SyntheticCapture();
+                int initCapture(int cameraIndex = -1) override; // allocating and pre-rendering the frame pool
+                void getCapture(int& errc, unsigned char*& frameData, int& frameDataSize, int& iter) override; // For generated frames -> bytes array
+                void getCaptureAtIndex(int& errc, unsigned char*& frameData, int& frameDataSize, int& iter, int cameraIndex); // For generated frames -> bytes array
+
+            private:
+                int renderFrame(unsigned char* frameData, int frameIndex); // Rendering the configured pattern into a pooled buffer
+
+                std::string colorSpace_;
+                std::string patternName_, templateFile_;
+                int pattern_ = GRADIENT;
+                int poolSize_ = 8;
+                int channels_ = 3;
+                double frameRate_ = 0.0;
+                long int droppedFrames_ = 0;
+                std::unique_ptr<utils::FramePool> framePool_;
+                nlohmann::json inferenceDetailsBlank, inferenceDetailsFilled;
+                std::chrono::steady_clock::duration framePeriod_ = std::chrono::steady_clock::duration::zero();
+                std::chrono::steady_clock::time_point nextFrameTime_ = std::chrono::steady_clock::now();
+                std::chrono::steady_clock::time_point capture_start_time_ = std::chrono::steady_clock::now();
+                std::chrono::steady_clock::time_point capture_end_time_ = std::chrono::steady_clock::now();
+                std::chrono::duration<double> capture_elapsed_seconds_;
+        };
+
+    }
+}
+#endif
@@ -47,10 +47,46 @@ namespace edgeml
       resizeWidth_ = jsonParams_["preprocess"]["resizeWidth"].as_int();
       colorSpace_ = jsonParams_["preprocess"]["colorSpace"].as_string();
       numInferences_ = jsonParams_["inference"].size();
+      // Missing numbers are not read, jValue leaves them uninitialized
+      utils::jsonParser::jValue roi = jsonParams_["capture"][cameraIndex]["roi"];
+      roiOffsetX_ = (roi["offsetX"].get_type()==utils::jsonParser::JNUMBER) ? roi["offsetX"].as_int() : 0;
+      roiOffsetY_ = (roi["offsetY"].get_type()==utils::jsonParser::JNUMBER) ? roi["offsetY"].as_int() : 0;
+      roiWidth_ = (roi["width"].get_type()==utils::jsonParser::JNUMBER) ? roi["width"].as_int() : 0;
+      roiHeight_ = (roi["height"].get_type()==utils::jsonParser::JNUMBER) ? roi["height"].as_int() : 0;
+      binning_ = (jsonParams_["capture"][cameraIndex]["binning"].get_type()==utils::jsonParser::JNUMBER) ? std::max(jsonParams_["capture"][cameraIndex]["binning"].as_int(), 1) : 1;
+      decimation_ = (jsonParams_["capture"][cameraIndex]["decimation"].get_type()==utils::jsonParser::JNUMBER) ? std::max(jsonParams_["capture"][cameraIndex]["decimation"].as_int(), 1) : 1;
+      negotiateSize_ = jsonParams_["capture"][cameraIndex]["negotiateSize"].as_bool();
+      framePyramid_ = jsonParams_["capture"][cameraIndex]["framePyramid"].as_bool();
+      // Regions of interest for all subpipelines of the camera, or per subpipeline name
+      if (jsonParams_["capture"][cameraIndex]["rois"].get_type()==jsonParser::JOBJECT)
+      {
+        for (int r=0; r<jsonParams_["capture"][cameraIndex]["rois"].size(); r++)
+        {
+          std::string subpipeline = jsonParams_["capture"][cameraIndex]["rois"].to_string_key(r);
+          subpipelineRois_[subpipeline] = utils::ImagePreProcess::getRois(jsonParams_["capture"][cameraIndex]["rois"][subpipeline]);
+        }
+      }
+      else
+      {
+        cameraRois_ = utils::ImagePreProcess::getRois(jsonParams_["capture"][cameraIndex]["rois"]);
+      }
+      for (int shot=0; shot<jsonParams_["capture"][cameraIndex]["exposureList"].size(); shot++)
+      {
+        exposureList_.push_back(jsonParams_["capture"][cameraIndex]["exposureList"][shot].as_double());
+      }
+      burstCount_ = 0;
+      if (jsonParams_["capture"][cameraIndex]["burstCount"].get_type()==jsonParser::JNUMBER)
+        burstCount_ = jsonParams_["capture"][cameraIndex]["burstCount"].as_int();
+      if (burstCount_<=0)
+      {
+        burstCount_ = std::max((int)(exposureList_.size()), 1);
+      }
       LOG_ALWAYS("[CAPTURE::BASE] Base Capture class is created for camera: " + jsonParams_["capture"][cameraIndex]["cameraName"].as_string());
 
       if (captureType_=="GSTREAMER")
         captureMode_ = "GSTREAMERMODE";
+      else if (captureType_=="SYNTHETIC")
+        captureMode_ = "SYNTHETICMODE";
     }
 
     /**
@@ -195,6 +231,242 @@ namespace edgeml
       return gainValue_;
     }
 
+    /**
+      Getting if a region of interest is configured for the camera
+      @return bool true if roi width and height are set
+    */
+    bool Capture::getIsRoi()
+    {
+      return (roiWidth_>0 && roiHeight_>0);
+    }
+
+    /**
+      Getting the configured region of interest in sensor pixels
+      @param offsetX passing by reference to get the roi offset in x
+      @param offsetY passing by reference to get the roi offset in y
+      @param roiWidth passing by reference to get the roi width
+      @param roiHeight passing by reference to get the roi height
+    */
+    void Capture::getRoi(int& offsetX, int& offsetY, int& roiWidth, int& roiHeight)
+    {
+      offsetX = roiOffsetX_;
+      offsetY = roiOffsetY_;
+      roiWidth = roiWidth_;
+      roiHeight = roiHeight_;
+    }
+
+    /**
+      Getting the configured sensor binning factor
+      @return int binning factor, 1 if not binned
+    */
+    int Capture::getBinning()
+    {
+      return binning_;
+    }
+
+    /**
+      Getting the configured sensor decimation factor
+      @return int decimation factor, 1 if not decimated
+    */
+    int Capture::getDecimation()
+    {
+      return decimation_;
+    }
+
+    /**
+      Getting if the capture size is to be negotiated from the downstream models
+      @return bool true if negotiation is enabled
+    */
+    bool Capture::getIsNegotiateSize()
+    {
+      return negotiateSize_;
+    }
+
+    /**
+      Setting the largest input size of the models loaded by the inference clients of this camera
+      @param reqHeight int height of the largest model input
+      @param reqWidth int width of the largest model input
+    */
+    void Capture::setRequiredModelSize(int reqHeight, int reqWidth)
+    {
+      requiredModelHeight_ = reqHeight;
+      requiredModelWidth_ = reqWidth;
+    }
+
+    /**
+      Getting the largest model input size of all inferences used by the subpipelines of this camera, from the input
+      shapes of the loaded models and the model_height/model_width of the config (e.g. LFVE)
+      @param reqHeight passing by reference to get the required height, 0 if unknown
+      @param reqWidth passing by reference to get the required width, 0 if unknown
+    */
+    void Capture::getRequiredModelSize(int& reqHeight, int& reqWidth)
+    {
+      reqHeight = requiredModelHeight_; reqWidth = requiredModelWidth_;
+      for (int subpipelineIndex=0; subpipelineIndex<jsonParams_["capture"][cameraIndex_]["subpipelines"].size(); subpipelineIndex++)
+      {
+        for (int subsections=0; subsections<jsonParams_["capture"][cameraIndex_]["subpipelines"][subpipelineIndex].size(); subsections++)
+        {
+          std::string stageName = jsonParams_["capture"][cameraIndex_]["subpipelines"][subpipelineIndex][subsections].as_string();
+          for (int inferenceIndex=0; inferenceIndex<jsonParams_["inference"].size(); inferenceIndex++)
+          {
+            if (jsonParams_["inference"][inferenceIndex]["inferName"].as_string()!=stageName) continue;
+            for (int modelIndex=0; modelIndex<jsonParams_["inference"][inferenceIndex]["model_ids"].size(); modelIndex++)
+            {
+              utils::jsonParser::jValue model = jsonParams_["inference"][inferenceIndex]["model_ids"][modelIndex];
+              if (model["model_height"].get_type()==utils::jsonParser::JNUMBER)
+                reqHeight = std::max(reqHeight, model["model_height"].as_int());
+              if (model["model_width"].get_type()==utils::jsonParser::JNUMBER)
+                reqWidth = std::max(reqWidth, model["model_width"].as_int());
+            }
+          }
+        }
+      }
+    }
+
+    /**
+      Negotiating the largest sensor scale factor (1, 2 or 4) that still covers the input size of every model
+      @param fullHeight height of the region to be scaled
+      @param fullWidth width of the region to be scaled
+      @return int scale factor to be used for binning or decimation
+    */
+    int Capture::negotiateScaleFactor(int fullHeight, int fullWidth)
+    {
+      int reqHeight, reqWidth;
+      getRequiredModelSize(reqHeight, reqWidth);
+      if (reqHeight<=0 || reqWidth<=0)
+      {
+        LOG_ALWAYS("[CAPTURE::BASE] No model input size found for negotiating the capture size");
+        return 1;
+      }
+      for (int factor=4; factor>1; factor/=2)
+      {
+        if (fullHeight/factor>=reqHeight && fullWidth/factor>=reqWidth)
+        {
+          LOG_ALWAYS("[CAPTURE::BASE] Negotiated capture scale factor " + std::to_string(factor) + " for model input [H,W] = [" + std::to_string(reqHeight) + "," + std::to_string(reqWidth) + "]");
+          return factor;
+        }
+      }
+      return 1;
+    }
+
+    /**
+      Getting the burst for a trigger. The capture command may override the burstCount and exposureList of the config,
+      an exposureList without burstCount takes one shot per exposure, otherwise the exposures are cycled through.
+      @param message trigger message with the capture command
+      @param burstCount passing by reference to get the number of frames to capture
+      @param exposureList passing by reference to get the exposure per shot, empty to keep the current exposure
+    */
+    void Capture::getBurstPlan(MessageT2C& message, int& burstCount, std::vector<double>& exposureList)
+    {
+      burstCount = burstCount_;
+      exposureList = exposureList_;
+
+      nlohmann::json& command = message.captureTriggersMessageFull_;
+      if (!command.is_object())
+      {
+        return;
+      }
+      auto exposures = command.find("exposureList");
+      if (exposures!=command.end() && exposures->is_array())
+      {
+        exposureList.clear();
+        for (auto& exposure : *exposures)
+        {
+          if (exposure.is_number())
+          {
+            exposureList.push_back(exposure.get<double>());
+          }
+        }
+        burstCount = std::max((int)(exposureList.size()), 1);
+      }
+      auto count = command.find("burstCount");
+      if (count!=command.end() && count->is_number_integer())
+      {
+        burstCount = std::max(count->get<int>(), 1);
+      }
+    }
+
+    /**
+      Adding the burst of a capture to the inference details of the forwarded message
+      @param inferenceDetails inference details json to be filled
+      @param burstCount number of frames captured
+      @param exposureList exposure per shot
+    */
+    void Capture::setBurstDetails(nlohmann::json& inferenceDetails, int burstCount, std::vector<double>& exposureList)
+    {
+      if (burstCount<=1)
+      {
+        return;
+      }
+      inferenceDetails["burstCount"] = burstCount;
+      if (!exposureList.empty())
+      {
+        std::vector<double> shotExposures;
+        for (int shot=0; shot<burstCount; shot++)
+        {
+          shotExposures.push_back(exposureList[shot % exposureList.size()]);
+        }
+        inferenceDetails["exposureList"] = shotExposures;
+      }
+    }
+
+    /**
+      Acquiring a pooled frame for one shot of a burst, since the frame buffer of a single capture is reused per shot
+      @param frameSize size of the frame in bytes
+      @param burstCount number of frames of the burst
+      @return shared pointer to the frame, or nullptr if all pooled frames are in flight
+    */
+    std::shared_ptr<unsigned char> Capture::acquireBurstFrame(size_t frameSize, int burstCount)
+    {
+      int numBuffers = std::max(4*burstCount, 8);
+      if (!burstPool_ || burstPool_->getBufferSize()!=frameSize || burstPool_->getNumBuffers()<numBuffers)
+      {
+        burstPool_ = std::make_unique<utils::FramePool>(numBuffers, frameSize);
+      }
+      return burstPool_->acquire();
+    }
+
+    /**
+      Getting if every frame carries a pyramid of the sizes its consumers request
+      @return true if frame pyramids are enabled for this camera
+    */
+    bool Capture::getIsFramePyramid()
+    {
+      return framePyramid_;
+    }
+
+    /**
+      Attaching an empty pyramid to every frame of the message when enabled. Levels are only computed once a model,
+      sink or preview asks for its size, so consumers with the same size share one resize of the frame.
+      @param message passing by reference the message with all frames captured for a trigger
+    */
+    void Capture::attachFramePyramids(MessageCaptureInference& message)
+    {
+      message.framePyramids_.clear();
+      if (!framePyramid_)
+      {
+        return;
+      }
+
+      int pixelFormat = utils::ImagePreProcess::resolvePixelFormat(message.pixelFormat_, colorSpace_);
+      std::queue<unsigned char*> frames = message.safeCaptureContainer_;
+      for (size_t i=0; !frames.empty(); i++, frames.pop())
+      {
+        std::shared_ptr<void> owner = (i<message.safeCaptureOwnerContainer_.size()) ? message.safeCaptureOwnerContainer_[i] : nullptr;
+        message.framePyramids_.push_back(std::make_shared<utils::FramePyramid>(frames.front(), width_, height_, pixelFormat, owner));
+      }
+    }
+
+    /**
+      Attaching the regions of interest configured for the subpipeline of the message, or for the camera
+      @param message passing by reference the message with all frames captured for a trigger
+    */
+    void Capture::attachRois(MessageCaptureInference& message)
+    {
+      auto rois = subpipelineRois_.find(message.captureTrigger_.captureTriggersMessage_);
+      message.rois_ = (rois!=subpipelineRois_.end()) ? rois->second : cameraRois_;
+    }
+
     /**
       Getting the empty inference details json
       @return empty json for filling inference details
@@ -119,14 +119,8 @@ namespace edgeml
         nodemap_ = dev_->getRemoteNodeMap();
         rcg::setBoolean(nodemap_, "ChunkModeActive", true);
 
-        rcg::setInteger(nodemap_, "Height", getInputHeight());
-        rcg::setInteger(nodemap_, "Width", static_cast<int>(getInputWidth()));
-        auto height = rcg::getInteger(nodemap_, "Height");
-        auto width = rcg::getInteger(nodemap_, "Width");
-        LOG_ALWAYS("[CAPTURE::GENICAM] Using Camera ID #" + camID + " with [H,W] = [" + std::to_string((int)(height)) + "," + std::to_string((int)(width)) + "]");
-
-        setInputHeight(height);
-        setInputWidth(width);
+        setSensorGeometry();
+        LOG_ALWAYS("[CAPTURE::GENICAM] Using Camera ID #" + camID + " with [H,W] = [" + std::to_string(getInputHeight()) + "," + std::to_string(getInputWidth()) + "]");
 
         rcg::setFloat(nodemap_, "ExposureTimeAbs", exposureTime_, true); // set exposure time in microseconds
         rcg::setFloat(nodemap_, "GainRaw", (float)gainValue_, true); // set gain unit value
@@ -178,6 +172,133 @@ namespace edgeml
       }
     }
 
+    /**
+      Setting the region of interest, binning and decimation on the camera so that only the needed pixels
+      are read out and converted. The scale factor is taken from the config or negotiated from the model
+      input sizes. If the camera rejects the ROI, the full frame is read out and cropped in software.
+    */
+    void GenicamCapture::setSensorGeometry()
+    {
+      int roiX = 0, roiY = 0, roiWidth = getInputWidth(), roiHeight = getInputHeight();
+      if (getIsRoi())
+      {
+        getRoi(roiX, roiY, roiWidth, roiHeight);
+      }
+
+      int factor = std::max(getBinning(), getDecimation());
+      if (factor<=1 && getIsNegotiateSize())
+      {
+        factor = negotiateScaleFactor(roiHeight, roiWidth);
+      }
+      factor = setScaleFactor(factor);
+
+      // ROI nodes are in units of binned/decimated pixels; reset offsets first so Width/Height may grow
+      int64_t offsetX = alignNodeValue("OffsetX", roiX/factor);
+      int64_t offsetY = alignNodeValue("OffsetY", roiY/factor);
+      rcg::setInteger(nodemap_, "OffsetX", 0);
+      rcg::setInteger(nodemap_, "OffsetY", 0);
+      int64_t width = alignNodeValue("Width", roiWidth/factor);
+      int64_t height = alignNodeValue("Height", roiHeight/factor);
+      bool isRoiSet = rcg::setInteger(nodemap_, "Width", width) && rcg::setInteger(nodemap_, "Height", height);
+      if (offsetX>0 || offsetY>0)
+      {
+        isRoiSet = isRoiSet && rcg::setInteger(nodemap_, "OffsetX", offsetX) && rcg::setInteger(nodemap_, "OffsetY", offsetY);
+      }
+
+      int sensorWidth = (int)(rcg::getInteger(nodemap_, "Width"));
+      int sensorHeight = (int)(rcg::getInteger(nodemap_, "Height"));
+      softwareCrop_ = false;
+      if (getIsRoi() && (!isRoiSet || sensorWidth!=(int)(width) || sensorHeight!=(int)(height)))
+      {
+        // Camera without ROI support: read out the full frame and crop before conversion
+        rcg::setInteger(nodemap_, "OffsetX", 0);
+        rcg::setInteger(nodemap_, "OffsetY", 0);
+        int64_t vmin, vmax;
+        rcg::getInteger(nodemap_, "Width", &vmin, &vmax);
+        rcg::setInteger(nodemap_, "Width", vmax);
+        rcg::getInteger(nodemap_, "Height", &vmin, &vmax);
+        rcg::setInteger(nodemap_, "Height", vmax);
+        sensorWidth = (int)(rcg::getInteger(nodemap_, "Width"));
+        sensorHeight = (int)(rcg::getInteger(nodemap_, "Height"));
+
+        // Even offsets keep the Bayer pattern phase of the cropped image
+        cropX_ = std::min((roiX/factor) & ~1, std::max(sensorWidth-2, 0));
+        cropY_ = std::min((roiY/factor) & ~1, std::max(sensorHeight-2, 0));
+        cropWidth_ = std::min(roiWidth/factor, sensorWidth-cropX_);
+        cropHeight_ = std::min(roiHeight/factor, sensorHeight-cropY_);
+        softwareCrop_ = true;
+        LOG_ALWAYS("[CAPTURE::GENICAM] Camera does not support the requested ROI, cropping in software at [X,Y,W,H] = [" + std::to_string(cropX_) + "," + std::to_string(cropY_) + "," + std::to_string(cropWidth_) + "," + std::to_string(cropHeight_) + "]");
+
+        setInputHeight(cropHeight_);
+        setInputWidth(cropWidth_);
+        return;
+      }
+
+      if (getIsRoi())
+      {
+        LOG_ALWAYS("[CAPTURE::GENICAM] Camera ROI set to [X,Y,W,H] = [" + std::to_string((int)(rcg::getInteger(nodemap_, "OffsetX"))) + "," + std::to_string((int)(rcg::getInteger(nodemap_, "OffsetY"))) + "," + std::to_string(sensorWidth) + "," + std::to_string(sensorHeight) + "]");
+      }
+      setInputHeight(sensorHeight);
+      setInputWidth(sensorWidth);
+    }
+
+    /**
+      Setting binning on the camera, falling back to decimation if binning is not available
+      (or trying decimation first if explicitly configured)
+      @param factor requested scale factor for both directions
+      @return int scale factor applied by the camera, 1 if none
+    */
+    int GenicamCapture::setScaleFactor(int factor)
+    {
+      if (factor<=1)
+      {
+        return 1;
+      }
+
+      std::vector<std::string> modes = {"Binning", "Decimation"};
+      if (getDecimation()>1 && getBinning()<=1)
+      {
+        std::swap(modes[0], modes[1]);
+      }
+
+      for (auto& mode : modes)
+      {
+        std::string horizontal = mode + "Horizontal", vertical = mode + "Vertical";
+        if (rcg::setInteger(nodemap_, horizontal.c_str(), factor) && rcg::setInteger(nodemap_, vertical.c_str(), factor))
+        {
+          int applied = (int)(rcg::getInteger(nodemap_, horizontal.c_str()));
+          if (applied>1)
+          {
+            LOG_ALWAYS("[CAPTURE::GENICAM] " + mode + " set to " + std::to_string(applied) + "x" + std::to_string((int)(rcg::getInteger(nodemap_, vertical.c_str()))));
+            return applied;
+          }
+        }
+        rcg::setInteger(nodemap_, horizontal.c_str(), 1);
+        rcg::setInteger(nodemap_, vertical.c_str(), 1);
+      }
+
+      LOG_ALWAYS("[CAPTURE::GENICAM] Camera supports neither binning nor decimation by " + std::to_string(factor) + ", using full resolution");
+      return 1;
+    }
+
+    /**
+      Aligning a value to the increment and limits of an integer node of the camera
+      @param name name of the integer node
+      @param value requested value
+      @return int64_t closest valid value not larger than the requested one
+    */
+    int64_t GenicamCapture::alignNodeValue(const char* name, int64_t value)
+    {
+      GenApi::CIntegerPtr node = nodemap_->_GetNode(name);
+      if (!GenApi::IsReadable(node))
+      {
+        return value;
+      }
+      int64_t vmin = node->GetMin(), vmax = node->GetMax(), inc = std::max<int64_t>(node->GetInc(), 1);
+      value = std::min(std::max(value, vmin), vmax);
+      return value - (value - vmin) % inc;
+    }
+
     /**
       Getting a capture based image file getting as a bytes data. This API will be called in order to get the capture data.
       @param errc returning the error code of capture API
@@ -246,17 +367,54 @@ namespace edgeml
           continue;
         }
 
-        int errc = runCapture(frameData, frameDataSize);
-        if (errc==0)
+        int burstCount;
+        std::vector<double> exposureList;
+        getBurstPlan(message, burstCount, exposureList);
+
+        errc = CAPTURE_OK;
+        for (int shot=0; shot<burstCount && errc==CAPTURE_OK; shot++)
         {
-          forward_message.safeCaptureContainer_.push(frameData);
+          if (!exposureList.empty())
+          {
+            rcg::setFloat(nodemap_, "ExposureTimeAbs", exposureList[shot % exposureList.size()], true); // set exposure time of this shot in microseconds
+          }
+
+          // Every shot of a burst is converted into its own pooled frame
+          unsigned char* shotData = frameData;
+          std::shared_ptr<unsigned char> frame;
+          if (burstCount>1)
+          {
+            frame = acquireBurstFrame((size_t)(3) * getInputHeight() * getInputWidth(), burstCount);
+            if (!frame)
+            {
+              LOG_ERROR("[CAPTURE::GENICAM] All pooled burst frames are in flight");
+              errc = RUN_CAPTURE_ERROR;
+              break;
+            }
+            shotData = frame.get();
+            forward_message.safeCaptureOwnerContainer_.push_back(frame);
+          }
+
+          errc = runCapture(shotData, frameDataSize);
+          forward_message.safeCaptureContainer_.push(shotData);
           forward_message.safeCaptureSizeContainer_.push(frameDataSize);
+          forward_message.pixelFormat_ = PIXEL_FORMAT_RGB; // rcg::convertImage always writes RGB
+        }
+
+        if (!exposureList.empty())
+        {
+          rcg::setFloat(nodemap_, "ExposureTimeAbs", exposureTime_, true); // restore the configured exposure time
+        }
+
+        if (errc==0)
+        {
 
           LOG_ALWAYS("[CAPTURE::GENICAM] Trigger: " + message.captureTriggersMessage_);
 
           inferenceDetailsFilled = inferenceDetailsBlank;
           inferenceDetailsFilled["pipelineName"] = message.captureTriggersMessage_;
           inferenceDetailsFilled["is_inferred"] = "true";
+          setBurstDetails(inferenceDetailsFilled, burstCount, exposureList);
           forward_message.inferenceDetailsMap_ = inferenceDetailsFilled;
 
           LOG_ALWAYS("[CAPTURE::GENICAM] Successful Capture #" + std::to_string(currIter+1) + " using " << getCameraName());
@@ -268,6 +426,9 @@ namespace edgeml
           start_timeout_ = std::chrono::steady_clock::now();
           capTriggerState_ = false;
 
+          attachFramePyramids(forward_message);
+          attachRois(forward_message);
+
           // Sending message to next step in pipeline
           if(camera2forward_.find(message.captureTriggersMessage_))
           {
@@ -306,20 +467,42 @@ namespace edgeml
               if (buffer_->getImagePresent(part))
               {
                 rcg::Image image(buffer_, part);
-                height_ = (int)(image.getHeight());
-                width_ = (int)(image.getWidth());
-                frameDataSize = 3*width_*height_;
+                int imageHeight = (int)(image.getHeight());
+                int imageWidth = (int)(image.getWidth());
 
                 format_ = image.getPixelFormat();
                 yoffset_ = 0;
                 px = image.getXPadding();
-                yoffset_ = std::min(yoffset_, (size_t)(height_));
                 const unsigned char *p = static_cast<const unsigned char *>(image.getPixels());
-                std::unique_ptr<uint8_t []> rgb_pixel(new uint8_t [frameDataSize]);
-                p += (width_ + px) * yoffset_;
-                rcg::convertImage(rgb_pixel.get(), 0, p, format_, width_, height_, px); // convert to RGB pixels
 
-                memcpy(frameData, static_cast<unsigned char*>(rgb_pixel.get()), frameDataSize); // memory copy to the frameData
+                if (!softwareCrop_)
+                {
+                  height_ = imageHeight;
+                  width_ = imageWidth;
+                  frameDataSize = 3*width_*height_;
+                  rcg::convertImage(frameData, 0, p, format_, width_, height_, px); // convert to RGB pixels directly into the frameData
+                }
+                else
+                {
+                  width_ = std::min(cropWidth_, imageWidth-cropX_);
+                  height_ = std::min(cropHeight_, imageHeight-cropY_);
+                  frameDataSize = 3*width_*height_;
+                  if (((format_ >> 16) & 0xff) == 8) // 8 bits per pixel (Mono8, Bayer*8): crop before converting
+                  {
+                    size_t stride = imageWidth + px;
+                    p += stride * cropY_ + cropX_;
+                    rcg::convertImage(frameData, 0, p, format_, width_, height_, stride - width_);
+                  }
+                  else // other formats: convert the full frame and copy the cropped rows
+                  {
+                    convertBuffer_.resize((size_t)(3) * imageWidth * imageHeight);
+                    rcg::convertImage(convertBuffer_.data(), 0, p, format_, imageWidth, imageHeight, px);
+                    for (int y=0; y<height_; y++)
+                    {
+                      memcpy(frameData + (size_t)(3) * width_ * y, convertBuffer_.data() + (size_t)(3) * (imageWidth * (cropY_ + y) + cropX_), (size_t)(3) * width_);
+                    }
+                  }
+                }
               }
             }
             ret_ = CAPTURE_OK;
@@ -0,0 +1,513 @@
+/**
+ * @gstreamer_capture.cc
+ * @brief Creating and Running Capture
+ *
+ * This contains the function definitions for creating and running capture by pulling samples from a GStreamer appsink.
+ * Samples are mapped read-only and handed downstream without copying, tagged with their pixel format. The sample stays
+ * referenced until the last consumer releases the frame, so the upstream buffer pool recycles it only after that.
+ *
+ */
+
+#include <edge-ml-accelerator/capture/gstreamer_capture.h>
+
+namespace edgeml
+{
+  namespace capture
+  {
+
+    /**
+      Instance of the class
+    */
+    GstreamerCapture* GstreamerCapture::instance(utils::jsonParser::jValue j, int cameraIndex, SharedMessage<MessageT2C> &trigger2camera)
+    {
+      static GstreamerCapture* inst = 0;
+
+      if (!inst)
+      {
+        inst = new GstreamerCapture(j, cameraIndex, trigger2camera);
+      }
+      return inst;
+    }
+
+    /**
+      Creates the class constructor
+    */
+    GstreamerCapture::GstreamerCapture(utils::jsonParser::jValue j, int cameraIndex, SharedMessage<MessageT2C> &trigger2camera) : Capture(j, cameraIndex, trigger2camera)
+    {
+      pipelineDesc_ = getCamID();
+      if (jsonParams_["capture"][cameraIndex_]["poolSize"].get_type()==utils::jsonParser::JNUMBER && jsonParams_["capture"][cameraIndex_]["poolSize"].as_int()>0)
+      {
+        poolSize_ = jsonParams_["capture"][cameraIndex_]["poolSize"].as_int();
+      }
+      if (jsonParams_["capture"][cameraIndex_]["loop"].get_type()!=utils::jsonParser::JUNKNOWN)
+      {
+        loop_ = jsonParams_["capture"][cameraIndex_]["loop"].as_bool();
+      }
+      if (jsonParams_["capture"][cameraIndex_]["drop"].get_type()!=utils::jsonParser::JUNKNOWN)
+      {
+        drop_ = jsonParams_["capture"][cameraIndex_]["drop"].as_bool();
+      }
+      LOG_ALWAYS("[CAPTURE::GSTREAMER] Capture mode is set to native gstreamer appsink.");
+    }
+
+    /**
+      Creates the class destructor
+    */
+    GstreamerCapture::~GstreamerCapture()
+    {
+      if (pipeline_)
+      {
+        gst_element_set_state(pipeline_, GST_STATE_NULL);
+      }
+      if (appsink_)
+      {
+        gst_object_unref(appsink_);
+      }
+      if (pipeline_)
+      {
+        gst_object_unref(pipeline_);
+      }
+    }
+
+    /**
+      Getting the appsink of the pipeline, either named "edgemlsink" or the first appsink found
+      @return referenced appsink element or nullptr if the pipeline has none
+    */
+    GstElement* GstreamerCapture::findAppSink()
+    {
+      GstElement* sink = gst_bin_get_by_name(GST_BIN(pipeline_), "edgemlsink");
+      if (sink)
+      {
+        return sink;
+      }
+
+      GstIterator* it = gst_bin_iterate_sinks(GST_BIN(pipeline_));
+      GValue item = G_VALUE_INIT;
+      while (!sink && gst_iterator_next(it, &item)==GST_ITERATOR_OK)
+      {
+        GstElement* element = GST_ELEMENT(g_value_get_object(&item));
+        if (GST_IS_APP_SINK(element))
+        {
+          sink = GST_ELEMENT(gst_object_ref(element));
+        }
+        g_value_reset(&item);
+      }
+      g_value_unset(&item);
+      gst_iterator_free(it);
+      return sink;
+    }
+
+    /**
+      Launching the GStreamer pipeline given as serialNumber and prerolling it to get the negotiated frame size
+      @return error-code showing if the capture object was created or not
+    */
+    int GstreamerCapture::initCapture(int cameraIndex)
+    {
+      inferenceDetailsBlank = getInferenceDetailsJson();
+      colorSpace_ = getColorSpace();
+
+      gst_init(nullptr, nullptr);
+
+      // A pipeline description without any appsink gets one appended
+      if (pipelineDesc_.find("appsink")==std::string::npos)
+      {
+        pipelineDesc_ += " ! appsink name=edgemlsink";
+      }
+      LOG_ALWAYS("[CAPTURE::GSTREAMER] GStreamer Pipeline selected is: [" + pipelineDesc_ + "]");
+
+      GError* error = nullptr;
+      pipeline_ = gst_parse_launch(pipelineDesc_.c_str(), &error);
+      if (error)
+      {
+        LOG_ERROR("[CAPTURE::GSTREAMER] Cannot parse pipeline: " + std::string(error->message));
+        g_error_free(error);
+        if (pipeline_)
+        {
+          gst_object_unref(pipeline_);
+          pipeline_ = nullptr;
+        }
+        return CAMERA_MISSING;
+      }
+
+      appsink_ = findAppSink();
+      if (!appsink_)
+      {
+        LOG_ERROR("[CAPTURE::GSTREAMER] Pipeline has no appsink");
+        return CAMERA_MISSING;
+      }
+
+      // Restrict the caps to the raw formats handled here unless the pipeline already restricts them
+      GstCaps* sinkCaps = gst_app_sink_get_caps(GST_APP_SINK(appsink_));
+      if (!sinkCaps)
+      {
+        sinkCaps = gst_caps_from_string("video/x-raw, format=(string){ RGB, BGR, NV12, I420, GRAY8 }");
+        gst_app_sink_set_caps(GST_APP_SINK(appsink_), sinkCaps);
+      }
+      gst_caps_unref(sinkCaps);
+
+      // Frames are pulled on trigger, so only the newest few are kept and no clock sync is needed
+      g_object_set(G_OBJECT(appsink_), "sync", FALSE, "emit-signals", FALSE, "max-buffers", (guint)(poolSize_), "drop", (gboolean)(drop_), NULL);
+
+      if (gst_element_set_state(pipeline_, GST_STATE_PLAYING)==GST_STATE_CHANGE_FAILURE)
+      {
+        LOG_ERROR("[CAPTURE::GSTREAMER] Cannot set pipeline to playing");
+        return CAMERA_MISSING;
+      }
+
+      GstSample* preroll = gst_app_sink_try_pull_preroll(GST_APP_SINK(appsink_), pullTimeout_);
+      if (!preroll)
+      {
+        LOG_ERROR("[CAPTURE::GSTREAMER] Pipeline did not preroll");
+        return CAMERA_MISSING;
+      }
+      GstVideoInfo info;
+      bool isInfo = gst_video_info_from_caps(&info, gst_sample_get_caps(preroll));
+      gst_sample_unref(preroll);
+      if (!isInfo)
+      {
+        LOG_ERROR("[CAPTURE::GSTREAMER] Cannot read caps of the appsink");
+        return CAMERA_MISSING;
+      }
+
+      setInputHeight(GST_VIDEO_INFO_HEIGHT(&info));
+      setInputWidth(GST_VIDEO_INFO_WIDTH(&info));
+      height_ = getInputHeight();
+      width_ = getInputWidth();
+
+      LOG_ALWAYS("[CAPTURE::GSTREAMER] " + std::string(CaptureTypesE[GSTREAMERMODE]) + " has [H,W] = [" + std::to_string((int)(height_)) + "," + std::to_string((int)(width_)) + "] with format " + std::string(GST_VIDEO_INFO_NAME(&info)));
+
+      return CAPTURE_OK;
+    }
+
+    /**
+      Getting a capture from the appsink as a bytes data. This API will be called in order to get the capture data.
+      @param errc returning the error code of capture API
+      @param frameData passing by reference to get the frame data as unsigned char array
+      @param frameDataSize passing by reference to get the size of the frame data in the form of HxWxC
+      @param iter running for total iterations if > 0 else running infinite loop
+    */
+    void GstreamerCapture::getCapture(int& errc, unsigned char*& frameData, int& frameDataSize, int& iter)
+    {
+      getCaptureAtIndex(errc, frameData, frameDataSize, iter, 0);
+    }
+
+    void GstreamerCapture::getCaptureAtIndex(int& errc, unsigned char*& frameData, int& frameDataSize, int& iter, int cameraIndex)
+    {
+      int currIter = 0;
+      while(1)
+      {
+        if (iter>0)
+        {
+          if (currIter>iter)
+          {
+            break;
+          }
+        }
+        currIter++;
+
+        // Wait for message
+        auto message = trigger2camera_.GetMessage();
+        LOG_ALWAYS("[CAPTURE::GSTREAMER] Trigger to Camera Message = " + message.captureTriggersMessage_);
+
+        message.captureTriggersMessageFull_["captureID"] = "#" + std::to_string(currIter);
+
+        // Create a message forward with local scope
+        MessageCaptureInference forward_message;
+        forward_message.captureTrigger_ = message;
+        forward_message.cameraName_ = cameraName_;
+
+        capture_start_time_ = std::chrono::steady_clock::now();
+
+        // check if it's an active pipeline
+        if(!camera2forward_.find(forward_message.captureTrigger_.captureTriggersMessage_))
+        {
+          LOG_ALWAYS("[CAPTURE::GSTREAMER] Command Pipeline NOT available ");
+          continue;
+        }
+
+        if (message.captureTriggersMessage_ == "configchange")
+        {
+          LOG_ALWAYS("[CAPTURE::GSTREAMER] Changing Config based on following: ");
+          LOG_ALWAYS(std::string(message.captureTriggersMessageFull_.dump()));
+
+          LOG_ALWAYS("[CAPTURE::GSTREAMER] Cannot make changes for GStreamer Cameras");
+          continue;
+        }
+
+        // A burst takes consecutive samples, exposures cannot be set on a generic pipeline
+        int burstCount;
+        std::vector<double> exposureList;
+        getBurstPlan(message, burstCount, exposureList);
+
+        for (int shot=0; shot<burstCount; shot++)
+        {
+          std::shared_ptr<void> owner;
+          PixelFormat pixelFormat;
+          errc = runCapture(owner, frameData, frameDataSize, pixelFormat, shot==0);
+          if (errc!=CAPTURE_OK)
+          {
+            break;
+          }
+
+          forward_message.safeCaptureContainer_.push(frameData);
+          forward_message.safeCaptureSizeContainer_.push(frameDataSize);
+          forward_message.safeCaptureOwnerContainer_.push_back(owner);
+          forward_message.pixelFormat_ = pixelFormat;
+        }
+
+        if (errc!=CAPTURE_OK)
+        {
+          LOG_ALWAYS("[CAPTURE::GSTREAMER] ERROR READING IMAGES");
+          continue;
+        }
+
+        LOG_ALWAYS("[CAPTURE::GSTREAMER] Trigger: " + message.captureTriggersMessage_);
+
+        inferenceDetailsFilled = inferenceDetailsBlank;
+        inferenceDetailsFilled["pipelineName"] = message.captureTriggersMessage_;
+        inferenceDetailsFilled["is_inferred"] = "true";
+        setBurstDetails(inferenceDetailsFilled, burstCount, exposureList);
+        forward_message.inferenceDetailsMap_ = inferenceDetailsFilled;
+
+        LOG_ALWAYS("[CAPTURE::GSTREAMER] Successful Capture #" + std::to_string(currIter+1) + " using " + getCameraName());
+
+        capture_end_time_ = std::chrono::steady_clock::now();
+        capture_elapsed_seconds_ = capture_end_time_ - capture_start_time_;
+        LOG_ALWAYS("[CAPTURE::GSTREAMER] Capture Elapsed Time: " + std::to_string(capture_elapsed_seconds_.count()) + " seconds.");
+
+        attachFramePyramids(forward_message);
+        attachRois(forward_message);
+
+        // Sending message to next step in pipeline
+        if(camera2forward_.find(message.captureTriggersMessage_))
+        {
+          LOG_ALWAYS("[CAPTURE::GSTREAMER] Sending message forward");
+          camera2forward_.produce_message(message.captureTriggersMessage_, forward_message);
+        }
+      }
+    }
+
+    /**
+      Pulling a sample from the appsink and mapping it read-only. Tightly packed frames are passed on as the mapped
+      memory in their own pixel format; frames with padded rows or planes are converted once into a pooled frame.
+      @param owner passing by reference to get the handle keeping the frame memory alive
+      @param frameData passing by reference to get the frame data as unsigned char array
+      @param frameDataSize passing by reference to get the size of the frame data
+      @param pixelFormat passing by reference to get the pixel format of the frame data
+      @param newest true to skip the samples queued before the trigger when dropping old samples
+      @return error-code showing if a frame was captured or not
+    */
+    int GstreamerCapture::runCapture(std::shared_ptr<void>& owner, unsigned char*& frameData, int& frameDataSize, PixelFormat& pixelFormat, bool newest)
+    {
+      // The appsink keeps up to poolSize samples from before the trigger, only the last of them is current
+      GstSample* sample = nullptr;
+      if (newest && drop_)
+      {
+        int skipped = 0;
+        while (GstSample* next = gst_app_sink_try_pull_sample(GST_APP_SINK(appsink_), 0))
+        {
+          if (sample)
+          {
+            gst_sample_unref(sample);
+            skipped++;
+          }
+          sample = next;
+        }
+        if (skipped>0)
+        {
+          LOG_ALWAYS("[CAPTURE::GSTREAMER] Skipped " + std::to_string(skipped) + " sample(s) queued before the trigger");
+        }
+      }
+      if (!sample)
+      {
+        sample = gst_app_sink_try_pull_sample(GST_APP_SINK(appsink_), pullTimeout_);
+      }
+      if (!sample && gst_app_sink_is_eos(GST_APP_SINK(appsink_)) && loop_)
+      {
+        LOG_ALWAYS("[CAPTURE::GSTREAMER] End of stream, restarting from the beginning");
+        gst_element_seek_simple(pipeline_, GST_FORMAT_TIME, (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT), 0);
+        sample = gst_app_sink_try_pull_sample(GST_APP_SINK(appsink_), pullTimeout_);
+      }
+      if (!sample)
+      {
+        LOG_ERROR("[CAPTURE::GSTREAMER] Cannot pull sample from appsink");
+        return RUN_CAPTURE_ERROR;
+      }
+
+      GstVideoInfo info;
+      GstBuffer* buffer = gst_sample_get_buffer(sample);
+      if (!buffer || !gst_video_info_from_caps(&info, gst_sample_get_caps(sample)))
+      {
+        LOG_ERROR("[CAPTURE::GSTREAMER] Sample without buffer or video caps");
+        gst_sample_unref(sample);
+        return RUN_CAPTURE_ERROR;
+      }
+
+      struct MappedSample
+      {
+        GstSample* sample;
+        GstBuffer* buffer;
+        GstMapInfo map;
+      };
+      MappedSample* mapped = new MappedSample{sample, buffer, GstMapInfo()};
+      if (!gst_buffer_map(buffer, &mapped->map, GST_MAP_READ))
+      {
+        LOG_ERROR("[CAPTURE::GSTREAMER] Cannot map buffer");
+        gst_sample_unref(sample);
+        delete mapped;
+        return RUN_CAPTURE_ERROR;
+      }
+
+      height_ = GST_VIDEO_INFO_HEIGHT(&info);
+      width_ = GST_VIDEO_INFO_WIDTH(&info);
+
+      // Frames keep their own format if they are laid out the way downstream stages expect
+      bool isPacked = false;
+      size_t lumaSize = (size_t)(width_) * height_;
+      switch (GST_VIDEO_INFO_FORMAT(&info))
+      {
+        case GST_VIDEO_FORMAT_RGB:
+        case GST_VIDEO_FORMAT_BGR:
+          pixelFormat = (GST_VIDEO_INFO_FORMAT(&info)==GST_VIDEO_FORMAT_RGB) ? PIXEL_FORMAT_RGB : PIXEL_FORMAT_BGR;
+          isPacked = GST_VIDEO_INFO_PLANE_STRIDE(&info, 0)==3*width_;
+          break;
+        case GST_VIDEO_FORMAT_GRAY8:
+          pixelFormat = PIXEL_FORMAT_GRAY;
+          isPacked = GST_VIDEO_INFO_PLANE_STRIDE(&info, 0)==width_;
+          break;
+        case GST_VIDEO_FORMAT_NV12:
+          pixelFormat = PIXEL_FORMAT_NV12;
+          isPacked = width_%2==0 && height_%2==0 && GST_VIDEO_INFO_PLANE_STRIDE(&info, 0)==width_ && GST_VIDEO_INFO_PLANE_STRIDE(&info, 1)==width_
+            && GST_VIDEO_INFO_PLANE_OFFSET(&info, 1)==lumaSize;
+          break;
+        case GST_VIDEO_FORMAT_I420:
+          pixelFormat = PIXEL_FORMAT_I420;
+          isPacked = width_%2==0 && height_%2==0 && GST_VIDEO_INFO_PLANE_STRIDE(&info, 0)==width_ && GST_VIDEO_INFO_PLANE_STRIDE(&info, 1)==width_/2
+            && GST_VIDEO_INFO_PLANE_OFFSET(&info, 1)==lumaSize && GST_VIDEO_INFO_PLANE_OFFSET(&info, 2)==lumaSize + lumaSize/4;
+          break;
+        default:
+          break;
+      }
+      isPacked = isPacked && GST_VIDEO_INFO_PLANE_OFFSET(&info, 0)==0;
+
+      if (isPacked)
+      {
+        // Zero copy: the mapped memory is the frame, released with the sample by the last consumer
+        frameData = mapped->map.data;
+        frameDataSize = utils::ImagePreProcess::getFrameSize(width_, height_, pixelFormat);
+        owner = std::shared_ptr<void>(mapped, [](void* p)
+        {
+          MappedSample* m = static_cast<MappedSample*>(p);
+          gst_buffer_unmap(m->buffer, &m->map);
+          gst_sample_unref(m->sample);
+          delete m;
+        });
+        return CAPTURE_OK;
+      }
+
+      pixelFormat = (colorSpace_=="BGR") ? PIXEL_FORMAT_BGR : PIXEL_FORMAT_RGB;
+      frameDataSize = 3 * width_ * height_;
+
+      // Other formats are converted straight from the mapped memory into a pooled frame
+      if (!framePool_ || framePool_->getBufferSize()!=(size_t)(frameDataSize))
+      {
+        framePool_ = std::make_unique<utils::FramePool>(poolSize_, (size_t)(frameDataSize));
+      }
+      std::shared_ptr<unsigned char> frame = framePool_->acquire();
+      int ret = RUN_CAPTURE_ERROR;
+      if (frame)
+      {
+        ret = convertFrame(info, mapped->map, frame.get());
+      }
+      else
+      {
+        droppedFrames_++;
+        LOG_ALWAYS("[CAPTURE::GSTREAMER] All pooled frames are in flight, dropping frame (" + std::to_string(droppedFrames_) + " dropped so far)");
+      }
+      gst_buffer_unmap(buffer, &mapped->map);
+      gst_sample_unref(sample);
+      delete mapped;
+
+      if (ret==CAPTURE_OK)
+      {
+        frameData = frame.get();
+        owner = frame;
+      }
+      return ret;
+    }
+
+    /**
+      Converting a mapped NV12, I420, GRAY8, RGB or BGR frame with padded rows into the configured color space
+      @param info video info of the sample
+      @param map mapped buffer of the sample
+      @param frameData buffer of size HxWx3 to write into
+      @return error-code showing if the frame was converted or not
+    */
+    int GstreamerCapture::convertFrame(GstVideoInfo& info, GstMapInfo& map, unsigned char* frameData)
+    {
+      bool isBGR = (colorSpace_=="BGR");
+      cv::Mat dst(height_, width_, CV_8UC3, (void*)(frameData));
+      auto plane = [&](int index, int rows, int cols, int type)
+      {
+        return cv::Mat(rows, cols, type, (void*)(map.data + GST_VIDEO_INFO_PLANE_OFFSET(&info, index)), GST_VIDEO_INFO_PLANE_STRIDE(&info, index));
+      };
+
+      switch (GST_VIDEO_INFO_FORMAT(&info))
+      {
+        case GST_VIDEO_FORMAT_RGB:
+        case GST_VIDEO_FORMAT_BGR:
+        {
+          cv::Mat src = plane(0, height_, width_, CV_8UC3);
+          bool isSame = (GST_VIDEO_INFO_FORMAT(&info)==GST_VIDEO_FORMAT_BGR)==isBGR;
+          if (isSame)
+          {
+            src.copyTo(dst); // only for padded rows
+          }
+          else
+          {
+            cv::cvtColor(src, dst, cv::COLOR_RGB2BGR);
+          }
+          break;
+        }
+        case GST_VIDEO_FORMAT_NV12:
+        {
+          cv::cvtColorTwoPlane(plane(0, height_, width_, CV_8UC1), plane(1, height_/2, width_/2, CV_8UC2), dst, isBGR ? cv::COLOR_YUV2BGR_NV12 : cv::COLOR_YUV2RGB_NV12);
+          break;
+        }
+        case GST_VIDEO_FORMAT_I420:
+        {
+          // OpenCV takes I420 as one contiguous single channel image, so repack only if the planes are padded
+          size_t ySize = (size_t)(width_) * height_;
+          bool isContiguous = GST_VIDEO_INFO_PLANE_STRIDE(&info, 0)==width_ && GST_VIDEO_INFO_PLANE_STRIDE(&info, 1)==width_/2
+            && GST_VIDEO_INFO_PLANE_OFFSET(&info, 1)==ySize && GST_VIDEO_INFO_PLANE_OFFSET(&info, 2)==ySize + ySize/4;
+          cv::Mat yuv;
+          if (isContiguous)
+          {
+            yuv = cv::Mat(height_ * 3 / 2, width_, CV_8UC1, (void*)(map.data));
+          }
+          else
+          {
+            yuv.create(height_ * 3 / 2, width_, CV_8UC1);
+            plane(0, height_, width_, CV_8UC1).copyTo(yuv.rowRange(0, height_));
+            plane(1, height_/2, width_/2, CV_8UC1).copyTo(cv::Mat(height_/2, width_/2, CV_8UC1, yuv.ptr(height_)));
+            plane(2, height_/2, width_/2, CV_8UC1).copyTo(cv::Mat(height_/2, width_/2, CV_8UC1, yuv.ptr(height_) + ySize/4));
+          }
+          cv::cvtColor(yuv, dst, isBGR ? cv::COLOR_YUV2BGR_I420 : cv::COLOR_YUV2RGB_I420);
+          break;
+        }
+        case GST_VIDEO_FORMAT_GRAY8:
+        {
+          cv::cvtColor(plane(0, height_, width_, CV_8UC1), dst, cv::COLOR_GRAY2BGR);
+          break;
+        }
+        default:
+        {
+          LOG_ERROR("[CAPTURE::GSTREAMER] Unsupported format " + std::string(GST_VIDEO_INFO_NAME(&info)));
+          return RUN_CAPTURE_ERROR;
+        }
+      }
+      return CAPTURE_OK;
+    }
+
+  }
+}
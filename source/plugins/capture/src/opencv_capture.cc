@@ -211,6 +211,21 @@ namespace edgeml
           break;
       }
 
+      // OpenCV sources have no sensor ROI, so the configured roi is cropped in software before any resize
+      if (getIsRoi())
+      {
+        int roiX, roiY, roiWidth, roiHeight;
+        getRoi(roiX, roiY, roiWidth, roiHeight);
+        cropRect_ = cv::Rect(roiX, roiY, roiWidth, roiHeight) & cv::Rect(0, 0, getInputWidth(), getInputHeight());
+        isCrop_ = !cropRect_.empty();
+        if (isCrop_)
+        {
+          LOG_ALWAYS("[CAPTURE::OPENCV] Cropping in software at [X,Y,W,H] = [" + std::to_string(cropRect_.x) + "," + std::to_string(cropRect_.y) + "," + std::to_string(cropRect_.width) + "," + std::to_string(cropRect_.height) + "]");
+          setInputHeight(cropRect_.height);
+          setInputWidth(cropRect_.width);
+        }
+      }
+
       height_ = getInputHeight();
       width_ = getInputWidth();
       resizeHeight_ = getResizeInputHeight();
@@ -289,43 +304,82 @@ namespace edgeml
           continue;
         }
 
-        errc = runCapture();
+        int burstCount;
+        std::vector<double> exposureList;
+        getBurstPlan(message, burstCount, exposureList);
+        double exposureBefore = cap_.get(cv::CAP_PROP_EXPOSURE);
 
-        if (errc!=CAPTURE_OK)
+        for (int shot=0; shot<burstCount; shot++)
         {
-          LOG_ALWAYS("[CAPTURE::OPENCV] ERROR READING IMAGES");
-          continue;
-        }
+          if (!exposureList.empty() && captureModeInt_==CAMERAMODE)
+          {
+            cap_.set(cv::CAP_PROP_EXPOSURE, exposureList[shot % exposureList.size()]);
+          }
 
-        if (isResize_)
-        {
-          cv::resize(frame_, frame_resized_, cv::Size(resizeWidth_, resizeHeight_));
-          LOG_ALWAYS("[CAPTURE::OPENCV] Resized image to [H,W] = [" + std::to_string((int)(frame_resized_.rows)) + "," + std::to_string((int)(frame_resized_.cols)) + "]");
+          errc = runCapture();
+
+          if (errc!=CAPTURE_OK)
+          {
+            break;
+          }
+
+          cv::Mat frameRoi = isCrop_ ? frame_(cropRect_ & cv::Rect(0, 0, frame_.cols, frame_.rows)) : frame_;
+          if (isResize_)
+          {
+            cv::resize(frameRoi, frame_resized_, cv::Size(resizeWidth_, resizeHeight_));
+            LOG_ALWAYS("[CAPTURE::OPENCV] Resized image to [H,W] = [" + std::to_string((int)(frame_resized_.rows)) + "," + std::to_string((int)(frame_resized_.cols)) + "]");
+          }
+          else if (isCrop_)
+          {
+            frameRoi.copyTo(frame_resized_); // the cropped rows have to be contiguous for downstream stages
+          }
+          else
+          {
+            frame_resized_ = frame_;
+          }
+
+          frameData = (unsigned char*)(frame_resized_.data);
+          frameDataSize = frame_resized_.total() * frame_resized_.elemSize();
+
+          // Every shot of a burst needs its own frame as frame_resized_ is reused for the next shot
+          if (burstCount>1)
+          {
+            std::shared_ptr<unsigned char> frame = acquireBurstFrame(frameDataSize, burstCount);
+            if (!frame)
+            {
+              LOG_ERROR("[CAPTURE::OPENCV] All pooled burst frames are in flight");
+              errc = RUN_CAPTURE_ERROR;
+              break;
+            }
+            memcpy(frame.get(), frameData, frameDataSize);
+            frameData = frame.get();
+            forward_message.safeCaptureOwnerContainer_.push_back(frame);
+          }
+
+          forward_message.safeCaptureContainer_.push(frameData);
+          forward_message.safeCaptureSizeContainer_.push(frameDataSize);
+          forward_message.pixelFormat_ = PIXEL_FORMAT_BGR; // OpenCV frames stay BGR, consumers convert only if they need to
         }
-        else
+
+        if (!exposureList.empty() && captureModeInt_==CAMERAMODE)
         {
-          frame_resized_ = frame_;
+          cap_.set(cv::CAP_PROP_EXPOSURE, exposureBefore);
         }
 
-        //todo get rid of bgr, just rgb from now on
-        if (colorSpace_=="RGB")
+        if (errc!=CAPTURE_OK)
         {
-          cv::cvtColor(frame_resized_, frame_resized_, cv::COLOR_BGR2RGB);
+          LOG_ALWAYS("[CAPTURE::OPENCV] ERROR READING IMAGES");
+          continue;
         }
 
-        frameData = (unsigned char*)(frame_resized_.data);
-        frameDataSize = frame_resized_.total() * frame_resized_.elemSize();
-
         if (errc==0)
         {
-          forward_message.safeCaptureContainer_.push(frameData);
-          forward_message.safeCaptureSizeContainer_.push(frameDataSize);
-
           LOG_ALWAYS("[CAPTURE::OPENCV] Trigger: " + message.captureTriggersMessage_);
 
           inferenceDetailsFilled = inferenceDetailsBlank;
           inferenceDetailsFilled["pipelineName"] = message.captureTriggersMessage_;
           inferenceDetailsFilled["is_inferred"] = "true";
+          setBurstDetails(inferenceDetailsFilled, burstCount, exposureList);
           forward_message.inferenceDetailsMap_ = inferenceDetailsFilled;
 
           LOG_ALWAYS("[CAPTURE::OPENCV] Successful Capture #" + std::to_string(currIter+1) + " for camera");
@@ -337,6 +391,9 @@ namespace edgeml
           start_timeout_ = std::chrono::steady_clock::now();
           capTriggerState_ = false;
 
+          attachFramePyramids(forward_message);
+          attachRois(forward_message);
+
           // Sending message to next step in pipeline
           if(camera2forward_.find(message.captureTriggersMessage_))
           {
@@ -204,17 +204,58 @@ namespace edgeml
           continue;
         }
 
-        int errc = runCapture(frameData, frameDataSize);
-        if (errc==0)
+        int burstCount;
+        std::vector<double> exposureList;
+        getBurstPlan(message, burstCount, exposureList);
+        GenApi::CFloatPtr exposure(camera_.GetNodeMap().GetNode("ExposureTimeAbs"));
+
+        errc = CAPTURE_OK;
+        for (int shot=0; shot<burstCount && errc==CAPTURE_OK; shot++)
         {
+          if (!exposureList.empty())
+          {
+            exposure->SetValue((float)(exposureList[shot % exposureList.size()])); // set exposure time of this shot in microseconds
+          }
+
+          errc = runCapture(frameData, frameDataSize);
+          if (errc!=CAPTURE_OK)
+          {
+            break;
+          }
+
+          // Every shot of a burst needs its own frame as the converted image is reused for the next shot
+          if (burstCount>1)
+          {
+            std::shared_ptr<unsigned char> frame = acquireBurstFrame(frameDataSize, burstCount);
+            if (!frame)
+            {
+              LOG_ERROR("[CAPTURE::PYLON] All pooled burst frames are in flight");
+              errc = RUN_CAPTURE_ERROR;
+              break;
+            }
+            memcpy(frame.get(), frameData, frameDataSize);
+            frameData = frame.get();
+            forward_message.safeCaptureOwnerContainer_.push_back(frame);
+          }
           forward_message.safeCaptureContainer_.push(frameData);
           forward_message.safeCaptureSizeContainer_.push(frameDataSize);
+          forward_message.pixelFormat_ = PIXEL_FORMAT_RGB; // converted to RGB8packed
+        }
+
+        if (!exposureList.empty())
+        {
+          exposure->SetValue((float)(exposureTime_)); // restore the configured exposure time
+        }
+
+        if (errc==0)
+        {
 
           LOG_ALWAYS("[CAPTURE::PYLON] Trigger: " + message.captureTriggersMessage_);
 
           inferenceDetailsFilled = inferenceDetailsBlank;
           inferenceDetailsFilled["pipelineName"] = message.captureTriggersMessage_;
           inferenceDetailsFilled["is_inferred"] = "true";
+          setBurstDetails(inferenceDetailsFilled, burstCount, exposureList);
           forward_message.inferenceDetailsMap_ = inferenceDetailsFilled;
 
           LOG_ALWAYS("[CAPTURE::PYLON] Successful Capture #" + std::to_string(currIter+1) + " using " + getCameraName());
@@ -226,6 +267,9 @@ namespace edgeml
           start_timeout_ = std::chrono::steady_clock::now();
           capTriggerState_ = false;
 
+          attachFramePyramids(forward_message);
+          attachRois(forward_message);
+
           // Sending message to next step in pipeline
           if(camera2forward_.find(message.captureTriggersMessage_))
           {
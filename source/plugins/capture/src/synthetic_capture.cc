@@ -0,0 +1,333 @@
+/**
+ * @synthetic_capture.cc
+ * @brief Creating and Running Capture
+ *
+ * This contains the function definitions for creating and running a synthetic capture.
+ * Frames are rendered once into a pool of buffers at init and handed out per trigger,
+ * so generating a frame costs no more than acquiring a pooled buffer.
+ *
+ */
+
+#include <edge-ml-accelerator/capture/synthetic_capture.h>
+
+namespace edgeml
+{
+  namespace capture
+  {
+
+    /**
+      Instance of the class
+    */
+    SyntheticCapture* SyntheticCapture::instance(utils::jsonParser::jValue j, int cameraIndex, SharedMessage<MessageT2C> &trigger2camera)
+    {
+      static SyntheticCapture* inst = 0;
+
+      if (!inst)
+      {
+        inst = new SyntheticCapture(j, cameraIndex, trigger2camera);
+      }
+      return inst;
+    }
+
+    /**
+      Creates the class constructor
+    */
+    SyntheticCapture::SyntheticCapture(utils::jsonParser::jValue j, int cameraIndex, SharedMessage<MessageT2C> &trigger2camera) : Capture(j, cameraIndex, trigger2camera)
+    {
+      patternName_ = jsonParams_["capture"][cameraIndex_]["syntheticPattern"].as_string();
+      if (patternName_=="NOISE")
+      {
+        pattern_ = NOISE;
+      }
+      else if (patternName_=="TEMPLATE")
+      {
+        pattern_ = TEMPLATE;
+        templateFile_ = jsonParams_["capture"][cameraIndex_]["imageIn"].as_string();
+      }
+      else
+      {
+        patternName_ = "GRADIENT";
+        pattern_ = GRADIENT;
+      }
+
+      if (jsonParams_["capture"][cameraIndex_]["poolSize"].get_type()==utils::jsonParser::JNUMBER && jsonParams_["capture"][cameraIndex_]["poolSize"].as_int()>0)
+      {
+        poolSize_ = jsonParams_["capture"][cameraIndex_]["poolSize"].as_int();
+      }
+
+      frameRate_ = (jsonParams_["capture"][cameraIndex_]["frameRate"].get_type()==utils::jsonParser::JNUMBER) ? jsonParams_["capture"][cameraIndex_]["frameRate"].as_double() : 0.0;
+      if (frameRate_>0)
+      {
+        framePeriod_ = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0/frameRate_));
+      }
+
+      LOG_ALWAYS("[CAPTURE::SYNTHETIC] Capture mode is set to synthetic with pattern " + patternName_ + ".");
+    }
+
+    /**
+      Creates the class destructor
+    */
+    SyntheticCapture::~SyntheticCapture()
+    {
+    }
+
+    /**
+      Allocating the frame pool and rendering the configured pattern into every buffer
+      @return error-code showing if the frames could be generated or not
+    */
+    int SyntheticCapture::initCapture(int cameraIndex)
+    {
+      inferenceDetailsBlank = getInferenceDetailsJson();
+      colorSpace_ = getColorSpace();
+
+      // Frames are generated directly at the size the downstream stages expect, so no resize is needed
+      if (getResizeInputHeight()>0 && getResizeInputWidth()>0)
+      {
+        setInputHeight(getResizeInputHeight());
+        setInputWidth(getResizeInputWidth());
+      }
+      height_ = getInputHeight();
+      width_ = getInputWidth();
+
+      framePool_ = std::make_unique<utils::FramePool>(poolSize_, (size_t)(height_) * width_ * channels_);
+      for (int i=0; i<framePool_->getNumBuffers(); i++)
+      {
+        int ret = renderFrame(framePool_->getBuffer(i), i);
+        if (ret!=CAPTURE_OK)
+        {
+          LOG_ERROR("[CAPTURE::SYNTHETIC] Could not render synthetic frame #" + std::to_string(i));
+          return ret;
+        }
+      }
+
+      LOG_ALWAYS("[CAPTURE::SYNTHETIC] " + std::string(CaptureTypesE[SYNTHETICMODE]) + " has [H,W] = [" + std::to_string((int)(height_)) + "," + std::to_string((int)(width_)) + "] with " + std::to_string(poolSize_) + " pooled frames");
+      if (frameRate_>0)
+      {
+        LOG_ALWAYS("[CAPTURE::SYNTHETIC] Frame rate is limited to " + std::to_string(frameRate_) + " fps");
+      }
+
+      return CAPTURE_OK;
+    }
+
+    /**
+      Rendering the configured pattern into a frame buffer. Every buffer gets a different variant
+      of the pattern so consecutive frames differ.
+      @param frameData buffer of size HxWxC to render into
+      @param frameIndex index of the buffer in the pool
+      @return error-code showing if the frame was rendered or not
+    */
+    int SyntheticCapture::renderFrame(unsigned char* frameData, int frameIndex)
+    {
+      cv::Mat frame(cv::Size(width_, height_), CV_8UC3, (void*)(frameData));
+      bool isBGR = (colorSpace_=="BGR");
+      bool isGray = (colorSpace_=="GRAY" || colorSpace_=="MONO8");
+
+      switch (pattern_)
+      {
+        case GRADIENT:
+        {
+          unsigned char shift = (unsigned char)((frameIndex * 256) / std::max(poolSize_, 1));
+          for (int y=0; y<height_; y++)
+          {
+            unsigned char* row = frame.ptr<unsigned char>(y);
+            unsigned char g = (unsigned char)((y * 255) / std::max(height_-1, 1));
+            for (int x=0; x<width_; x++)
+            {
+              unsigned char r = (unsigned char)(((x * 255) / std::max(width_-1, 1) + shift) & 0xff);
+              unsigned char gx = isGray ? r : g;
+              unsigned char bx = isGray ? r : shift;
+              row[3*x + 0] = isBGR ? bx : r;
+              row[3*x + 1] = gx;
+              row[3*x + 2] = isBGR ? r : bx;
+            }
+          }
+          break;
+        }
+        case NOISE:
+        {
+          std::mt19937 rng(frameIndex + 1);
+          size_t frameSize = (size_t)(height_) * width_ * channels_;
+          if (isGray)
+          {
+            for (size_t i=0; i<frameSize; i+=3)
+            {
+              unsigned char v = (unsigned char)(rng() & 0xff);
+              frameData[i] = v; frameData[i+1] = v; frameData[i+2] = v;
+            }
+          }
+          else
+          {
+            for (size_t i=0; i<frameSize; i++)
+            {
+              frameData[i] = (unsigned char)(rng() & 0xff);
+            }
+          }
+          break;
+        }
+        case TEMPLATE:
+        {
+          cv::Mat tile = cv::imread(templateFile_);
+          if (tile.empty())
+          {
+            LOG_ERROR("[CAPTURE::SYNTHETIC] Template image is missing: " + templateFile_);
+            return IMAGE_FILE_MISSING;
+          }
+          if (isGray)
+          {
+            cv::cvtColor(tile, tile, cv::COLOR_BGR2GRAY);
+            cv::cvtColor(tile, tile, cv::COLOR_GRAY2BGR);
+          }
+          else if (!isBGR)
+          {
+            cv::cvtColor(tile, tile, cv::COLOR_BGR2RGB);
+          }
+
+          // Shift the tiling per buffer so consecutive frames differ
+          int offsetX = (frameIndex * tile.cols) / std::max(poolSize_, 1);
+          for (int y=0; y<height_; y+=tile.rows)
+          {
+            for (int x=-offsetX; x<width_; x+=tile.cols)
+            {
+              int srcX = std::max(-x, 0);
+              int dstX = std::max(x, 0);
+              int w = std::min(tile.cols - srcX, width_ - dstX);
+              int h = std::min(tile.rows, height_ - y);
+              if (w<=0 || h<=0) continue;
+              tile(cv::Rect(srcX, 0, w, h)).copyTo(frame(cv::Rect(dstX, y, w, h)));
+            }
+          }
+          break;
+        }
+        default:
+        {
+          return RUN_CAPTURE_ERROR;
+        }
+      }
+      return CAPTURE_OK;
+    }
+
+    /**
+      Getting a generated frame as a bytes data. This API will be called in order to get the capture data.
+      @param errc returning the error code of capture API
+      @param frameData passing by reference to get the frame data as unsigned char array
+      @param frameDataSize passing by reference to get the size of the frame data in the form of HxWxC
+      @param iter running for total iterations if > 0 else running infinite loop
+    */
+    void SyntheticCapture::getCapture(int& errc, unsigned char*& frameData, int& frameDataSize, int& iter)
+    {
+      getCaptureAtIndex(errc, frameData, frameDataSize, iter, 0);
+    }
+
+    void SyntheticCapture::getCaptureAtIndex(int& errc, unsigned char*& frameData, int& frameDataSize, int& iter, int cameraIndex)
+    {
+      int currIter = 0;
+      while(1)
+      {
+        if (iter>0)
+        {
+          if (currIter>iter)
+          {
+            break;
+          }
+        }
+        currIter++;
+
+        // Wait for message
+        auto message = trigger2camera_.GetMessage();
+        LOG_ALWAYS("[CAPTURE::SYNTHETIC] Trigger to Camera Message = " + message.captureTriggersMessage_);
+
+        message.captureTriggersMessageFull_["captureID"] = "#" + std::to_string(currIter);
+
+        // Create a message forward with local scope
+        MessageCaptureInference forward_message;
+        forward_message.captureTrigger_ = message;
+        forward_message.cameraName_ = cameraName_;
+
+        capture_start_time_ = std::chrono::steady_clock::now();
+
+        // check if it's an active pipeline
+        if(!camera2forward_.find(forward_message.captureTrigger_.captureTriggersMessage_))
+        {
+          LOG_ALWAYS("[CAPTURE::SYNTHETIC] Command Pipeline NOT available ");
+          continue;
+        }
+
+        if (message.captureTriggersMessage_ == "configchange")
+        {
+          LOG_ALWAYS("[CAPTURE::SYNTHETIC] Changing Config based on following: ");
+          LOG_ALWAYS(std::string(message.captureTriggersMessageFull_.dump()));
+
+          LOG_ALWAYS("[CAPTURE::SYNTHETIC] Cannot make changes for Synthetic Cameras");
+          continue;
+        }
+
+        // Pace the frames to the configured frame rate
+        if (framePeriod_ > std::chrono::steady_clock::duration::zero())
+        {
+          auto now = std::chrono::steady_clock::now();
+          if (nextFrameTime_ > now)
+          {
+            std::this_thread::sleep_until(nextFrameTime_);
+          }
+          nextFrameTime_ = std::max(nextFrameTime_, now) + framePeriod_;
+        }
+
+        // Exposures of a burst have no effect on generated frames, only the number of shots is used
+        int burstCount;
+        std::vector<double> exposureList;
+        getBurstPlan(message, burstCount, exposureList);
+
+        errc = CAPTURE_OK;
+        for (int shot=0; shot<burstCount; shot++)
+        {
+          std::shared_ptr<unsigned char> frame = framePool_->acquire();
+          if (!frame)
+          {
+            errc = RUN_CAPTURE_ERROR;
+            break;
+          }
+
+          frameData = frame.get();
+          frameDataSize = height_ * width_ * channels_;
+
+          forward_message.safeCaptureContainer_.push(frameData);
+          forward_message.safeCaptureSizeContainer_.push(frameDataSize);
+          forward_message.safeCaptureOwnerContainer_.push_back(frame);
+          forward_message.pixelFormat_ = (colorSpace_=="BGR") ? PIXEL_FORMAT_BGR : PIXEL_FORMAT_RGB;
+        }
+
+        if (errc!=CAPTURE_OK)
+        {
+          droppedFrames_++;
+          LOG_ALWAYS("[CAPTURE::SYNTHETIC] All pooled frames are in flight, dropping frame (" + std::to_string(droppedFrames_) + " dropped so far)");
+          continue;
+        }
+
+        LOG_ALWAYS("[CAPTURE::SYNTHETIC] Trigger: " + message.captureTriggersMessage_);
+
+        inferenceDetailsFilled = inferenceDetailsBlank;
+        inferenceDetailsFilled["pipelineName"] = message.captureTriggersMessage_;
+        inferenceDetailsFilled["is_inferred"] = "true";
+        setBurstDetails(inferenceDetailsFilled, burstCount, exposureList);
+        forward_message.inferenceDetailsMap_ = inferenceDetailsFilled;
+
+        LOG_ALWAYS("[CAPTURE::SYNTHETIC] Successful Capture #" + std::to_string(currIter+1) + " for camera");
+
+        capture_end_time_ = std::chrono::steady_clock::now();
+        capture_elapsed_seconds_ = capture_end_time_ - capture_start_time_;
+        LOG_ALWAYS("[CAPTURE::SYNTHETIC] Capture Elapsed Time: " + std::to_string(capture_elapsed_seconds_.count()) + " seconds.");
+
+        attachFramePyramids(forward_message);
+        attachRois(forward_message);
+
+        // Sending message to next step in pipeline
+        if(camera2forward_.find(message.captureTriggersMessage_))
+        {
+          LOG_ALWAYS("[CAPTURE::SYNTHETIC] Sending message forward");
+          camera2forward_.produce_message(message.captureTriggersMessage_, forward_message);
+        }
+      }
+    }
+
+  }
+}
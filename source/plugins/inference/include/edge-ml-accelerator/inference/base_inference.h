@@ -9,10 +9,14 @@
 #include <thread>
 #include <chrono>
 #include <mutex>
+#include <functional>
+#include <memory>
 #include <edge-ml-accelerator/utils/json_parser.h>
 #include <edge-ml-accelerator/utils/yaml_parser.h>
 #include <edge-ml-accelerator/utils/image_preprocess.h>
+#include <edge-ml-accelerator/utils/frame_pyramid.h>
 #include <edge-ml-accelerator/utils/result_postprocess.h>
+#include <edge-ml-accelerator/utils/thread_pool.h>
 #include <edge-ml-accelerator/utils/edge_ml_config.h>
 #include <edge-ml-accelerator/utils/logger.h>
 
@@ -29,6 +33,14 @@ namespace edgeml
     namespace inference
     {
 
+        /* Message whose model inputs were filled ahead of time by the preprocess worker */
+        struct PreparedInput
+        {
+            MessageCaptureInference message;
+            int slot = -1; // input buffers holding the tensors of the message, -1 if not preprocessed yet
+            std::vector<PreprocessTransform> transforms; // frame to model input transform per model
+        };
+
         class Inference
         {
             public:
@@ -40,12 +52,14 @@ namespace edgeml
                 SharedMessage<MessageCaptureInference>* GetSharedPointer(){return &output_inference_;}
                 ~Inference();
                 void SetToProduceOutput(bool val = true){produce_output_ = val;}
+                void getModelInputSize(int& height, int& width){height = modelInputHeight_; width = modelInputWidth_;} // largest input of the models, 0 if not loaded yet
                 nlohmann::json lfveAnomaliesNlohmannJson_, lfveResultsNlohmannJson_;
                 nlohmann::json customResultsNlohmannJson_;
                 nlohmann::json inferenceBaseInferenceResultsNlohmannJson;
             
             protected:
                 utils::jsonParser::jValue jsonParams_;                
+                std::string colorSpace_; // pixel format the models expect, frames in other formats are converted while resizing
                 std::mutex mtx_;
 
                 std::chrono::steady_clock::time_point start_timeout = std::chrono::steady_clock::now();
@@ -56,6 +70,30 @@ namespace edgeml
                 bool produce_output_ = true;
                 utils::GPIO gpio;
                 int gpioRet, gpioValue = 0;
+
+                int modelInputHeight_ = 0, modelInputWidth_ = 0;
+                int numInputBuffers = 2; // rotating input buffers of the preprocess worker, 1 preprocesses in the inference loop
+                std::unique_ptr<utils::ThreadPool> modelPool; // running the models of a frame concurrently
+
+                void readInputBuffers(int inferIdx); // inputBuffers of the stage
+                template<class Tensors>
+                void allocateInputSlots(std::vector<Tensors>& slots, const Tensors& tensors) // one copy of the model inputs per input buffer
+                {
+                    slots.assign((numInputBuffers>1) ? numInputBuffers : 0, tensors);
+                }
+                void createModelPool(int inferIdx, int numModels); // modelThreads of the stage
+                void startPreprocessWorker(int numSlots, const std::function<bool(PreparedInput&)>& prepare); // preprocessing the next messages while the current one is inferred
+                void stopPreprocessWorker(); // called first by the destructor of the client, the worker writes into its buffers
+                PreparedInput getPreparedInput(); // next message, with its inputs filled if the worker runs
+                void releaseInputSlot(int slot);
+
+            private:
+                SharedMessage<PreparedInput> preparedInputs_;
+                SharedMessage<int> freeInputSlots_;
+                std::function<bool(PreparedInput&)> prepareInput_;
+                std::thread preprocessThread_;
+                std::atomic<bool> stopPreprocess_{false};
+                void runPreprocessWorker();
         };
 
     }
@@ -43,7 +43,7 @@ namespace edgeml
                 std::string pipelineName_;
                 nlohmann::json inferenceBaseInferenceResultsNlohmannJson_ = inferenceBaseInferenceResultsNlohmannJson;
                 int ret, modelID = 0;
-                int numModels, scaleBy;
+                int numModels;
                 bool useGpio = false;
                 std::vector<std::string> model_name;
                 std::vector<std::string> model_path;
@@ -80,8 +80,12 @@ namespace edgeml
                 AWS::SageMaker::Edge::Tensor* outputTensor; // output tensor creation
                 std::vector<AWS::SageMaker::Edge::Tensor*> outputTensorVec; // output tensor vector creation
 
-                std::vector<std::vector<unsigned char> > inputDataVec;
-                std::vector<float> inputScaled;
+                std::vector<std::vector<unsigned char> > inputTensorData; // normalized input per model, in the layout and element type of the model
+                std::vector<PreprocessParams> preprocess_params;
+                std::vector<PreprocessPlan> preprocess_plans; // built on the first frame of each model
+                std::vector<std::vector<std::vector<unsigned char> > > inputSlotData; // per input buffer and model, filled by the preprocess worker
+                std::vector<PreprocessPlan> slot_plans; // plans of the preprocess worker
+                utils::ImagePreProcess slotPreprocess; // preprocessing state of the worker, not shared with the inference loop
                 std::vector<std::vector<float> > outputDataVec;
 
                 grpc::ClientContext context; // single context will be used for multiple models
@@ -94,9 +98,11 @@ namespace edgeml
                 std::chrono::steady_clock::time_point inference_start_time = std::chrono::steady_clock::now();
                 std::chrono::steady_clock::time_point inference_end_time = std::chrono::steady_clock::now();
                 std::chrono::duration<double> inference_duration;
-                utils::ImagePreProcess imagePreprocess;
+                std::vector<utils::ImagePreProcess> imagePreprocessVec; // per model, so that models preprocess concurrently
 
                 int initInfer(int inferIdx);
+                void preprocessFrame(int modelIndex, const MessageCaptureInference& message, int height, int width, utils::ImagePreProcess& preprocess, PreprocessPlan& plan, void* tensor); // Resizing and normalizing a frame into the input of a model
+                bool prepareInput(PreparedInput& input, int height, int width, utils::ImagePreProcess& preprocess, std::vector<PreprocessPlan>& plans, std::vector<std::vector<unsigned char> >& tensors); // Preprocessing a frame for all models
                 bool findModel(int id, const std::string& model_name);
                 int LoadModel(int id, const std::string model_path, const std::string model_name);
                 int UnLoadModel(int id, const std::string model_name);
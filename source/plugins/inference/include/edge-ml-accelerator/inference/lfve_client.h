@@ -63,6 +63,7 @@ namespace edgeml
                 AWS::LookoutVision::DetectAnomaliesRequest request; // single request will be used for multiple models
                 AWS::LookoutVision::DetectAnomaliesResponse response; // single response will be used for multiple models
                 AWS::LookoutVision::DetectAnomalyResult reply; // single reply will be used for multiple models
+                std::vector<AWS::LookoutVision::DetectAnomalyResult> replyVec; // per model, filled by the models running concurrently
                 grpc::ClientContext context; // single context will be used for multiple models
                 AWS::LookoutVision::Bitmap bitmap; // bitmap image creation
                 AWS::LookoutVision::Bitmap anomaly_mask; // output bitmap mask
@@ -79,6 +80,9 @@ namespace edgeml
                 std::chrono::duration<double> inference_duration;
 
                 utils::ImagePreProcess imagePreprocess;
+                std::vector<utils::ImagePreProcess> imagePreprocessVec; // per model, so that models resize concurrently
+                std::vector<std::vector<unsigned char> > resizedImageVec;
+                std::vector<unsigned char> resizedMask_;
 
                 int initInfer(int inferIdx);
         };
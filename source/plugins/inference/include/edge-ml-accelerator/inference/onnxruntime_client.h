@@ -15,11 +15,22 @@
 #include <thread>
 #include <chrono>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <limits>
+#include <atomic>
 #include <string>
 #include <stdint.h>
 #include <dirent.h>
+#include <functional>
+#include <numeric>
+#include <experimental/filesystem>
 #include <core/session/onnxruntime_c_api.h>
 #include <edge-ml-accelerator/inference/base_inference.h>
+#include <edge-ml-accelerator/utils/aligned_allocator.h>
+#include <edge-ml-accelerator/utils/control_bus.h>
 
 
 namespace edgeml
@@ -27,6 +38,31 @@ namespace edgeml
     namespace inference
     {
 
+        struct OrtSessionConfig
+        {
+            int intraOpThreads = 0; // 0 runs on the global thread pools of the environment
+            int interOpThreads = 0;
+            bool parallelExecution = false;
+            bool memPattern = false;
+            bool cpuArena = true;
+        };
+
+        struct OrtTensorDetails
+        {
+            std::string name;
+            ONNXTensorElementDataType type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+            std::vector<int64_t> shape; // negative for dynamic dimensions
+            long int elementCount = -1; // for a batch of one, -1 if other dimensions are dynamic
+        };
+
+        struct RunCondition
+        {
+            int sourceModel = -1; // earlier model whose primary output decides, -1 always runs
+            std::vector<int> classes; // top class of the source output, any class if empty
+            float minScore = std::numeric_limits<float>::lowest(), maxScore = std::numeric_limits<float>::max(); // bounds of the top score
+            float anomalyThreshold = -1.0f; // first value of the source output flags an anomaly above it, negative ignores it
+        };
+
         class OnnxRuntimeClient: public Inference
         {
             public:
@@ -41,35 +77,121 @@ namespace edgeml
                 std::string pipelineName_;
                 nlohmann::json inferenceBaseInferenceResultsNlohmannJson_ = inferenceBaseInferenceResultsNlohmannJson;
                 int ret, modelID = 0;
-                int numModels, scaleBy;
+                int numModels;
                 bool useGpio = false;
                 std::vector<std::string> model_name;
                 std::vector<std::string> model_path;
                 std::vector<std::string> model_type;
+                struct ModelFileHash
+                {
+                    long long size;
+                    long long mtime;
+                    std::string hash;
+                };
+                std::map<std::string, ModelFileHash> model_hash; // by model file, computed again when the file changes
+                GraphOptimizationLevel graphOptimizationLevel = ORT_ENABLE_ALL;
+                std::vector<OrtSessionConfig> session_configs; // per model, settings its session was created with
+                std::string optimizedModelDir; // empty optimizes the models on every start
+                bool useCuda = false;
 
                 const OrtApi* g_ort = nullptr;
                 std::vector<OrtSession*> ort_session_vec;
                 std::vector<OrtMemoryInfo*> ort_memory_vec;
-                OrtEnv* pOrt_env = nullptr;
+                OrtEnv* pOrt_env = nullptr; // shared by all clients of the process
+                OrtSessionOptions* session_options = nullptr; // common to all sessions of the client, cloned per session
+                static std::mutex envMtx_;
+                static OrtEnv* sharedEnv_;
+                static int envUsers_;
+
+                int inferIdx_ = 0;
+                bool clientStarted_ = false; // with onnxRuntime.lazyLoading the stage is set up on its first frame
+                bool clientFailed_ = false; // models that could not be set up, the frames of the stage are dropped
+                bool sessionsResident_ = false; // guarded by sessionMtx_, sessions are released when evicted
+                size_t sessionBytes_ = 0; // footprint of the sessions, estimated by the model file sizes, updated under residentMtx_ on a swap
+                size_t sessionBudget_ = 0; // onnxRuntime.sessionMemoryBudgetMB in bytes, 0 keeps all sessions
+                static std::mutex residentMtx_;
+                static std::list<OnnxRuntimeClient*> residentClients_; // clients with sessions, most recently used first
+                static size_t residentBytes_;
 
                 std::vector<std::string> input_tensor_names;
                 std::vector<std::vector<int> > input_tensor_shape;
                 std::vector<int> input_tensor_size, input_height, input_width, input_channels;
+                std::vector<ONNXTensorElementDataType> input_tensor_type;
+                std::vector<PreprocessParams> preprocess_params;
+                std::vector<PreprocessPlan> preprocess_plans; // built on the first frame of each model
+                std::vector<TilingParams> tiling_params;
+                std::vector<std::vector<PreprocessPlan> > crop_plans; // per model, the plans of its tiles or regions of interest
+                bool useRois = false, emitRois = false; // inferring regions of interest only, passing detections on as regions
+                std::vector<RegionOfInterest> staticRois; // regions of this stage, else the regions of the message
+                float emitRoiThreshold = 0.5f, emitRoiNmsThreshold = 0.45f;
+                int emitRoiPadding = 0;
+                std::vector<std::vector<OrtTensorDetails> > input_details, output_details; // per model, all of its inputs and outputs
+                std::vector<int> image_input_index, primary_output_index; // per model, the input fed the frame and the output returned as results
+                std::vector<std::vector<std::pair<std::string, OrtValue*> > > extraInputsVec; // per model, inputs other than the image by name
+                std::vector<AlignedVector<unsigned char> > constantDataVec; // buffers of the constant inputs
+                std::vector<OrtValue*> constantTensors;
+                std::vector<std::vector<AlignedVector<unsigned char> > > extraOutputDataVec; // per model and output, buffers of the outputs besides the primary one
+                std::vector<std::vector<OrtValue*> > extraOutputTensorsVec; // nullptr for the primary output and outputs of dynamic shape
+                std::vector<int> model_level; // per model, the wave it runs in after the models feeding it
+                std::vector<std::vector<int> > modelWaves;
+                std::vector<std::vector<int> > model_sources; // per model, the models it is fed or gated by
+                std::vector<RunCondition> run_conditions; // per model, from runIf of the config
+                bool hasCascade = false;
+                std::vector<char> model_skipped; // per model, for the current frame
+                std::vector<double> model_run_times; // per model in ms, for the current frame
+
+                struct AsyncFrame
+                {
+                    OnnxRuntimeClient* client = nullptr;
+                    PreparedInput input;
+                    int height = 0, width = 0;
+                    std::chrono::steady_clock::time_point startTime;
+                    std::atomic<int> pendingModels{0};
+                    bool done = false; // guarded by asyncMtx_
+                    std::atomic<bool> failed{false};
+                    std::vector<std::pair<AsyncFrame*, int> > runs; // user data of the run of every model
+                };
+                int asyncRequests = 1; // frames in flight with RunAsync, 1 runs every frame synchronously
+                std::vector<std::vector<const char*> > asyncInputNames, asyncOutputNames; // per model, all inputs and the bound outputs
+                std::vector<std::vector<int> > asyncOutputIndex; // per model, the outputs in asyncOutputNames, primary first
+                std::vector<std::vector<std::vector<const OrtValue*> > > slotAsyncInputs; // per input buffer and model
+                std::vector<std::vector<std::vector<OrtValue*> > > slotAsyncOutputs;
+                std::vector<std::vector<std::vector<AlignedVector<unsigned char> > > > slotOutputData; // per input buffer, model and output
+                std::deque<std::shared_ptr<AsyncFrame> > asyncFrames_; // in flight, in capture order
+                std::mutex asyncMtx_;
+                std::condition_variable asyncCv_;
+                std::thread asyncThread_;
+                unsigned long asyncLaunched_ = 0, asyncDelivered_ = 0; // guarded by asyncMtx_
+                bool stopAsync_ = false; // guarded by asyncMtx_, ends the delivery thread
+
+                std::string inferName_;
+                int controlSubscription_ = -1;
+                SharedMessage<nlohmann::json> modelSwaps_; // configchange commands with models
+                std::thread swapThread_;
+                std::atomic<bool> stopSwaps_{false};
+                std::mutex sessionMtx_; // held while frames run or are launched, models are swapped between frames
                 std::vector<std::string> output_tensor_names;
                 std::vector<std::vector<int> > output_tensor_shape;
                 std::vector<int> output_tensor_size, output_height, output_width, output_channels;
 
-                OrtValue* inputTensors{nullptr};
-                OrtValue* outputTensors{nullptr};
-                std::vector<float> inputTensorValues, outputTensorValues;
+                std::vector<OrtValue*> inputTensorsVec; // one input tensor per model, bound to inputTensorData
+                std::vector<OrtValue*> outputTensorsVec; // one output tensor per model, bound to outputTensorValuesVec
+                std::vector<OrtIoBinding*> ioBindingVec; // per model, binding inputTensorsVec and outputTensorsVec once
+                std::vector<AlignedVector<unsigned char> > inputTensorData;
+                std::vector<std::vector<AlignedVector<unsigned char> > > inputSlotData; // per input buffer and model, filled by the preprocess worker
+                std::vector<std::vector<OrtValue*> > inputSlotTensors; // bound to inputSlotData
+                std::vector<std::vector<OrtIoBinding*> > inputSlotBindings; // per input buffer and model, binding inputSlotTensors and outputTensorsVec
+                std::vector<PreprocessPlan> slot_plans; // plans of the preprocess worker
+                utils::ImagePreProcess slotPreprocess; // preprocessing state of the worker, not shared with the inference loop
+                std::vector<AlignedVector<unsigned char> > cropBatchInputVec; // per model, batch of tiles or regions of a frame
+                std::vector<cv::Mat> cropSourceVec; // per model, frames that crops cannot be addressed in, converted once
+                std::vector<AlignedVector<float> > outputTensorValuesVec;
                 std::vector<const char*> inputNames;
                 std::vector<const char*> outputNames;
                 std::vector<std::vector<const char*>> inputNamesVec;
 	            std::vector<std::vector<const char*>> outputNamesVec;
-                std::vector<std::vector<unsigned char> > inputDataVec;
-                std::vector<float> inputScaled;
                 std::vector<std::vector<float> > outputDataVec;
-                std::vector<bool> is_chw_vec;
+                std::vector<bool> is_chw_vec, is_chw_output_vec, is_dynamic_batch_vec;
 
                 std::mutex mtx_;
                 std::shared_ptr<ThreadSafeCaptureContainer> captureContainer;
@@ -79,10 +201,50 @@ namespace edgeml
                 std::chrono::steady_clock::time_point inference_start_time = std::chrono::steady_clock::now();
                 std::chrono::steady_clock::time_point inference_end_time = std::chrono::steady_clock::now();
                 std::chrono::duration<double> inference_duration;
-                utils::ImagePreProcess imagePreprocess;
+                std::vector<utils::ImagePreProcess> imagePreprocessVec; // per model, so that models preprocess concurrently
+                std::vector<utils::ResultPostProcess> resultPostprocessVec;
 
                 void CheckStatus(OrtStatus* status);
+                OrtEnv* acquireSharedEnv(); // Creating the process wide environment with global thread pools on first use
+                void releaseSharedEnv();
+                OrtIoBinding* bindTensors(int modelIndex, OrtValue* inputTensor, OrtSession* session = nullptr); // Binding an image input tensor, the other inputs and the outputs of a model
+                std::vector<OrtTensorDetails> getTensorDetails(OrtSession* session, bool inputs); // Enumerating the inputs or outputs of a session
+                std::string getShapeString(const std::vector<int64_t>& shape);
+                size_t getOrtElementSize(ONNXTensorElementDataType type);
+                OrtValue* getModelOutputTensor(int modelIndex, const std::string& sourceModel, const std::string& sourceOutput, const OrtTensorDetails& details); // Feeding an input with the output of an earlier model
+                OrtValue* createConstantTensor(int modelIndex, const OrtTensorDetails& details, utils::jsonParser::jValue values); // Feeding an input with constant values
+                std::vector<float> getOutputValues(const unsigned char* data, const OrtTensorDetails& details);
+                OrtSessionOptions* createSessionOptions(OrtSessionOptions* baseOptions, const OrtSessionConfig& config); // Cloning the common options with the settings of one session
+                OrtSessionConfig autotuneSession(int modelIndex, OrtSessionOptions* baseOptions, const OrtSessionConfig& initial, utils::jsonParser::jValue autotune); // Picking the fastest session settings of a model, cached on disk
+                double benchmarkSession(int modelIndex, OrtSessionOptions* baseOptions, const OrtSessionConfig& config, int iterations, bool latency); // Timing the model with the given session settings
+                OrtSession* createModelSession(int modelIndex, OrtSessionOptions* baseOptions, const OrtSessionConfig& config, const std::string& path = ""); // Loading a model, from its optimized graph when cached
+                std::string getModelHash(const std::string& path); // Hash of a model file, keying the caches
+                std::string selectModelVariant(int modelIndex, utils::jsonParser::jValue variants); // Picking the fastest variant of a model within an accuracy tolerance, cached on disk
+                bool hasModelSignature(int modelIndex, OrtSession* session); // Checking a session against the inputs and outputs of a model
+                std::string getMachineHash(); // Hash of the CPU model and core count
+                std::string getSessionKey(const OrtSessionConfig& config); // Options an optimized graph depends on
                 int initInfer(int inferIdx);
+                int startClient(); // Setting up the models of the stage, at construction or on the first frame
+                size_t getSessionBytes(); // Estimating the memory of the sessions by the model file sizes
+                bool isPrewarmed(); // Checking if a model of the stage is loaded and warmed up at construction
+                void acquireSessions(); // Loading evicted sessions and evicting least recently used clients over the budget
+                bool evictSessions(); // Releasing the sessions of an idle client
+                void preprocessFrame(int modelIndex, unsigned char* inputImage, int height, int width, int frameFormat, void* tensor, utils::FramePyramid* pyramid = nullptr); // Resizing and normalizing a frame into an input tensor
+                bool prepareInput(PreparedInput& input, int height, int width, utils::ImagePreProcess& preprocess, std::vector<PreprocessPlan>& plans, std::vector<AlignedVector<unsigned char> >& tensors); // Preprocessing a single frame message for all models
+                void runBatch(int modelIndex, std::vector<unsigned char*>& inputImages, int height, int width, int frameFormat, std::vector<std::shared_ptr<utils::FramePyramid>>& pyramids, std::vector<std::vector<std::vector<float> > >& burstOutputs); // Running all frames of a burst as one batch
+                void runCrops(int modelIndex, unsigned char* inputImage, int height, int width, int frameFormat, utils::FramePyramid* pyramid, const std::vector<cv::Rect>& crops, std::vector<PreprocessPlan>& plans, int batchLimit, const std::function<void(int, const float*, const PreprocessTransform&)>& onOutput); // Running crops of a frame in batches
+                void runTiled(int modelIndex, unsigned char* inputImage, int height, int width, int frameFormat, utils::FramePyramid* pyramid, std::vector<float>& results, std::vector<int>& resultShape); // Running a frame tile by tile and merging the results
+                void runRois(int modelIndex, unsigned char* inputImage, int height, int width, int frameFormat, utils::FramePyramid* pyramid, const std::vector<RegionOfInterest>& rois, std::vector<float>& results, std::vector<int>& resultShape, std::vector<PreprocessTransform>& transforms); // Running the regions of interest of a frame
+                std::vector<RegionOfInterest> getDetectedRois(int modelIndex, std::vector<float>& results, const std::vector<PreprocessTransform>& transforms, int height, int width); // Turning detections into regions for the next stage
+                int getModelPixelFormat(int modelIndex);
+                void finishInference(MessageCaptureInference& message, std::vector<PreprocessTransform>& frameTransforms, std::vector<std::vector<std::vector<float> > >& burstOutputs, std::vector<std::vector<int> >& resultsShape, std::vector<std::vector<PreprocessTransform> >& roisTransform, std::vector<RegionOfInterest>& rois, int height, int width, std::chrono::steady_clock::time_point startTime); // Filling the results and sending the message on
+                void launchAsync(PreparedInput& input, int height, int width); // Starting the models of a frame with RunAsync
+                static void onAsyncRunDone(void* userData, OrtValue** outputs, size_t numOutputs, OrtStatus* status);
+                void runAsyncDelivery(); // Delivering the frames in flight in capture order
+                void drainAsync(); // Waiting for the frames in flight
+                bool shouldRunModel(int modelIndex, const std::vector<std::vector<std::vector<float> > >& burstOutputs); // Checking the runIf condition of a model on the outputs of the frame
+                void runModelSwaps(); // Loading the model versions of configchange commands
+                bool swapModel(int modelIndex, const std::string& path); // Switching a model to a new version between frames
         };
 
     }
@@ -57,6 +57,7 @@ namespace edgeml
                 std::chrono::steady_clock::time_point inference_start_time = std::chrono::steady_clock::now();
                 std::chrono::steady_clock::time_point inference_end_time = std::chrono::steady_clock::now();
                 std::chrono::duration<double> inference_duration;
+                utils::ImagePreProcess imagePreprocess;
 
                 utils::GPIO gpio;
                 int gpioRet, gpioValue = 0;
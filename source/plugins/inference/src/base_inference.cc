@@ -34,6 +34,7 @@ namespace edgeml
 		Inference::Inference(utils::jsonParser::jValue j, SharedMessage<MessageCaptureInference> & shared_map) : jsonParams_(j), camera2ongoing_(shared_map)
 		{
 			LOG_ALWAYS("[INFERENCE::BASE] Base Inference class is created.");
+			colorSpace_ = jsonParams_["preprocess"]["colorSpace"].as_string();
 
 			/* For Lookout for Vision Edge
 			{
@@ -105,6 +106,131 @@ namespace edgeml
 		*/
 		Inference::~Inference()
 		{
+			stopPreprocessWorker();
+		}
+
+		/**
+		Reading the number of rotating input buffers of the stage from inputBuffers, keeping the default if not set
+		@param inferIdx index of the stage in the inference config
+		*/
+		void Inference::readInputBuffers(int inferIdx)
+		{
+			// Frames are preprocessed on a worker into rotating input buffers while the models run on the previous ones
+			if (jsonParams_["inference"][inferIdx]["inputBuffers"].get_type()!=jsonParser::JUNKNOWN)
+			{
+				numInputBuffers = std::max(jsonParams_["inference"][inferIdx]["inputBuffers"].as_int(), 1);
+			}
+		}
+
+		/**
+		Creating the pool running the models of a frame concurrently, one thread per model up to the number of cores
+		unless limited by modelThreads
+		@param inferIdx index of the stage in the inference config
+		@param numModels number of models of the stage
+		*/
+		void Inference::createModelPool(int inferIdx, int numModels)
+		{
+			int modelThreads = std::min(numModels, (int)(std::max(std::thread::hardware_concurrency(), 1u)));
+			if (jsonParams_["inference"][inferIdx]["modelThreads"].get_type()==jsonParser::JNUMBER && jsonParams_["inference"][inferIdx]["modelThreads"].as_int()>0)
+			{
+				modelThreads = std::min(jsonParams_["inference"][inferIdx]["modelThreads"].as_int(), numModels);
+			}
+			modelPool = std::make_unique<utils::ThreadPool>(std::max(modelThreads, 1));
+			LOG_ALWAYS("[INFERENCE::BASE] Running " + std::to_string(numModels) + " model(s) on " + std::to_string(modelPool->getNumThreads()) + " thread(s)");
+		}
+
+		/**
+		Starting the preprocess worker of the client. The worker takes the next message as soon as one of the numSlots
+		rotating input buffers is free and fills it while the inference loop runs the models on another one, so a
+		frame costs the longer of preprocessing and inference instead of their sum.
+		@param numSlots number of rotating input buffers, the worker is not started for fewer than 2
+		@param prepare routine filling the input buffers of input.slot from input.message, false if the message has
+		to be preprocessed by the inference loop, e.g. bursts or tiles that are preprocessed batch by batch
+		*/
+		void Inference::startPreprocessWorker(int numSlots, const std::function<bool(PreparedInput&)>& prepare)
+		{
+			if (numSlots<2 || preprocessThread_.joinable())
+			{
+				return;
+			}
+			prepareInput_ = prepare;
+			for (int slot=0; slot<numSlots; slot++)
+			{
+				freeInputSlots_.produce_message(slot);
+			}
+			preprocessThread_ = std::thread(&Inference::runPreprocessWorker, this);
+			LOG_ALWAYS("[INFERENCE::BASE] Preprocessing on a worker thread with " + std::to_string(numSlots) + " input buffers");
+		}
+
+		/**
+		Stopping the preprocess worker and waiting for it, so it no longer writes into the input buffers of the client.
+		The worker is woken whether it waits for a message or for a free input buffer.
+		*/
+		void Inference::stopPreprocessWorker()
+		{
+			if (!preprocessThread_.joinable())
+			{
+				return;
+			}
+			stopPreprocess_ = true;
+			camera2ongoing_.produce_message(MessageCaptureInference());
+			freeInputSlots_.produce_message(-1);
+			preprocessThread_.join();
+		}
+
+		/**
+		Getting the next message for the inference loop
+		@return the message, with the input buffers it was preprocessed into or slot -1
+		*/
+		PreparedInput Inference::getPreparedInput()
+		{
+			if (!preprocessThread_.joinable())
+			{
+				PreparedInput input;
+				input.message = camera2ongoing_.GetMessage();
+				return input;
+			}
+			return preparedInputs_.GetMessage();
+		}
+
+		/**
+		Handing the input buffers of a message back to the preprocess worker once the models ran on them
+		@param slot input buffers of the message, ignored if -1
+		*/
+		void Inference::releaseInputSlot(int slot)
+		{
+			if (slot>=0)
+			{
+				freeInputSlots_.produce_message(slot);
+			}
+		}
+
+		/**
+		Preprocess worker loop, messages leave it in the order they arrived
+		*/
+		void Inference::runPreprocessWorker()
+		{
+			while(!stopPreprocess_)
+			{
+				PreparedInput input;
+				input.message = camera2ongoing_.GetMessage();
+				if (stopPreprocess_)
+				{
+					break;
+				}
+				input.slot = freeInputSlots_.GetMessage(); // waiting while all input buffers are in flight
+				if (stopPreprocess_ || input.slot<0)
+				{
+					break;
+				}
+				if (!prepareInput_(input))
+				{
+					releaseInputSlot(input.slot);
+					input.slot = -1;
+					input.transforms.clear();
+				}
+				preparedInputs_.produce_message(input);
+			}
 		}
 
 	}
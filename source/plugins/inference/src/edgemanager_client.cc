@@ -39,7 +39,6 @@ namespace edgeml
       start_timeout = std::chrono::steady_clock::now();
       LOG_ALWAYS("[INFERENCE::EdgeManagerClient] Inference Name: " + jsonParams_["inference"][inferIdx]["inferName"].as_string());
       useGpio = jsonParams_["useGpio"].as_bool();
-      scaleBy = jsonParams_["preprocess"]["scaleBy"].as_int();
       int ret = initInfer(inferIdx);
 
       if (ret == MODEL_FAILURE)
@@ -57,6 +56,7 @@ namespace edgeml
     */
     EdgeManagerClient::~EdgeManagerClient()
     {
+      stopPreprocessWorker();
       for (int i=0; i<numModels; i++)
       {
         UnLoadModel(i, model_name[i]);
@@ -249,17 +249,41 @@ namespace edgeml
           tensormetadataVec[i].add_shape(input_tensor_shape[i][j]);
           indatasize *= input_tensor_shape[i][j];
         }
-        unsigned char chardata[indatasize];
         input_tensor_size.push_back(indatasize);
         input_height.push_back(input_tensor_shape[i][1]); input_width.push_back(input_tensor_shape[i][2]); input_channels.push_back(input_tensor_shape[i][3]);
+        bool isCHW = (input_tensor_shape[i][1]==1 || input_tensor_shape[i][1]==2 || input_tensor_shape[i][1]==3);
+        if (isCHW)
+        {
+          input_height[i] = input_tensor_shape[i][2];
+          input_width[i] = input_tensor_shape[i][3];
+          input_channels[i] = input_tensor_shape[i][1];
+        }
+        modelInputHeight_ = std::max(modelInputHeight_, input_height[i]);
+        modelInputWidth_ = std::max(modelInputWidth_, input_width[i]);
+
+        // The frames are normalized into a buffer in the layout and element type of the model
+        int tensorType = TENSOR_TYPE_FLOAT32;
+        if (input_tensor_data_type[i]==AWS::SageMaker::Edge::FLOAT16)
+        {
+          tensorType = TENSOR_TYPE_FLOAT16;
+        }
+        else if (input_tensor_data_type[i]==AWS::SageMaker::Edge::UINT8)
+        {
+          tensorType = TENSOR_TYPE_UINT8;
+        }
+        else if (input_tensor_data_type[i]!=AWS::SageMaker::Edge::FLOAT32)
+        {
+          LOG_ERROR("[INFERENCE::EdgeManagerClient] Input data type " + std::string(EdgeManagerModelDataTypeE[input_tensor_data_type[i]]) + " of model " + model_name[i] + " is not supported, feeding FLOAT32");
+        }
+        preprocess_params.push_back(ImagePreProcess::getPreprocessParams(jsonParams_["preprocess"], isCHW ? TENSOR_LAYOUT_NCHW : TENSOR_LAYOUT_NHWC, tensorType));
+        preprocess_plans.push_back(PreprocessPlan());
+        inputTensorData.push_back(std::vector<unsigned char>((size_t)(indatasize) * ImagePreProcess::getTensorElementSize(tensorType), 0));
+
         tensormetadataVec[i].set_data_type(input_tensor_data_type[i]);
         tensorVec[i].mutable_tensor_metadata()->CopyFrom(tensormetadataVec[i]);
-        std::string sp(reinterpret_cast<char*>(chardata), indatasize);
-        tensorVec[i].set_byte_data(sp);
+        tensorVec[i].set_byte_data(inputTensorData[i].data(), inputTensorData[i].size());
         predRequestVec[i].add_tensors();
         predRequestVec[i].mutable_tensors(0)->CopyFrom(tensorVec[i]);
-        std::vector<unsigned char> tmpInputVec(indatasize, 0);
-        inputDataVec.push_back(tmpInputVec);
 
         outputTensorVec.push_back(outputTensor);
         outputTensorVec[i] = cdRequest.add_output_tensors();
@@ -276,15 +300,20 @@ namespace edgeml
         ret = INFERENCE_OK;
       }
 
+      readInputBuffers(inferIdx);
+      allocateInputSlots(inputSlotData, inputTensorData);
+      slot_plans = preprocess_plans;
+      imagePreprocessVec.resize(numModels);
+
+      createModelPool(inferIdx, numModels);
+
       // Warm-up model for 5 inferences
       for (int iter=0; iter<5; iter++)
       {
         LOG_ALWAYS("[INFERENCE::EdgeManagerClient] Model Warmup : Running Dummy Inference for #" + std::to_string(iter+1) + "/5");
         for (int i=0; i<numModels; i++)
         {
-          float chardata[input_tensor_size[i]];
-          std::string sp(reinterpret_cast<char*>(chardata), input_tensor_size[i]);
-          tensorVec[i].set_byte_data(sp);
+          tensorVec[i].set_byte_data(inputTensorData[i].data(), inputTensorData[i].size());
           predRequestVec[i].mutable_tensors(0)->CopyFrom(tensorVec[i]);
 
           grpc::ClientContext context;
@@ -295,6 +324,52 @@ namespace edgeml
       return ret;
     }
 
+    /**
+      Resizing the frame of a message to the model size and normalizing it into an input buffer of the model
+      @param modelIndex index of the model
+      @param message message carrying the frame
+      @param height height of the input image
+      @param width width of the input image
+      @param preprocess preprocessing state of the calling thread
+      @param plan preprocess plan of the model for the calling thread
+      @param tensor input buffer of the model
+    */
+    void EdgeManagerClient::preprocessFrame(int modelIndex, const MessageCaptureInference& message, int height, int width, utils::ImagePreProcess& preprocess, PreprocessPlan& plan, void* tensor)
+    {
+      int i = modelIndex;
+      unsigned char* inputImage = message.safeCaptureContainer_.front();
+      int frameFormat = ImagePreProcess::resolvePixelFormat(message.pixelFormat_, colorSpace_);
+      int modelFormat = (input_channels[i]==1) ? PIXEL_FORMAT_GRAY : ImagePreProcess::getPixelFormat(colorSpace_);
+      preprocess.resizeNormalize(inputImage, width, height, frameFormat, input_width[i], input_height[i], modelFormat, preprocess_params[i], plan, tensor, message.framePyramids_.empty() ? nullptr : message.framePyramids_[0].get());
+    }
+
+    /**
+      Preprocessing the frame of a message into the input buffers of all models, called by the preprocess worker
+      with its own state and buffers
+      @param input message to preprocess, getting the frame to model input transform per model
+      @param height height of the input image
+      @param width width of the input image
+      @param preprocess preprocessing state of the calling thread
+      @param plans preprocess plans of the calling thread, one per model
+      @param tensors input buffers to fill, one per model
+      @return true if the message was preprocessed
+    */
+    bool EdgeManagerClient::prepareInput(PreparedInput& input, int height, int width, utils::ImagePreProcess& preprocess, std::vector<PreprocessPlan>& plans, std::vector<std::vector<unsigned char> >& tensors)
+    {
+      if (input.message.safeCaptureContainer_.empty())
+      {
+        return false;
+      }
+
+      input.transforms.clear();
+      for (int i=0; i<numModels; i++)
+      {
+        preprocessFrame(i, input.message, height, width, preprocess, plans[i], tensors[i].data());
+        input.transforms.push_back(plans[i].transform);
+      }
+      return true;
+    }
+
     /**
       Run inference for EdgeManager for Classification, Object Detection and Segmentation models
       @param errc returning the error code of capture API
@@ -304,9 +379,15 @@ namespace edgeml
     */
     void EdgeManagerClient::runInference(int& errc, int& height, int& width, int& iter, bool& completed)
     {
+      startPreprocessWorker(numInputBuffers, [this, &height, &width](PreparedInput& input)
+      {
+        return prepareInput(input, height, width, slotPreprocess, slot_plans, inputSlotData[input.slot]);
+      });
+
       while(1)
       {
-        auto message = camera2ongoing_.GetMessage();
+        PreparedInput input = getPreparedInput();
+        auto& message = input.message;
         LOG_ALWAYS("[INFERENCE::EdgeManagerClient] Capture Trigger Message = " + message.captureTrigger_.captureTriggersMessage_);
         message.inferenceMode_ = InferenceInputModeE::EDGEMANAGER;
 
@@ -314,15 +395,17 @@ namespace edgeml
 
         inference_start_time = std::chrono::steady_clock::now();
 
-        unsigned char* inputImage = message.safeCaptureContainer_.front();
         LOG_ALWAYS("[INFERENCE::EdgeManagerClient] Inference started for model(s)");
-        for (int i=0; i<numModels; i++)
+        // Models are independent, each one runs on its own buffers while the others run on the pool
+        modelPool->run(numModels, [&](int i)
         {
-          ret = imagePreprocess.resize(inputImage, width, height, inputDataVec[i].data(), input_width[i], input_height[i], input_channels[i]);
-          inputScaled = imagePreprocess.scale(inputDataVec[i], input_width[i], input_height[i], input_channels[i], scaleBy);
-
-          std::string sp(reinterpret_cast<char*>(inputScaled.data()), input_tensor_size[i]);
-          tensorVec[i].set_byte_data(sp);
+          // Frames the worker did not take are preprocessed here
+          std::vector<unsigned char>& tensor = (input.slot>=0) ? inputSlotData[input.slot][i] : inputTensorData[i];
+          if (input.slot<0)
+          {
+            preprocessFrame(i, message, height, width, imagePreprocessVec[i], preprocess_plans[i], tensor.data());
+          }
+          tensorVec[i].set_byte_data(tensor.data(), tensor.size());
           predRequestVec[i].mutable_tensors(0)->CopyFrom(tensorVec[i]);
 
           grpc::ClientContext context;
@@ -343,6 +426,11 @@ namespace edgeml
           {
             LOG_ALWAYS("[INFERENCE::EdgeManagerClient] Model type not correctly found. Should be one of: {classification OR objectdetection OR segmentation OR undefined OR none}");
           }
+        });
+        releaseInputSlot(input.slot);
+        for (int i=0; input.slot<0 && i<numModels; i++)
+        {
+          input.transforms.push_back(preprocess_plans[i].transform);
         }
 
         if (useGpio)
@@ -366,6 +454,11 @@ namespace edgeml
         // Queue updates
         customResultsNlohmannJson_["inputShape"] = input_tensor_shape;
         customResultsNlohmannJson_["outputShape"] = output_tensor_shape;
+        customResultsNlohmannJson_["inputTransform"] = nlohmann::json::array();
+        for (auto& transform : input.transforms)
+        {
+          customResultsNlohmannJson_["inputTransform"].push_back({{"gainX", transform.gainX}, {"gainY", transform.gainY}, {"padX", transform.padX}, {"padY", transform.padY}});
+        }
         customResultsNlohmannJson_["modelType"] = model_type[0];
         if (model_type[0]=="classification" || model_type[0]=="objectdetection" || model_type[0]=="undefined" || model_type[0]=="none")
         {
@@ -392,6 +485,7 @@ namespace edgeml
         message.em_models_shape_ = input_tensor_shape;
         message.em_results_shape_ = output_tensor_shape;
         message.em_model_type_ = model_type;
+        message.em_models_transform_ = input.transforms;
         message.inferenceEMDetails_.push(outputDataVec);
 
         errc = INFERENCE_OK;
@@ -68,6 +68,11 @@ namespace edgeml
       is_anomaly_overall.resize(numModels);
       confidence_overall.resize(numModels);
       threshold.resize(numModels);
+      replyVec.resize(numModels);
+      imagePreprocessVec.resize(numModels);
+      resizedImageVec.resize(numModels);
+
+      createModelPool(inferIdx, numModels);
 
       #pragma omp parallel for
       for (int i=0; i<numModels; i++)
@@ -189,34 +194,46 @@ namespace edgeml
         bool original_is_anomaly = true;
 
         LOG_ALWAYS("[INFERENCE::LFVEclient] Inference started for model(s)");
-        for (int i=0; i<numModels; i++)
+        // Models are independent, each one sends its own request while the others run on the pool
+        modelPool->run(numModels, [&](int i)
         {
-
           unsigned char* inputImage = message.safeCaptureContainer_.front();
           int inputImageSize = message.safeCaptureSizeContainer_.front();
 
-          if (width!=model_input_width[i] || height!=model_input_height[i])
+          // LFVE takes packed 3 channel images, frames in other formats are converted while resizing
+          int frameFormat = ImagePreProcess::resolvePixelFormat(message.pixelFormat_, colorSpace_);
+          int modelFormat = (colorSpace_=="BGR") ? PIXEL_FORMAT_BGR : PIXEL_FORMAT_RGB;
+          if (width!=model_input_width[i] || height!=model_input_height[i] || frameFormat!=modelFormat)
           {
-            LOG_ALWAYS("[INFERENCE::LFVEclient] Capture image size is different from Model input size");
-            LOG_ALWAYS("[INFERENCE::LFVEclient]     Capture size [HxW] = [" + std::to_string(height) + "," + std::to_string(width) + "]");
-            LOG_ALWAYS("[INFERENCE::LFVEclient]     Model input size [HxW] = [" + std::to_string(model_input_height[i]) + "," + std::to_string(model_input_width[i]) + "]");
+            LOG_ALWAYS("[INFERENCE::LFVEclient] Capture image size or format is different from Model input");
+            LOG_ALWAYS("[INFERENCE::LFVEclient]     Capture size [HxW] = [" + std::to_string(height) + "," + std::to_string(width) + "] in " + std::string(PixelFormatsE[frameFormat]));
+            LOG_ALWAYS("[INFERENCE::LFVEclient]     Model input size [HxW] = [" + std::to_string(model_input_height[i]) + "," + std::to_string(model_input_width[i]) + "] in " + std::string(PixelFormatsE[modelFormat]));
             LOG_ALWAYS("[INFERENCE::LFVEclient] Resizing image based on model input size");
-            unsigned char* outputImage;
-            ret = imagePreprocess.resize(inputImage, width, height, outputImage, model_input_width[i], model_input_height[i], 3);
+            resizedImageVec[i].resize((size_t)(model_input_width[i]) * model_input_height[i] * 3);
+            imagePreprocessVec[i].resize(inputImage, width, height, frameFormat, resizedImageVec[i].data(), model_input_width[i], model_input_height[i], modelFormat);
             inputImageSize = model_input_width[i]*model_input_height[i]*3;
-            inputImage = outputImage;
+            inputImage = resizedImageVec[i].data();
           }
 
-          bitmap.set_width((int) model_input_width[i]);
-          bitmap.set_height((int) model_input_height[i]);
-          bitmap.set_byte_data(inputImage, inputImageSize);
+          AWS::LookoutVision::Bitmap modelBitmap;
+          modelBitmap.set_width((int) model_input_width[i]);
+          modelBitmap.set_height((int) model_input_height[i]);
+          modelBitmap.set_byte_data(inputImage, inputImageSize);
 
           grpc::ClientContext context;
-          request.set_model_component(model_name[i]);
-          request.set_allocated_bitmap(&bitmap);
-          grpc::Status status = stubs[i]->DetectAnomalies(&context, request, &response);
-          reply = response.detect_anomaly_result();
-
+          AWS::LookoutVision::DetectAnomaliesRequest modelRequest;
+          AWS::LookoutVision::DetectAnomaliesResponse modelResponse;
+          modelRequest.set_model_component(model_name[i]);
+          modelRequest.set_allocated_bitmap(&modelBitmap);
+          grpc::Status status = stubs[i]->DetectAnomalies(&context, modelRequest, &modelResponse);
+          replyVec[i] = modelResponse.detect_anomaly_result();
+          modelRequest.release_bitmap();
+        });
+
+        // Results are combined in the order of the models
+        for (int i=0; i<numModels; i++)
+        {
+          reply = replyVec[i];
           is_anomaly_overall[i] = reply.is_anomalous(); // true:anomaly, false:normal
           confidence_overall[i] = reply.confidence(); // confidence
           original_is_anomaly = is_anomaly_overall[i];
@@ -231,7 +248,6 @@ namespace edgeml
 
           anomaly_mask = reply.anomaly_mask(); // output anomaly mask
           anomaliesVec = std::vector<AWS::LookoutVision::Anomaly>(reply.anomalies().begin(), reply.anomalies().end()); // output anomalies
-          lfveBMret = request.release_bitmap();
           is_anomaly = is_anomaly & is_anomaly_overall[i]; // is_anomaly & is_anomaly_overall[i];
           confidence = confidence * confidence_overall[i]; // confidence * confidence_overall[i];
         }
@@ -324,6 +340,8 @@ namespace edgeml
           }
           else
           {
+            resizedMask_.resize((size_t)(width) * height * 3);
+            resizedMask = resizedMask_.data();
             ret = imagePreprocess.resize(reinterpret_cast<unsigned char*>(const_cast<char*>(anomaly_mask.byte_data().c_str())), model_input_width[0], model_input_height[0], resizedMask, width, height, 3);
           }
           LOG_ALWAYS("[INFERENCE::LFVEclient] Mask is detected");
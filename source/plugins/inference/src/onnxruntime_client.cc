@@ -15,6 +15,13 @@ namespace edgeml
   namespace inference
   {
 
+    std::mutex OnnxRuntimeClient::envMtx_;
+    OrtEnv* OnnxRuntimeClient::sharedEnv_ = nullptr;
+    int OnnxRuntimeClient::envUsers_ = 0;
+    std::mutex OnnxRuntimeClient::residentMtx_;
+    std::list<OnnxRuntimeClient*> OnnxRuntimeClient::residentClients_;
+    size_t OnnxRuntimeClient::residentBytes_ = 0;
+
     /**
       Instance of the class
     */
@@ -39,17 +46,30 @@ namespace edgeml
       start_timeout = std::chrono::steady_clock::now();
       LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Inference Name: " + jsonParams_["inference"][inferIdx]["inferName"].as_string());
       useGpio = jsonParams_["useGpio"].as_bool();
-      scaleBy = jsonParams_["preprocess"]["scaleBy"].as_int();
-      int ret = initInfer(inferIdx);
-
-      if (ret == MODEL_FAILURE)
-      {
-        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model failure. Cannot run Inference.");
-      }
+      inferIdx_ = inferIdx;
+      if (jsonParams_["onnxRuntime"]["sessionMemoryBudgetMB"].get_type()==jsonParser::JNUMBER)
+        sessionBudget_ = (size_t)(std::max(jsonParams_["onnxRuntime"]["sessionMemoryBudgetMB"].as_int(), 0)) << 20;
 
       inferenceBaseInferenceResultsNlohmannJson_["inferenceType"] = "onnx";
       inferenceBaseInferenceResultsNlohmannJson_["inferenceResults"] = customResultsNlohmannJson_;
 
+      // New model versions arrive as configchange commands and are loaded by a worker while inference goes on
+      inferName_ = jsonParams_["inference"][inferIdx]["inferName"].as_string();
+      controlSubscription_ = utils::ControlBus::instance()->subscribe([this](const nlohmann::json& command)
+      {
+        if (command.contains("models") && command["models"].is_array())
+          modelSwaps_.produce_message(command);
+      });
+
+      // Stages triggered rarely are only set up when their first frame arrives
+      if (jsonParams_["onnxRuntime"]["lazyLoading"].as_bool() && !isPrewarmed())
+      {
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Models of " + inferName_ + " are loaded on the first frame");
+      }
+      else
+      {
+        startClient();
+      }
     }
 
     /**
@@ -57,11 +77,281 @@ namespace edgeml
     */
     OnnxRuntimeClient::~OnnxRuntimeClient()
     {
-      g_ort->ReleaseValue(outputTensors);
-      g_ort->ReleaseValue(inputTensors);
+      stopPreprocessWorker();
+      utils::ControlBus::instance()->unsubscribe(controlSubscription_);
+
+      // The frames in flight are delivered and the delivery thread stopped before their buffers are released
+      drainAsync();
+      {
+        std::lock_guard<std::mutex> lock(asyncMtx_);
+        stopAsync_ = true;
+      }
+      asyncCv_.notify_all();
+      if (asyncThread_.joinable())
+        asyncThread_.join();
+
+      // A model swap going on is finished, queued swaps are dropped
+      stopSwaps_ = true;
+      modelSwaps_.produce_message(nlohmann::json());
+      if (swapThread_.joinable())
+        swapThread_.join();
+      {
+        std::lock_guard<std::mutex> lock(residentMtx_);
+        auto it = std::find(residentClients_.begin(), residentClients_.end(), this);
+        if (it!=residentClients_.end())
+        {
+          residentClients_.erase(it);
+          residentBytes_ -= sessionBytes_;
+        }
+      }
+      for(OrtIoBinding* binding : ioBindingVec)
+        if (binding!=nullptr)
+          g_ort->ReleaseIoBinding(binding);
+      for(auto& slotBindings : inputSlotBindings)
+        for(OrtIoBinding* binding : slotBindings)
+          if (binding!=nullptr)
+            g_ort->ReleaseIoBinding(binding);
+      for(OrtValue* tensor : outputTensorsVec)
+        g_ort->ReleaseValue(tensor);
+      for(OrtValue* tensor : inputTensorsVec)
+        g_ort->ReleaseValue(tensor);
+      for(auto& modelTensors : extraOutputTensorsVec)
+        for(OrtValue* tensor : modelTensors)
+          if (tensor!=nullptr)
+            g_ort->ReleaseValue(tensor);
+      for(OrtValue* tensor : constantTensors)
+        g_ort->ReleaseValue(tensor);
+      for(auto& slotOutputs : slotAsyncOutputs)
+        for(auto& modelOutputs : slotOutputs)
+          for(OrtValue* tensor : modelOutputs)
+            g_ort->ReleaseValue(tensor);
+      for(auto& slotTensors : inputSlotTensors)
+        for(OrtValue* tensor : slotTensors)
+          g_ort->ReleaseValue(tensor);
       for(OrtSession* sess : ort_session_vec)
-        g_ort->ReleaseSession(sess);
-      g_ort->ReleaseEnv(pOrt_env);
+        if (sess!=nullptr)
+          g_ort->ReleaseSession(sess);
+      if (session_options!=nullptr)
+        g_ort->ReleaseSessionOptions(session_options);
+      releaseSharedEnv();
+    }
+
+    /**
+      Setting up the models of the stage: loading the sessions, allocating the tensors and binding them. The models
+      are warmed up by initInfer, so prewarmed stages only differ in being set up at construction.
+      @return error-code showing if the models could be set up or not
+    */
+    int OnnxRuntimeClient::startClient()
+    {
+      auto start = std::chrono::steady_clock::now();
+      int ret = initInfer(inferIdx_);
+      clientStarted_ = true;
+
+      if (ret == MODEL_FAILURE)
+      {
+        // The models are only partly set up, nothing may run on them
+        clientFailed_ = true;
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model failure. Cannot run Inference.");
+        return ret;
+      }
+      else
+      {
+        sessionBytes_ = getSessionBytes();
+        std::lock_guard<std::mutex> lock(sessionMtx_);
+        sessionsResident_ = true;
+        acquireSessions();
+      }
+      LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Models of " + inferName_ + " are set up in " + std::to_string(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()) + " seconds");
+
+      swapThread_ = std::thread(&OnnxRuntimeClient::runModelSwaps, this);
+      return ret;
+    }
+
+    /**
+      Estimating the memory taken by the sessions of the client by the sizes of its model files
+      @return estimated size in bytes
+    */
+    size_t OnnxRuntimeClient::getSessionBytes()
+    {
+      size_t bytes = 0;
+      std::error_code ec;
+      for (int i=0; i<numModels; i++)
+      {
+        size_t fileSize = (size_t)(std::experimental::filesystem::file_size(model_path[i], ec));
+        bytes += ec ? 0 : fileSize;
+      }
+      return bytes;
+    }
+
+    /**
+      Checking if the stage is loaded and warmed up at construction even with onnxRuntime.lazyLoading, which is the
+      case if onnxRuntime.prewarm is true or lists the name of one of its models
+      @return true if the stage is prewarmed
+    */
+    bool OnnxRuntimeClient::isPrewarmed()
+    {
+      jsonParser::jValue prewarm = jsonParams_["onnxRuntime"]["prewarm"];
+      if (prewarm.get_type()!=jsonParser::JARRAY)
+      {
+        return prewarm.as_bool();
+      }
+      jsonParser::jValue models = jsonParams_["inference"][inferIdx_]["model_ids"];
+      for (int k=0; k<(int)(prewarm.size()); k++)
+      {
+        for (int i=0; i<(int)(models.size()); i++)
+        {
+          if (models[i]["model_name"].as_string()==prewarm[k].as_string())
+            return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+      Making the sessions of the client resident before running a frame, called with sessionMtx_ held. Evicted
+      sessions are loaded again on the buffers the client kept, then the client becomes the most recently used and
+      the least recently used clients are evicted while the sessions of all clients exceed
+      onnxRuntime.sessionMemoryBudgetMB. Clients running or with frames in flight are skipped.
+    */
+    void OnnxRuntimeClient::acquireSessions()
+    {
+      if (!sessionsResident_)
+      {
+        auto start = std::chrono::steady_clock::now();
+        utils::ThreadPool loadPool(std::max(std::min(numModels, (int)(std::thread::hardware_concurrency())), 1));
+        loadPool.run(numModels, [&](int i)
+        {
+          if (ort_session_vec[i]==nullptr)
+            ort_session_vec[i] = createModelSession(i, session_options, session_configs[i]);
+        });
+        for (int i=0; i<numModels; i++)
+        {
+          if (ioBindingVec[i]==nullptr)
+            ioBindingVec[i] = bindTensors(i, inputTensorsVec[i]);
+          for (size_t s=0; s<inputSlotBindings.size(); s++)
+          {
+            if (inputSlotBindings[s][i]==nullptr)
+              inputSlotBindings[s][i] = bindTensors(i, inputSlotTensors[s][i]);
+          }
+        }
+        sessionsResident_ = true;
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Models of " + inferName_ + " are loaded again in " + std::to_string(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()) + " seconds");
+      }
+      if (sessionBudget_==0)
+      {
+        return;
+      }
+
+      std::lock_guard<std::mutex> lock(residentMtx_);
+      auto it = std::find(residentClients_.begin(), residentClients_.end(), this);
+      if (it==residentClients_.end())
+      {
+        residentBytes_ += sessionBytes_;
+      }
+      else
+      {
+        residentClients_.erase(it);
+      }
+      residentClients_.push_front(this);
+
+      auto victim = residentClients_.end();
+      while (residentBytes_>sessionBudget_ && std::prev(victim)!=residentClients_.begin()) // the front is this client
+      {
+        --victim;
+        if ((*victim)->evictSessions())
+        {
+          residentBytes_ -= (*victim)->sessionBytes_;
+          victim = residentClients_.erase(victim);
+        }
+      }
+      if (residentBytes_>sessionBudget_)
+      {
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Sessions of all stages take " + std::to_string(residentBytes_ >> 20) + " MB, over the budget of " + std::to_string(sessionBudget_ >> 20) + " MB");
+      }
+    }
+
+    /**
+      Releasing the sessions and bindings of the client, keeping its tensors so the sessions can be loaded again.
+      Called by other clients with residentMtx_ held, a client running a frame or with frames in flight is not evicted.
+      @return true if the sessions were released
+    */
+    bool OnnxRuntimeClient::evictSessions()
+    {
+      std::unique_lock<std::mutex> lock(sessionMtx_, std::try_to_lock);
+      if (!lock.owns_lock() || !sessionsResident_)
+      {
+        return false;
+      }
+      {
+        std::lock_guard<std::mutex> asyncLock(asyncMtx_);
+        if (asyncLaunched_!=asyncDelivered_)
+          return false;
+      }
+      for (int i=0; i<numModels; i++)
+      {
+        for (auto& slotBindings : inputSlotBindings)
+        {
+          g_ort->ReleaseIoBinding(slotBindings[i]);
+          slotBindings[i] = nullptr;
+        }
+        g_ort->ReleaseIoBinding(ioBindingVec[i]);
+        ioBindingVec[i] = nullptr;
+        g_ort->ReleaseSession(ort_session_vec[i]);
+        ort_session_vec[i] = nullptr;
+      }
+      sessionsResident_ = false;
+      LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Models of " + inferName_ + " are evicted (" + std::to_string(sessionBytes_ >> 20) + " MB)");
+      return true;
+    }
+
+    /**
+      Getting the ONNX Runtime environment shared by all clients of the process. It is created on first use with
+      global intra- and inter-op thread pools sized by onnxRuntime.intraOpThreads and onnxRuntime.interOpThreads of
+      the config, by default one intra-op thread per core and one inter-op thread, so the sessions of all clients share
+      one set of threads instead of each bringing their own.
+      @return the shared environment
+    */
+    OrtEnv* OnnxRuntimeClient::acquireSharedEnv()
+    {
+      std::lock_guard<std::mutex> lock(envMtx_);
+      if (sharedEnv_==nullptr)
+      {
+        jsonParser::jValue onnxRuntime = jsonParams_["onnxRuntime"];
+        int intraOpThreads = (onnxRuntime["intraOpThreads"].get_type()==jsonParser::JNUMBER) ? onnxRuntime["intraOpThreads"].as_int() : 0;
+        int interOpThreads = (onnxRuntime["interOpThreads"].get_type()==jsonParser::JNUMBER) ? onnxRuntime["interOpThreads"].as_int() : 0;
+        if (intraOpThreads<=0)
+        {
+          intraOpThreads = (int)(std::max(std::thread::hardware_concurrency(), 1u));
+        }
+        if (interOpThreads<=0)
+        {
+          interOpThreads = 1;
+        }
+
+        OrtThreadingOptions* threadingOptions = nullptr;
+        CheckStatus(g_ort->CreateThreadingOptions(&threadingOptions));
+        CheckStatus(g_ort->SetGlobalIntraOpNumThreads(threadingOptions, intraOpThreads));
+        CheckStatus(g_ort->SetGlobalInterOpNumThreads(threadingOptions, interOpThreads));
+        CheckStatus(g_ort->CreateEnvWithGlobalThreadPools(ORT_LOGGING_LEVEL_WARNING, "onnx-env", threadingOptions, &sharedEnv_));
+        g_ort->ReleaseThreadingOptions(threadingOptions);
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Shared environment created with " + std::to_string(intraOpThreads) + " intra-op and " + std::to_string(interOpThreads) + " inter-op thread(s)");
+      }
+      envUsers_++;
+      return sharedEnv_;
+    }
+
+    /**
+      Releasing the shared environment, destroyed with its thread pools once the last client is gone
+    */
+    void OnnxRuntimeClient::releaseSharedEnv()
+    {
+      std::lock_guard<std::mutex> lock(envMtx_);
+      if (pOrt_env!=nullptr && --envUsers_==0)
+      {
+        g_ort->ReleaseEnv(sharedEnv_);
+        sharedEnv_ = nullptr;
+      }
+      pOrt_env = nullptr;
     }
 
     /**
@@ -85,30 +375,26 @@ namespace edgeml
     {
       LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient]");
 
-      std::string instanceName = "onnx-env";
       g_ort = OrtGetApiBase()->GetApi(ORT_API_VERSION);
-      CheckStatus(g_ort->CreateEnv(ORT_LOGGING_LEVEL_WARNING, instanceName.c_str(), &pOrt_env));
-      OrtSessionOptions* session_options;
+      pOrt_env = acquireSharedEnv();
 
       CheckStatus(g_ort->CreateSessionOptions(&session_options));
-      CheckStatus(g_ort->SetIntraOpNumThreads(session_options, 1));
-      CheckStatus(g_ort->SetInterOpNumThreads(session_options, 1));
-      CheckStatus(g_ort->SetSessionGraphOptimizationLevel(session_options, ORT_ENABLE_ALL));
+      CheckStatus(g_ort->SetSessionGraphOptimizationLevel(session_options, graphOptimizationLevel));
       CheckStatus(g_ort->DisableMemPattern(session_options));
 
       // If possible, using CUDA to improve performance of ONNX models
-      bool USE_CUDA = false;
+      useCuda = false;
       int provider_length = 0; char** providers;
       CheckStatus(g_ort->GetAvailableProviders(&providers, &provider_length));
       for (int pl=0; pl<provider_length; pl++)
       {
         if (std::string(providers[pl]) == "CUDAExecutionProvider")
         {
-          USE_CUDA = true;
+          useCuda = true;
           break;
         }
       }
-      if (USE_CUDA)
+      if (useCuda)
       {
         LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] GPU FOUND -> USING CUDA");
         OrtCUDAProviderOptionsV2* cuda_options = nullptr;
@@ -123,13 +409,44 @@ namespace edgeml
         LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] NO GPU FOUND -> USING CPU");
       }
 
-      g_ort->ReleaseValue(outputTensors);
-      g_ort->ReleaseValue(inputTensors);
-      OrtStatus* status;
       OrtAllocator* allocator;
       CheckStatus(g_ort->GetAllocatorWithDefaultOptions(&allocator));
 
+      // Optimized graphs are saved once and loaded without optimizing on later starts
+      jsonParser::jValue optimizedCache = jsonParams_["onnxRuntime"]["optimizedModelCache"];
+      if (optimizedCache.get_type()==jsonParser::JSTRING && !optimizedCache.as_string().empty())
+      {
+        optimizedModelDir = optimizedCache.as_string();
+      }
+      else if (optimizedCache.as_bool())
+      {
+        optimizedModelDir = "/var/tmp/edge-ml-accelerator/optimized";
+      }
+      if (!optimizedModelDir.empty())
+      {
+        std::error_code ec;
+        std::experimental::filesystem::create_directories(optimizedModelDir, ec);
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Caching optimized models in " + optimizedModelDir);
+      }
+
       numModels = jsonParams_["inference"][inferIdx]["model_ids"].size();
+
+      // A cascade is checked before any model is loaded, a model can only be gated by an earlier one
+      for (int i=0; i<numModels; i++)
+      {
+        jsonParser::jValue runIf = jsonParams_["inference"][inferIdx]["model_ids"][i]["runIf"];
+        if (runIf.get_type()!=jsonParser::JOBJECT)
+          continue;
+        bool isEarlier = false;
+        for (int j=0; j<i && !isEarlier; j++)
+          isEarlier = (jsonParams_["inference"][inferIdx]["model_ids"][j]["model_name"].as_string()==runIf["model"].as_string());
+        if (!isEarlier)
+        {
+          LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Model " + runIf["model"].as_string() + " gating model " + jsonParams_["inference"][inferIdx]["model_ids"][i]["model_name"].as_string() + " is not an earlier model of the stage");
+          return MODEL_FAILURE;
+        }
+      }
+
       for (int i=0; i<numModels; i++)
       {
         LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Starting the client for model #" + std::to_string(i+1));
@@ -139,34 +456,88 @@ namespace edgeml
         LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] model #" + std::to_string(i+1) + " Name = " + jsonParams_["inference"][inferIdx]["model_ids"][i]["model_name"].as_string());
         LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] model #" + std::to_string(i+1) + " Path = " + jsonParams_["inference"][inferIdx]["model_ids"][i]["model_path"].as_string());
 
-        ort_session_vec.push_back(nullptr);
-        CheckStatus(g_ort->CreateSession(pOrt_env, model_path[i].c_str(), session_options, &ort_session_vec[i]));
+        // Sessions run on the global thread pools of the environment unless the model has its own thread budget
+        OrtSessionConfig sessionConfig;
+        jsonParser::jValue modelConfig = jsonParams_["inference"][inferIdx]["model_ids"][i];
+        int intraOpThreads = (modelConfig["intraOpThreads"].get_type()==jsonParser::JNUMBER) ? modelConfig["intraOpThreads"].as_int() : 0;
+        int interOpThreads = (modelConfig["interOpThreads"].get_type()==jsonParser::JNUMBER) ? modelConfig["interOpThreads"].as_int() : 0;
+        if (intraOpThreads>0 || interOpThreads>0)
+        {
+          sessionConfig.intraOpThreads = std::max(intraOpThreads, 1);
+          sessionConfig.interOpThreads = std::max(interOpThreads, 1);
+          LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model " + model_name[i] + " runs on its own " + std::to_string(sessionConfig.intraOpThreads) + " intra-op and " + std::to_string(sessionConfig.interOpThreads) + " inter-op thread(s)");
+        }
+        session_configs.push_back(sessionConfig);
+      }
+
+      // The sessions are independent and created concurrently, loading and optimizing dominate the start
+      ort_session_vec.assign(numModels, nullptr);
+      utils::ThreadPool loadPool(std::max(std::min(numModels, (int)(std::thread::hardware_concurrency())), 1));
+      loadPool.run(numModels, [&](int i)
+      {
+        ort_session_vec[i] = createModelSession(i, session_options, session_configs[i]);
+      });
 
+      for (int i=0; i<numModels; i++)
+      {
         LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model " + model_name[i] + " is loaded");
 
-        size_t inputDims, outputDims;
+        // All inputs and outputs of the model, the frame goes into the image input and the primary output is the result
+        input_details.push_back(getTensorDetails(ort_session_vec[i], true));
+        output_details.push_back(getTensorDetails(ort_session_vec[i], false));
+        jsonParser::jValue inputsConfig = jsonParams_["inference"][inferIdx]["model_ids"][i]["inputs"];
+        int imageInput = 0;
+        for (int k=0; k<(int)(input_details[i].size()); k++)
+        {
+          if (inputsConfig[input_details[i][k].name].as_string()=="image")
+          {
+            imageInput = k;
+            break;
+          }
+        }
+        int primaryOutput = -1;
+        std::string outputConfig = jsonParams_["inference"][inferIdx]["model_ids"][i]["output"].as_string();
+        for (int k=0; k<(int)(output_details[i].size()) && primaryOutput<0; k++)
+        {
+          if (!outputConfig.empty() && output_details[i][k].name==outputConfig)
+            primaryOutput = k;
+        }
+        for (int k=0; k<(int)(output_details[i].size()) && primaryOutput<0; k++)
+        {
+          if (output_details[i][k].type==ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT && output_details[i][k].elementCount>0)
+            primaryOutput = k;
+        }
+        if (input_details[i].empty() || primaryOutput<0 || output_details[i][primaryOutput].elementCount<=0 || output_details[i][primaryOutput].type!=ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
+        {
+          LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Model " + model_name[i] + " has no float output of fixed shape to return as its result" + (outputConfig.empty() ? std::string("") : " (output " + outputConfig + ")"));
+          return MODEL_FAILURE;
+        }
+        image_input_index.push_back(imageInput);
+        primary_output_index.push_back(primaryOutput);
+        for (auto& details : input_details[i])
+        {
+          LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model Details = (Input Tensor): [" + details.name + "] " + getShapeString(details.shape) + ((&details==&input_details[i][imageInput]) ? " <- image" : ""));
+        }
+        for (auto& details : output_details[i])
+        {
+          LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model Details = (Output Tensor): [" + details.name + "] " + getShapeString(details.shape) + ((&details==&output_details[i][primaryOutput]) ? " -> results" : ""));
+        }
 
-        // Print the Input Tensor Details and store in a vector for future access
-        std::vector<int64_t> input_node_dims;
+        std::vector<int64_t> input_node_dims = input_details[i][imageInput].shape;
         char* inputName;
-        status = g_ort->SessionGetInputName(ort_session_vec[i], 0, allocator, &inputName);
+        CheckStatus(g_ort->SessionGetInputName(ort_session_vec[i], imageInput, allocator, &inputName));
         input_tensor_names.push_back(std::string(inputName));
         inputNames.push_back(inputName);
-        OrtTypeInfo* inputTypeInfo;
-        status = g_ort->SessionGetInputTypeInfo(ort_session_vec[i], 0, &inputTypeInfo);
-        const OrtTensorTypeAndShapeInfo* inputTensorInfo;
-        CheckStatus(g_ort->CastTypeInfoToTensorInfo(inputTypeInfo, &inputTensorInfo));
-        CheckStatus(g_ort->GetDimensionsCount(inputTensorInfo, &inputDims));
-        input_node_dims.resize(inputDims);
-        CheckStatus(g_ort->GetDimensions(inputTensorInfo, (int64_t*)input_node_dims.data(), inputDims));
-        if (input_node_dims[0] < 0) {input_node_dims[0] = 1;};
-        input_tensor_shape.push_back(std::vector<int>(input_node_dims.begin(), input_node_dims.end()));
-        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model Details = (Input Tensor): [" + input_tensor_names[input_tensor_names.size()-1] + "] (");
-        for (int j=0; j<input_node_dims.size()-1; j++)
+        ONNXTensorElementDataType inputType = input_details[i][imageInput].type;
+        if (input_node_dims.size()!=4)
         {
-          LOG_ALWAYS(input_node_dims[j] + ", ");
+          LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Image input " + input_tensor_names[i] + " of model " + model_name[i] + " is not NCHW or NHWC");
+          return MODEL_FAILURE;
         }
-        LOG_ALWAYS(input_node_dims[input_node_dims.size()-1] + ")");
+        // Models with more inputs run frame by frame through their binding, the other inputs have a batch of one
+        is_dynamic_batch_vec.push_back(input_node_dims[0] < 0 && input_details[i].size()==1);
+        if (input_node_dims[0] < 0) {input_node_dims[0] = 1;};
+        input_tensor_shape.push_back(std::vector<int>(input_node_dims.begin(), input_node_dims.end()));
         if (input_node_dims[1]==1 || input_node_dims[1]==2 || input_node_dims[1]==3)
         {
           is_chw_vec.push_back(true);
@@ -178,27 +549,13 @@ namespace edgeml
           LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Input Format = NHWC");
         }
 
-        // Print the Output Tensor Details and store in a vector for future access
-        std::vector<int64_t> output_node_dims;
+        std::vector<int64_t> output_node_dims = output_details[i][primaryOutput].shape;
         char* outputName;
-        status = g_ort->SessionGetOutputName(ort_session_vec[i], 0, allocator, &outputName);
+        CheckStatus(g_ort->SessionGetOutputName(ort_session_vec[i], primaryOutput, allocator, &outputName));
         output_tensor_names.push_back(std::string(outputName));
         outputNames.push_back(outputName);
-        OrtTypeInfo* outputTypeInfo;
-        status = g_ort->SessionGetOutputTypeInfo(ort_session_vec[i], 0, &outputTypeInfo);
-        const OrtTensorTypeAndShapeInfo* outputTensorInfo;
-        CheckStatus(g_ort->CastTypeInfoToTensorInfo(outputTypeInfo, &outputTensorInfo));
-        CheckStatus(g_ort->GetDimensionsCount(outputTensorInfo, &outputDims));
-        output_node_dims.resize(outputDims);
-        CheckStatus(g_ort->GetDimensions(outputTensorInfo, (int64_t*)output_node_dims.data(), outputDims));
         if (output_node_dims[0] < 0) {output_node_dims[0] = 1;};
         output_tensor_shape.push_back(std::vector<int>(output_node_dims.begin(), output_node_dims.end()));
-        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model Details = (Output Tensor): [" + output_tensor_names[output_tensor_names.size()-1] + "] (");
-        for (int j=0; j<output_node_dims.size()-1; j++)
-        {
-          LOG_ALWAYS(output_node_dims[j] + ", ");
-        }
-        LOG_ALWAYS(output_node_dims[output_node_dims.size()-1] + ")");
 
         // Set tensor shapes and sizes
         long int indatasize = 1;
@@ -214,148 +571,2098 @@ namespace edgeml
           input_width[i] = input_tensor_shape[i][3];
           input_channels[i] = input_tensor_shape[i][1];
         }
-        float chardata[indatasize] = {0};
-        inputTensorValues = std::vector<float>(indatasize);
-        std::vector<unsigned char> tmpInputVec(indatasize, 0);
-        inputDataVec.push_back(tmpInputVec);
+        modelInputHeight_ = std::max(modelInputHeight_, input_height[i]);
+        modelInputWidth_ = std::max(modelInputWidth_, input_width[i]);
+
+        // The frames are normalized straight into the input tensor in the layout and element type of the model
+        int tensorType = TENSOR_TYPE_FLOAT32;
+        if (inputType==ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16)
+        {
+          tensorType = TENSOR_TYPE_FLOAT16;
+        }
+        else if (inputType==ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8)
+        {
+          tensorType = TENSOR_TYPE_UINT8;
+        }
+        else if (inputType==ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8)
+        {
+          tensorType = TENSOR_TYPE_INT8;
+        }
+        else if (inputType!=ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
+        {
+          LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Input element type " + std::to_string(inputType) + " of model " + model_name[i] + " is not supported, feeding float32");
+          inputType = ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+        }
+        input_tensor_type.push_back(inputType);
+        preprocess_params.push_back(ImagePreProcess::getPreprocessParams(jsonParams_["preprocess"], is_chw_vec[i] ? TENSOR_LAYOUT_NCHW : TENSOR_LAYOUT_NHWC, tensorType));
+        preprocess_plans.push_back(PreprocessPlan());
+
+        // Masks are channels first when the channel dimension is the smallest one after the batch, the layout of the input decides when the shape does not tell
+        const std::vector<int>& outShape = output_tensor_shape[i];
+        bool outputChw = is_chw_vec[i];
+        if (outShape.size()==4 && outShape[1]<outShape[2] && outShape[1]<outShape[3])
+        {
+          outputChw = true;
+        }
+        else if (outShape.size()==4 && outShape[3]<outShape[1] && outShape[3]<outShape[2])
+        {
+          outputChw = false;
+        }
+        is_chw_output_vec.push_back(outputChw);
+
+        // Frames much larger than the model can be cut into tiles instead of being downscaled
+        TilingParams tiling = ImagePreProcess::getTilingParams(jsonParams_["inference"][inferIdx]["model_ids"][i]["tiling"]);
+        if (tiling.enabled)
+        {
+          tiling.tileWidth = (tiling.tileWidth>0) ? tiling.tileWidth : input_width[i];
+          tiling.tileHeight = (tiling.tileHeight>0) ? tiling.tileHeight : input_height[i];
+          if (model_type[i]!="objectdetection" && model_type[i]!="segmentation")
+          {
+            LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Tiling is only supported for objectdetection and segmentation models, running " + model_name[i] + " on the whole frame");
+            tiling.enabled = false;
+          }
+          else if (model_type[i]=="segmentation" && outShape.size()!=4)
+          {
+            LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Tiling needs an NCHW or NHWC mask output, output " + output_tensor_names[i] + " of " + model_name[i] + " has " + std::to_string(outShape.size()) + " dimensions, running it on the whole frame");
+            tiling.enabled = false;
+          }
+          else
+          {
+            if (!preprocess_params[i].cameraMatrix.empty())
+            {
+              LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Undistortion is not applied to the tiles of " + model_name[i]);
+              preprocess_params[i].cameraMatrix = cv::Mat();
+              preprocess_params[i].distCoeffs = cv::Mat();
+            }
+            LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Tiling frames into [H,W] = [" + std::to_string(tiling.tileHeight) + "," + std::to_string(tiling.tileWidth) + "] with an overlap of " + std::to_string(tiling.overlap) + " for " + model_name[i]);
+          }
+        }
+        tiling_params.push_back(tiling);
+        crop_plans.push_back(std::vector<PreprocessPlan>());
+        inputTensorData.push_back(AlignedVector<unsigned char>((size_t)(indatasize) * ImagePreProcess::getTensorElementSize(tensorType), 0));
         long int outdatasize = 1;
         for (int j = 0; j < output_tensor_shape[i].size(); ++j)
         {
           outdatasize *= output_tensor_shape[i][j];
         }
         output_tensor_size.push_back(outdatasize);
-        output_height.push_back(output_tensor_shape[i][1]); output_width.push_back(output_tensor_shape[i][2]); output_channels.push_back(output_tensor_shape[i][3]);
-        outputTensorValues = std::vector<float>(outdatasize);
+        // Outputs are not necessarily images, missing dimensions count as 1
+        int outputRank = (int)(output_tensor_shape[i].size());
+        output_height.push_back((outputRank>1) ? output_tensor_shape[i][1] : 1); output_width.push_back((outputRank>2) ? output_tensor_shape[i][2] : 1); output_channels.push_back((outputRank>3) ? output_tensor_shape[i][3] : 1);
+        outputTensorValuesVec.push_back(AlignedVector<float>(outdatasize));
+        cropBatchInputVec.push_back(AlignedVector<unsigned char>());
+        cropSourceVec.push_back(cv::Mat());
+        imagePreprocessVec.push_back(utils::ImagePreProcess());
+        resultPostprocessVec.push_back(utils::ResultPostProcess());
         std::vector<float> tmpOutputVec(output_tensor_size[i], 0);
         outputDataVec.push_back(tmpOutputVec);
-        inputNamesVec.push_back(inputNames);
-        outputNamesVec.push_back(outputNames);
+        inputNamesVec.push_back(std::vector<const char*>{inputNames.back()}); // names of this model only
+        outputNamesVec.push_back(std::vector<const char*>{outputNames.back()});
 
         // Create input tensor object from data values
-        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Setting up memory with input(" + std::to_string(indatasize * sizeof(float)) + ") and output(" + std::to_string(outdatasize * sizeof(float)) + ")");
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Setting up memory with input(" + std::to_string(inputTensorData[i].size()) + ") and output(" + std::to_string(outdatasize * sizeof(float)) + ")");
         ort_memory_vec.push_back(nullptr);
         CheckStatus(g_ort->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &ort_memory_vec[i]));
-        CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[i], inputTensorValues.data(), indatasize * sizeof(float), input_node_dims.data(), input_node_dims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &inputTensors));
-        CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[i], outputTensorValues.data(), outdatasize * sizeof(float), output_node_dims.data(), output_node_dims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &outputTensors));
-
-        ret = INFERENCE_OK;
-      }
+        inputTensorsVec.push_back(nullptr);
+        CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[i], inputTensorData[i].data(), inputTensorData[i].size(), input_node_dims.data(), input_node_dims.size(), input_tensor_type[i], &inputTensorsVec[i]));
+        outputTensorsVec.push_back(nullptr);
+        CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[i], outputTensorValuesVec[i].data(), outdatasize * sizeof(float), output_node_dims.data(), output_node_dims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &outputTensorsVec[i]));
 
-      // Warm-up model for 5 inferences
-      for (int iter=0; iter<5; iter++)
-      {
-        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model Warmup : Running Dummy Inference for #" + std::to_string(iter+1) + "/5");
-        for (int i=0; i<numModels; i++)
+        // Every other output of fixed shape gets its own buffer, outputs of dynamic shape are not computed
+        extraOutputDataVec.push_back(std::vector<AlignedVector<unsigned char> >(output_details[i].size()));
+        extraOutputTensorsVec.push_back(std::vector<OrtValue*>(output_details[i].size(), nullptr));
+        for (int k=0; k<(int)(output_details[i].size()); k++)
         {
-          float chardata[input_tensor_size[i]] = {0};
-          inputTensorValues = std::vector<float>(chardata, chardata + input_tensor_size[i]);
-          CheckStatus(g_ort->Run(ort_session_vec[i], NULL, inputNamesVec[i].data(), &inputTensors, 1, outputNamesVec[i].data(), 1, &outputTensors));
+          OrtTensorDetails& details = output_details[i][k];
+          if (k==primaryOutput || details.elementCount<=0 || getOrtElementSize(details.type)==0)
+          {
+            if (k!=primaryOutput)
+              LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Output " + details.name + " of model " + model_name[i] + " has no fixed shape and is not computed");
+            continue;
+          }
+          std::vector<int64_t> dims = details.shape;
+          dims[0] = std::max(dims[0], (int64_t)(1));
+          extraOutputDataVec[i][k].assign((size_t)(details.elementCount) * getOrtElementSize(details.type), 0);
+          CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[i], extraOutputDataVec[i][k].data(), extraOutputDataVec[i][k].size(), dims.data(), dims.size(), details.type, &extraOutputTensorsVec[i][k]));
         }
-      }
 
-      return ret;
-    }
-
-    /**
-      Run inference for EdgeManager for Classification, Object Detection and Segmentation models
-      @param errc returning the error code of capture API
-      @param height height of the input image
-      @param width width of the input image
-      @param iter running for total iterations if > 0 else running infinite loop
-    */
-    void OnnxRuntimeClient::runInference(int& errc, int& height, int& width, int& iter, bool& completed)
-    {
-      while(1)
-      {
-        auto message = camera2ongoing_.GetMessage();
-        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Capture Trigger Message = " + message.captureTrigger_.captureTriggersMessage_);
-        message.inferenceMode_ = InferenceInputModeE::ONNX;
-
-        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient]");
-
-        inference_start_time = std::chrono::steady_clock::now();
-
-        unsigned char* inputImage = message.safeCaptureContainer_.front();
-        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Inference started for model(s)");
-        for (int i=0; i<numModels; i++)
+        // Other inputs are constants or outputs of earlier models of the stage, bound once next to the image input
+        extraInputsVec.push_back(std::vector<std::pair<std::string, OrtValue*> >());
+        model_level.push_back(0);
+        model_sources.push_back(std::vector<int>());
+        for (int k=0; k<(int)(input_details[i].size()); k++)
         {
-          ret = imagePreprocess.resize(inputImage, width, height, inputDataVec[i].data(), input_width[i], input_height[i], input_channels[i]);
-          inputScaled = imagePreprocess.scale(inputDataVec[i], input_width[i], input_height[i], input_channels[i], scaleBy);
-          inputTensorValues = inputScaled;
-
-          CheckStatus(g_ort->Run(ort_session_vec[i], NULL, inputNamesVec[i].data(), &inputTensors, 1, outputNamesVec[i].data(), 1, &outputTensors));
-
-          if (model_type[i]=="classification" || model_type[i]=="objectdetection" || model_type[i]=="segmentation" || model_type[i]=="undefined" || model_type[i]=="none")
+          if (k==imageInput)
+            continue;
+          OrtTensorDetails& details = input_details[i][k];
+          jsonParser::jValue source = inputsConfig[details.name];
+          OrtValue* value = nullptr;
+          if (source["model"].get_type()!=jsonParser::JUNKNOWN)
           {
-            outputDataVec[i] = outputTensorValues;
-            std::transform(model_type[i].begin(), model_type[i].end(), model_type[i].begin(), std::ptr_fun<int, int>(std::toupper));
-            std::transform(model_type[i].begin(), model_type[i].end(), model_type[i].begin(), std::ptr_fun<int, int>(std::tolower));
-            LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Inference results for [" + model_name[i] + "] is completed");
+            value = getModelOutputTensor(i, source["model"].as_string(), source["output"].as_string(), details);
           }
           else
           {
-            LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model type not correctly found. Should be one of: {classification OR objectdetection OR segmentation OR undefined OR none}");
+            value = createConstantTensor(i, details, (source["constant"].get_type()!=jsonParser::JUNKNOWN) ? source["constant"] : source);
+          }
+          if (value==nullptr)
+          {
+            LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Input " + details.name + " of model " + model_name[i] + " cannot be fed");
+            return MODEL_FAILURE;
           }
+          extraInputsVec[i].push_back(std::make_pair(details.name, value));
         }
 
-        if (useGpio)
+        // Cascades: the model only runs on frames where the output of an earlier model meets its condition
+        run_conditions.push_back(RunCondition());
+        jsonParser::jValue runIf = jsonParams_["inference"][inferIdx]["model_ids"][i]["runIf"];
+        if (runIf.get_type()==jsonParser::JOBJECT)
         {
-          // Running GPIO logic here
-          gpioRet = GPIO_FAIL;
-          while (gpioRet==GPIO_FAIL)
+          RunCondition& condition = run_conditions[i];
+          for (int j=0; j<i && condition.sourceModel<0; j++)
+          {
+            if (model_name[j]==runIf["model"].as_string())
+              condition.sourceModel = j;
+          }
+          if (runIf["class"].get_type()==jsonParser::JARRAY)
           {
-            gpioRet = gpio.gpio_setvalue(GPIO_DATA_OUT_1, 1); // Setting the Data Valid Output
+            for (int c=0; c<(int)(runIf["class"].size()); c++)
+              condition.classes.push_back(runIf["class"][c].as_int());
           }
-          gpioRet = GPIO_FAIL;
-          while (gpioRet==GPIO_FAIL)
+          else if (runIf["class"].get_type()==jsonParser::JNUMBER)
           {
-            gpioRet = gpio.gpio_setvalue(GPIO_DATA_OUT_1, 0); // Un-Setting the Data Valid Output
+            condition.classes.push_back(runIf["class"].as_int());
           }
+          if (runIf["minScore"].get_type()==jsonParser::JNUMBER)
+            condition.minScore = runIf["minScore"].as_double();
+          if (runIf["maxScore"].get_type()==jsonParser::JNUMBER)
+            condition.maxScore = runIf["maxScore"].as_double();
+          if (runIf["anomaly"].get_type()==jsonParser::JNUMBER)
+            condition.anomalyThreshold = runIf["anomaly"].as_double();
+          else if (runIf["anomaly"].as_bool())
+            condition.anomalyThreshold = 0.5f;
+          model_level[i] = std::max(model_level[i], model_level[condition.sourceModel] + 1);
+          model_sources[i].push_back(condition.sourceModel);
+          hasCascade = true;
+          LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model " + model_name[i] + " only runs when the output of model " + model_name[condition.sourceModel] + " meets its runIf condition");
         }
 
-        inference_end_time = std::chrono::steady_clock::now();
-        inference_duration = std::chrono::duration_cast<std::chrono::milliseconds>(inference_end_time - inference_start_time);
-
-        // Queue updates
-        customResultsNlohmannJson_["inputShape"] = input_tensor_shape;
-        customResultsNlohmannJson_["outputShape"] = output_tensor_shape;
-        customResultsNlohmannJson_["modelType"] = model_type[0];
-        if (model_type[0]=="classification" || model_type[0]=="objectdetection" || model_type[0]=="undefined" || model_type[0]=="none")
+        // Opt-in: the fastest of several variants of the model (e.g. fp32, int8) agreeing with the configured one
+        jsonParser::jValue variants = jsonParams_["inference"][inferIdx]["model_ids"][i]["variants"];
+        if (variants["models"].get_type()==jsonParser::JARRAY && variants["models"].size()>0)
         {
-          customResultsNlohmannJson_["resultType"] = "json";
-        }
-        else if (model_type[0]=="segmentation")
-        {
-          customResultsNlohmannJson_["resultType"] = "mask";
+          std::string selected = selectModelVariant(i, variants);
+          if (selected!=model_path[i])
+          {
+            g_ort->ReleaseSession(ort_session_vec[i]);
+            model_path[i] = selected;
+            ort_session_vec[i] = createModelSession(i, session_options, session_configs[i]);
+          }
         }
-        else
+
+        // Opt-in: the session settings are tuned on the model itself, the choice is cached per model and machine
+        jsonParser::jValue autotune = jsonParams_["inference"][inferIdx]["autotune"];
+        if (autotune.get_type()==jsonParser::JOBJECT || autotune.as_bool())
         {
-          customResultsNlohmannJson_["resultType"] = "__undefined__";
+          OrtSessionConfig tunedConfig = autotuneSession(i, session_options, session_configs[i], autotune);
+          const OrtSessionConfig& sessionConfig = session_configs[i];
+          if (tunedConfig.intraOpThreads!=sessionConfig.intraOpThreads || tunedConfig.interOpThreads!=sessionConfig.interOpThreads || tunedConfig.parallelExecution!=sessionConfig.parallelExecution || tunedConfig.memPattern!=sessionConfig.memPattern || tunedConfig.cpuArena!=sessionConfig.cpuArena)
+          {
+            g_ort->ReleaseSession(ort_session_vec[i]);
+            ort_session_vec[i] = createModelSession(i, session_options, tunedConfig);
+          }
+          session_configs[i] = tunedConfig;
         }
-        customResultsNlohmannJson_["results"] = outputDataVec;
 
-        inferenceBaseInferenceResultsNlohmannJson_["inferenceResults"] = customResultsNlohmannJson_;
-        inferenceBaseInferenceResultsNlohmannJson_["inferenceTime"] = std::to_string(inference_duration.count());
-        inferenceBaseInferenceResultsNlohmannJson_["framesPerSecond"] = std::to_string(1./inference_duration.count());
-        inferenceBaseInferenceResultsNlohmannJson_["imageLocation"] = "__undefined__";
-        inferenceBaseInferenceResultsNlohmannJson_["resultLocation"] = "__undefined__";
+        ioBindingVec.push_back(bindTensors(i, inputTensorsVec[i])); // preprocessing writes into the bound input, the output is read where the model wrote it
 
-        message.inferenceDetailsMap_["response"] = inferenceBaseInferenceResultsNlohmannJson_;
-        message.inferenceDetailsMap_["numInferencesDone"] = std::to_string(1);
-        message.em_models_shape_ = input_tensor_shape;
-        message.em_results_shape_ = output_tensor_shape;
-        message.em_model_type_ = model_type;
-        message.inferenceEMDetails_.push(outputDataVec);
+        ret = INFERENCE_OK;
+      }
 
-        errc = INFERENCE_OK;
-        start_timeout = std::chrono::steady_clock::now();
-        completed = false;
+      model_skipped.assign(numModels, 0);
+      model_run_times.assign(numModels, 0.0);
 
-        if(produce_output_)
-        {
-          output_inference_.produce_message(message);
-          LOG_ALWAYS("[PIPELINE::GENERAL] Message Size = " + std::to_string(output_inference_.size()));
-        }
+      // Models fed or gated by the outputs of other models run in a later wave than those
+      for (int i=0; i<numModels; i++)
+      {
+        if (model_level[i]>=(int)(modelWaves.size()))
+          modelWaves.resize(model_level[i] + 1);
+        modelWaves[model_level[i]].push_back(i);
+      }
+
+      // Regions of interest: a list for this stage, or true for the regions carried by the message
+      if (jsonParams_["inference"][inferIdx]["rois"].get_type()==jsonParser::JARRAY)
+      {
+        staticRois = ImagePreProcess::getRois(jsonParams_["inference"][inferIdx]["rois"]);
+        useRois = true;
+      }
+      else
+      {
+        useRois = jsonParams_["inference"][inferIdx]["rois"].as_bool();
+      }
+      if (useRois)
+      {
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Inferring " + (staticRois.empty() ? std::string("the regions of interest of each frame") : std::to_string(staticRois.size()) + " regions of interest") + " instead of whole frames");
+      }
+
+      // Detections can be passed on as the regions of interest of the next stage
+      jsonParser::jValue emit = jsonParams_["inference"][inferIdx]["emitRois"];
+      if (emit.get_type()==jsonParser::JOBJECT || emit.as_bool())
+      {
+        emitRois = true;
+        if (emit["scoreThreshold"].get_type()!=jsonParser::JUNKNOWN)
+          emitRoiThreshold = (float)(emit["scoreThreshold"].as_double());
+        if (emit["nmsThreshold"].get_type()!=jsonParser::JUNKNOWN)
+          emitRoiNmsThreshold = (float)(emit["nmsThreshold"].as_double());
+        if (emit["padding"].get_type()==jsonParser::JNUMBER)
+          emitRoiPadding = std::max(emit["padding"].as_int(), 0);
+      }
+
+      readInputBuffers(inferIdx);
+      if (useRois)
+      {
+        numInputBuffers = 1; // regions are preprocessed batch by batch
+      }
+
+      // Whole frames can run with RunAsync, up to asyncRequests frames in flight on their own input and output buffers
+      asyncRequests = 1;
+      if (jsonParams_["inference"][inferIdx]["asyncRequests"].get_type()==jsonParser::JNUMBER)
+        asyncRequests = std::max(jsonParams_["inference"][inferIdx]["asyncRequests"].as_int(), 1);
+      bool anyTiled = std::any_of(tiling_params.begin(), tiling_params.end(), [](const TilingParams& tiling) { return tiling.enabled; });
+      if (asyncRequests>1 && (useRois || anyTiled || modelWaves.size()>1))
+      {
+        LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Stages with regions of interest, tiles or models fed or gated by other models run synchronously");
+        asyncRequests = 1;
+      }
+      if (asyncRequests>1)
+      {
+        numInputBuffers = std::max(numInputBuffers, asyncRequests + 1); // one more buffer to preprocess into
+        for (int i=0; i<numModels; i++)
+        {
+          asyncInputNames.push_back(std::vector<const char*>{inputNamesVec[i][0]});
+          for (auto& extraInput : extraInputsVec[i])
+            asyncInputNames[i].push_back(extraInput.first.c_str());
+          asyncOutputIndex.push_back(std::vector<int>{primary_output_index[i]});
+          for (int k=0; k<(int)(extraOutputTensorsVec[i].size()); k++)
+          {
+            if (extraOutputTensorsVec[i][k]!=nullptr)
+              asyncOutputIndex[i].push_back(k);
+          }
+          asyncOutputNames.push_back(std::vector<const char*>());
+          for (int k : asyncOutputIndex[i])
+            asyncOutputNames[i].push_back(output_details[i][k].name.c_str());
+        }
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Running up to " + std::to_string(asyncRequests) + " frames asynchronously");
+      }
+
+      allocateInputSlots(inputSlotData, inputTensorData);
+      for (int s=0; s<(int)(inputSlotData.size()); s++)
+      {
+        inputSlotTensors.push_back(std::vector<OrtValue*>(numModels, nullptr));
+        inputSlotBindings.push_back(std::vector<OrtIoBinding*>(numModels, nullptr));
+        for (int i=0; i<numModels; i++)
+        {
+          std::vector<int64_t> slotDims(input_tensor_shape[i].begin(), input_tensor_shape[i].end());
+          CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[i], inputSlotData[s][i].data(), inputSlotData[s][i].size(), slotDims.data(), slotDims.size(), input_tensor_type[i], &inputSlotTensors[s][i]));
+          inputSlotBindings[s][i] = bindTensors(i, inputSlotTensors[s][i]);
+        }
+
+        // Frames in flight write their outputs into the buffers of their input slot
+        slotAsyncInputs.push_back(std::vector<std::vector<const OrtValue*> >(numModels));
+        slotAsyncOutputs.push_back(std::vector<std::vector<OrtValue*> >(numModels));
+        slotOutputData.push_back(std::vector<std::vector<AlignedVector<unsigned char> > >(numModels));
+        for (int i=0; asyncRequests>1 && i<numModels; i++)
+        {
+          slotAsyncInputs[s][i].push_back(inputSlotTensors[s][i]);
+          for (auto& extraInput : extraInputsVec[i])
+            slotAsyncInputs[s][i].push_back(extraInput.second);
+          for (int k : asyncOutputIndex[i])
+          {
+            OrtTensorDetails& details = output_details[i][k];
+            std::vector<int64_t> dims = details.shape;
+            dims[0] = std::max(dims[0], (int64_t)(1));
+            slotOutputData[s][i].push_back(AlignedVector<unsigned char>((size_t)(details.elementCount) * getOrtElementSize(details.type), 0));
+            slotAsyncOutputs[s][i].push_back(nullptr);
+            CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[i], slotOutputData[s][i].back().data(), slotOutputData[s][i].back().size(), dims.data(), dims.size(), details.type, &slotAsyncOutputs[s][i].back()));
+          }
+        }
+      }
+      slot_plans = preprocess_plans;
+
+      createModelPool(inferIdx, numModels);
+
+      // Warm-up model for 5 inferences
+      for (int iter=0; iter<5; iter++)
+      {
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model Warmup : Running Dummy Inference for #" + std::to_string(iter+1) + "/5");
+        for (int i=0; i<numModels; i++)
+        {
+          CheckStatus(g_ort->RunWithBinding(ort_session_vec[i], NULL, ioBindingVec[i]));
+        }
+      }
+
+      return ret;
+    }
+
+    /**
+      Binding the image input tensor, the other inputs and the outputs of a model once, so runs neither look up names
+      nor allocate
+      @param modelIndex index of the model
+      @param inputTensor image input tensor over a buffer owned by the client
+      @param session session to bind for, the session of the model if nullptr
+      @return binding to run the model with
+    */
+    OrtIoBinding* OnnxRuntimeClient::bindTensors(int modelIndex, OrtValue* inputTensor, OrtSession* session)
+    {
+      int i = modelIndex;
+      OrtIoBinding* binding = nullptr;
+      CheckStatus(g_ort->CreateIoBinding((session!=nullptr) ? session : ort_session_vec[i], &binding));
+      CheckStatus(g_ort->BindInput(binding, inputNamesVec[i][0], inputTensor));
+      for (auto& extraInput : extraInputsVec[i])
+      {
+        CheckStatus(g_ort->BindInput(binding, extraInput.first.c_str(), extraInput.second));
+      }
+      CheckStatus(g_ort->BindOutput(binding, outputNamesVec[i][0], outputTensorsVec[i]));
+      for (int k=0; k<(int)(extraOutputTensorsVec[i].size()); k++)
+      {
+        if (extraOutputTensorsVec[i][k]!=nullptr)
+          CheckStatus(g_ort->BindOutput(binding, output_details[i][k].name.c_str(), extraOutputTensorsVec[i][k]));
+      }
+      return binding;
+    }
+
+    /**
+      Getting the names, element types and shapes of all inputs or outputs of a session
+      @param session session of the model
+      @param inputs true for the inputs, false for the outputs
+      @return details per input or output, the element count is -1 for shapes with dynamic dimensions besides the batch
+    */
+    std::vector<OrtTensorDetails> OnnxRuntimeClient::getTensorDetails(OrtSession* session, bool inputs)
+    {
+      std::vector<OrtTensorDetails> tensors;
+      OrtAllocator* allocator;
+      CheckStatus(g_ort->GetAllocatorWithDefaultOptions(&allocator));
+      size_t count = 0;
+      CheckStatus(inputs ? g_ort->SessionGetInputCount(session, &count) : g_ort->SessionGetOutputCount(session, &count));
+      for (size_t k=0; k<count; k++)
+      {
+        OrtTensorDetails details;
+        char* name = nullptr;
+        CheckStatus(inputs ? g_ort->SessionGetInputName(session, k, allocator, &name) : g_ort->SessionGetOutputName(session, k, allocator, &name));
+        details.name = std::string(name);
+        CheckStatus(g_ort->AllocatorFree(allocator, name));
+
+        OrtTypeInfo* typeInfo = nullptr;
+        CheckStatus(inputs ? g_ort->SessionGetInputTypeInfo(session, k, &typeInfo) : g_ort->SessionGetOutputTypeInfo(session, k, &typeInfo));
+        const OrtTensorTypeAndShapeInfo* tensorInfo = nullptr;
+        CheckStatus(g_ort->CastTypeInfoToTensorInfo(typeInfo, &tensorInfo));
+        if (tensorInfo!=nullptr) // sequences and maps are left undefined
+        {
+          size_t dims = 0;
+          CheckStatus(g_ort->GetTensorElementType(tensorInfo, &details.type));
+          CheckStatus(g_ort->GetDimensionsCount(tensorInfo, &dims));
+          details.shape.resize(dims);
+          CheckStatus(g_ort->GetDimensions(tensorInfo, details.shape.data(), dims));
+          details.elementCount = 1;
+          for (size_t d=0; d<dims; d++)
+          {
+            if (details.shape[d]<0 && d>0)
+            {
+              details.elementCount = -1;
+              break;
+            }
+            details.elementCount *= std::max(details.shape[d], (int64_t)(1));
+          }
+        }
+        g_ort->ReleaseTypeInfo(typeInfo);
+        tensors.push_back(details);
+      }
+      return tensors;
+    }
+
+    /**
+      Getting the shape of a tensor as text for the logs
+      @param shape dimensions, negative for dynamic ones
+      @return shape like (1, 3, 640, 640)
+    */
+    std::string OnnxRuntimeClient::getShapeString(const std::vector<int64_t>& shape)
+    {
+      std::string text = "(";
+      for (size_t d=0; d<shape.size(); d++)
+      {
+        text += ((d>0) ? ", " : "") + ((shape[d]<0) ? std::string("?") : std::to_string(shape[d]));
+      }
+      return text + ")";
+    }
+
+    /**
+      Getting the size of a tensor element
+      @param type ONNX element type
+      @return size in bytes, 0 for strings and undefined types
+    */
+    size_t OnnxRuntimeClient::getOrtElementSize(ONNXTensorElementDataType type)
+    {
+      switch (type)
+      {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+          return 1;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16:
+          return 2;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32:
+          return 4;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64:
+          return 8;
+        default:
+          return 0;
+      }
+    }
+
+    /**
+      Getting the bound output of an earlier model of the stage to feed an input of a model without a copy
+      @param modelIndex index of the model the input belongs to
+      @param sourceModel name of the earlier model
+      @param sourceOutput name of its output, its primary output if empty
+      @param details the input to feed
+      @return the output tensor, nullptr if there is no such output or it does not match the input
+    */
+    OrtValue* OnnxRuntimeClient::getModelOutputTensor(int modelIndex, const std::string& sourceModel, const std::string& sourceOutput, const OrtTensorDetails& details)
+    {
+      int i = modelIndex;
+      for (int j=0; j<i; j++)
+      {
+        if (model_name[j]!=sourceModel)
+          continue;
+        int k = primary_output_index[j];
+        for (int o=0; !sourceOutput.empty() && o<(int)(output_details[j].size()); o++)
+        {
+          if (output_details[j][o].name==sourceOutput)
+            k = o;
+        }
+        OrtValue* value = (k==primary_output_index[j]) ? outputTensorsVec[j] : extraOutputTensorsVec[j][k];
+        if (value==nullptr || output_details[j][k].type!=details.type || (details.elementCount>0 && output_details[j][k].elementCount!=details.elementCount))
+        {
+          LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Output " + output_details[j][k].name + " of model " + sourceModel + " does not match input " + details.name + " of model " + model_name[i]);
+          return nullptr;
+        }
+        model_level[i] = std::max(model_level[i], model_level[j] + 1);
+        model_sources[i].push_back(j);
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Input " + details.name + " of model " + model_name[i] + " is fed by output " + output_details[j][k].name + " of model " + sourceModel);
+        return value;
+      }
+      LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Model " + sourceModel + " feeding input " + details.name + " of model " + model_name[i] + " is not an earlier model of the stage");
+      return nullptr;
+    }
+
+    /**
+      Creating a constant input tensor, the values are repeated over the tensor so a single value fills all of it
+      @param modelIndex index of the model
+      @param details the input to feed, dynamic dimensions are set to 1
+      @param values a number or a list of numbers, zeros if missing
+      @return the tensor, nullptr for element types that cannot be filled
+    */
+    OrtValue* OnnxRuntimeClient::createConstantTensor(int modelIndex, const OrtTensorDetails& details, utils::jsonParser::jValue values)
+    {
+      size_t elementSize = getOrtElementSize(details.type);
+      if (elementSize==0)
+      {
+        return nullptr;
+      }
+      std::vector<int64_t> dims = details.shape;
+      size_t count = 1;
+      for (auto& dim : dims)
+      {
+        dim = std::max(dim, (int64_t)(1));
+        count *= (size_t)(dim);
+      }
+      std::vector<double> numbers;
+      if (values.get_type()==jsonParser::JARRAY)
+      {
+        for (int v=0; v<values.size(); v++)
+          numbers.push_back(values[v].as_double());
+      }
+      else if (values.get_type()==jsonParser::JNUMBER)
+      {
+        numbers.push_back(values.as_double());
+      }
+
+      constantDataVec.push_back(AlignedVector<unsigned char>(count * elementSize, 0));
+      unsigned char* data = constantDataVec.back().data();
+      for (size_t e=0; e<count && !numbers.empty(); e++)
+      {
+        double v = numbers[e % numbers.size()];
+        switch (details.type)
+        {
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL: ((bool*)(data))[e] = (v!=0.0); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8: ((int8_t*)(data))[e] = cv::saturate_cast<schar>(v); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8: ((uint8_t*)(data))[e] = cv::saturate_cast<uchar>(v); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: { cv::float16_t h((float)(v)); memcpy(data + e * 2, &h, 2); break; }
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16: ((int16_t*)(data))[e] = cv::saturate_cast<short>(v); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16: ((uint16_t*)(data))[e] = cv::saturate_cast<ushort>(v); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT: ((float*)(data))[e] = (float)(v); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32: ((int32_t*)(data))[e] = (int32_t)(v); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32: ((uint32_t*)(data))[e] = (uint32_t)(v); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE: ((double*)(data))[e] = v; break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64: ((int64_t*)(data))[e] = (int64_t)(v); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64: ((uint64_t*)(data))[e] = (uint64_t)(v); break;
+          default: break;
+        }
+      }
+
+      OrtValue* value = nullptr;
+      CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[modelIndex], data, count * elementSize, dims.data(), dims.size(), details.type, &value));
+      constantTensors.push_back(value);
+      LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Input " + details.name + " of model " + model_name[modelIndex] + " is a constant " + getShapeString(dims));
+      return value;
+    }
+
+    /**
+      Getting the values of an output as floats for the results
+      @param data buffer of the output
+      @param details the output
+      @return the values, empty for element types without a numeric value
+    */
+    std::vector<float> OnnxRuntimeClient::getOutputValues(const unsigned char* data, const OrtTensorDetails& details)
+    {
+      std::vector<float> values((size_t)(std::max(details.elementCount, (long int)(0))));
+      for (size_t e=0; e<values.size(); e++)
+      {
+        switch (details.type)
+        {
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL: values[e] = ((const bool*)(data))[e] ? 1.0f : 0.0f; break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8: values[e] = ((const int8_t*)(data))[e]; break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8: values[e] = ((const uint8_t*)(data))[e]; break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: { cv::float16_t h; memcpy(&h, data + e * 2, 2); values[e] = (float)(h); break; }
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16: values[e] = ((const int16_t*)(data))[e]; break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16: values[e] = ((const uint16_t*)(data))[e]; break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT: values[e] = ((const float*)(data))[e]; break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32: values[e] = (float)(((const int32_t*)(data))[e]); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32: values[e] = (float)(((const uint32_t*)(data))[e]); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE: values[e] = (float)(((const double*)(data))[e]); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64: values[e] = (float)(((const int64_t*)(data))[e]); break;
+          case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64: values[e] = (float)(((const uint64_t*)(data))[e]); break;
+          default: return std::vector<float>();
+        }
+      }
+      return values;
+    }
+
+    /**
+      Cloning the options common to all sessions of the client and applying the settings of one session
+      @param baseOptions options with the graph optimization level and execution providers
+      @param config thread budget, execution mode, memory pattern and arena of the session
+      @return options to create the session with, released by the caller
+    */
+    OrtSessionOptions* OnnxRuntimeClient::createSessionOptions(OrtSessionOptions* baseOptions, const OrtSessionConfig& config)
+    {
+      OrtSessionOptions* options = nullptr;
+      CheckStatus(g_ort->CloneSessionOptions(baseOptions, &options));
+      if (config.intraOpThreads>0 || config.interOpThreads>0)
+      {
+        CheckStatus(g_ort->SetIntraOpNumThreads(options, std::max(config.intraOpThreads, 1)));
+        CheckStatus(g_ort->SetInterOpNumThreads(options, std::max(config.interOpThreads, 1)));
+      }
+      else
+      {
+        CheckStatus(g_ort->DisablePerSessionThreads(options));
+      }
+      CheckStatus(g_ort->SetSessionExecutionMode(options, config.parallelExecution ? ORT_PARALLEL : ORT_SEQUENTIAL));
+      CheckStatus(config.memPattern ? g_ort->EnableMemPattern(options) : g_ort->DisableMemPattern(options));
+      CheckStatus(config.cpuArena ? g_ort->EnableCpuMemArena(options) : g_ort->DisableCpuMemArena(options));
+      return options;
+    }
+
+    /**
+      Timing a model with the given session settings on the current content of its input tensor. The session is
+      created for the measurement only, settings the model cannot run with are skipped.
+      @param modelIndex index of the model
+      @param baseOptions options common to all sessions
+      @param config session settings to time
+      @param iterations number of timed runs after 3 warm-up runs
+      @param latency scoring the 90th percentile of the runs if true, else their mean
+      @return score in seconds, negative if the session could not run
+    */
+    double OnnxRuntimeClient::benchmarkSession(int modelIndex, OrtSessionOptions* baseOptions, const OrtSessionConfig& config, int iterations, bool latency)
+    {
+      int i = modelIndex;
+      OrtSession* session = nullptr;
+      OrtIoBinding* binding = nullptr;
+      std::vector<double> runTimes;
+      try
+      {
+        session = createModelSession(i, baseOptions, config);
+        binding = bindTensors(i, inputTensorsVec[i], session);
+        for (int iter=0; iter<3+iterations; iter++)
+        {
+          auto start = std::chrono::steady_clock::now();
+          CheckStatus(g_ort->RunWithBinding(session, NULL, binding));
+          if (iter>=3)
+          {
+            runTimes.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+          }
+        }
+      }
+      catch (const std::runtime_error& e)
+      {
+        runTimes.clear();
+      }
+      if (binding!=nullptr) g_ort->ReleaseIoBinding(binding);
+      if (session!=nullptr) g_ort->ReleaseSession(session);
+
+      if (runTimes.empty())
+      {
+        return -1.0;
+      }
+      if (latency)
+      {
+        auto p90 = runTimes.begin() + (runTimes.size() * 9) / 10;
+        std::nth_element(runTimes.begin(), p90, runTimes.end());
+        return *p90;
+      }
+      return std::accumulate(runTimes.begin(), runTimes.end(), 0.0) / runTimes.size();
+    }
+
+    /**
+      Creating the session of a model. With onnxRuntime.optimizedModelCache the graph optimized by the first start
+      is saved under a key of the model file, ONNX Runtime version, execution provider and machine, and later starts
+      load it with graph optimization off. The optimized graph is written to a temporary file and renamed, so clients
+      starting together never read a partial file.
+      @param modelIndex index of the model
+      @param baseOptions options common to all sessions
+      @param config settings of the session
+      @param path model file to load, the configured one of the model if empty
+      @return the session, throwing if the model cannot be loaded
+    */
+    OrtSession* OnnxRuntimeClient::createModelSession(int modelIndex, OrtSessionOptions* baseOptions, const OrtSessionConfig& config, const std::string& path)
+    {
+      int i = modelIndex;
+      std::string modelPath = path.empty() ? model_path[i] : path;
+      std::string optimizedPath, tmpPath;
+      if (!optimizedModelDir.empty())
+      {
+        optimizedPath = optimizedModelDir + "/" + getModelHash(modelPath) + "-" + getMachineHash() + "-ort" + std::string(OrtGetApiBase()->GetVersionString()) + (useCuda ? "-cuda" : "-cpu") + "-" + getSessionKey(config) + ".onnx";
+      }
+
+      OrtSessionOptions* options = createSessionOptions(baseOptions, config);
+      OrtSession* session = nullptr;
+      OrtStatus* status = nullptr;
+      if (!optimizedPath.empty() && std::ifstream(optimizedPath).good())
+      {
+        CheckStatus(g_ort->SetSessionGraphOptimizationLevel(options, ORT_DISABLE_ALL));
+        status = g_ort->CreateSession(pOrt_env, optimizedPath.c_str(), options, &session);
+        if (status==NULL)
+        {
+          g_ort->ReleaseSessionOptions(options);
+          LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model " + model_name[i] + " is loaded from the optimized model " + optimizedPath);
+          return session;
+        }
+        LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Optimized model " + optimizedPath + " cannot be loaded, optimizing " + modelPath + " again: " + std::string(g_ort->GetErrorMessage(status)));
+        g_ort->ReleaseStatus(status);
+        std::remove(optimizedPath.c_str());
+        g_ort->ReleaseSessionOptions(options);
+        options = createSessionOptions(baseOptions, config);
+      }
+
+      if (!optimizedPath.empty())
+      {
+        tmpPath = optimizedPath + "." + std::to_string(getpid()) + "-" + std::to_string((uintptr_t)(this)) + "-" + std::to_string(i) + ".tmp";
+        CheckStatus(g_ort->SetOptimizedModelFilePath(options, tmpPath.c_str()));
+      }
+      status = g_ort->CreateSession(pOrt_env, modelPath.c_str(), options, &session);
+      g_ort->ReleaseSessionOptions(options);
+      CheckStatus(status);
+
+      if (!tmpPath.empty())
+      {
+        if (std::rename(tmpPath.c_str(), optimizedPath.c_str())==0)
+        {
+          LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Optimized model of " + model_name[i] + " is saved to " + optimizedPath);
+        }
+        else
+        {
+          LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Could not save the optimized model of " + model_name[i] + " to " + optimizedPath);
+          std::remove(tmpPath.c_str());
+        }
+      }
+      return session;
+    }
+
+    /**
+      Getting the key of the options an optimized graph depends on: the graph optimization level and the settings of
+      the session
+      @param config settings of the session
+      @return key for file names, e.g. opt99-t0x0-seq-mp0-arena1
+    */
+    std::string OnnxRuntimeClient::getSessionKey(const OrtSessionConfig& config)
+    {
+      return "opt" + std::to_string((int)(graphOptimizationLevel)) + "-t" + std::to_string(config.intraOpThreads) + "x" + std::to_string(config.interOpThreads) + (config.parallelExecution ? "-par" : "-seq") + "-mp" + std::to_string((int)(config.memPattern)) + "-arena" + std::to_string((int)(config.cpuArena));
+    }
+
+    /**
+      Getting the FNV-1a hash of a model file, computed again when the size or modification time of the file changes,
+      e.g. when a new model version replaces the file
+      @param path model file
+      @return hash as 16 hex digits
+    */
+    std::string OnnxRuntimeClient::getModelHash(const std::string& path)
+    {
+      std::error_code ec;
+      long long fileSize = (long long)(std::experimental::filesystem::file_size(path, ec));
+      long long fileTime = ec ? 0 : (long long)(std::experimental::filesystem::last_write_time(path, ec).time_since_epoch().count());
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto cached = model_hash.find(path);
+        if (cached!=model_hash.end() && cached->second.size==fileSize && cached->second.mtime==fileTime)
+          return cached->second.hash;
+      }
+      {
+        uint64_t hash = 14695981039346656037ull;
+        std::ifstream modelFile(path, std::ios::binary);
+        std::vector<char> chunk(1 << 20);
+        while (modelFile.read(chunk.data(), chunk.size()) || modelFile.gcount()>0)
+        {
+          for (std::streamsize k=0; k<modelFile.gcount(); k++)
+          {
+            hash = (hash ^ (unsigned char)(chunk[k])) * 1099511628211ull;
+          }
+        }
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)(hash));
+        std::lock_guard<std::mutex> lock(mtx_);
+        model_hash[path] = ModelFileHash{fileSize, fileTime, hex};
+        return model_hash[path].hash;
+      }
+    }
+
+    /**
+      Getting the FNV-1a hash of the CPU model and its core count, tuned settings and optimized graphs
+      depend on the machine they were made on
+      @return hash as 16 hex digits
+    */
+    std::string OnnxRuntimeClient::getMachineHash()
+    {
+      std::string cpuModel = "unknown";
+      std::ifstream cpuInfo("/proc/cpuinfo");
+      std::string line;
+      while (getline(cpuInfo, line))
+      {
+        if (line.rfind("model name", 0)==0 && line.find(':')!=std::string::npos)
+        {
+          cpuModel = line.substr(line.find(':') + 1);
+          break;
+        }
+      }
+      cpuModel += "/" + std::to_string(std::thread::hardware_concurrency());
+
+      uint64_t hash = 14695981039346656037ull;
+      for (char c : cpuModel)
+      {
+        hash = (hash ^ (unsigned char)(c)) * 1099511628211ull;
+      }
+      char hex[17];
+      snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)(hash));
+      return std::string(hex);
+    }
+
+    /**
+      Picking the fastest session settings of a model for the latency or throughput objective. The model runs on
+      synthetic noise, the settings are searched one at a time (threads and execution mode, then memory pattern,
+      then arena) and the choice is cached in autotune.cacheDir per model, machine, ONNX Runtime version and
+      execution provider, so later starts skip tuning.
+      @param modelIndex index of the model, its session and tensors are set up
+      @param baseOptions options common to all sessions
+      @param initial settings of the config, kept if no candidate is faster
+      @param autotune true or {"objective": "latency" | "throughput", "iterations": 20, "cacheDir": "..."}
+      @return settings to create the session with
+    */
+    OrtSessionConfig OnnxRuntimeClient::autotuneSession(int modelIndex, OrtSessionOptions* baseOptions, const OrtSessionConfig& initial, utils::jsonParser::jValue autotune)
+    {
+      int i = modelIndex;
+      std::string objective = (autotune["objective"].as_string()=="throughput") ? "throughput" : "latency";
+      int iterations = (autotune["iterations"].get_type()==jsonParser::JNUMBER && autotune["iterations"].as_int()>0) ? autotune["iterations"].as_int() : 20;
+      std::string cacheDir = autotune["cacheDir"].as_string().empty() ? "/var/tmp/edge-ml-accelerator/autotune" : autotune["cacheDir"].as_string();
+      std::string cacheFile = cacheDir + "/" + getModelHash(model_path[i]) + "-" + getMachineHash() + "-ort" + std::string(OrtGetApiBase()->GetVersionString()) + (useCuda ? "-cuda" : "-cpu") + "-" + objective + ".json";
+
+      OrtSessionConfig best = initial;
+      std::ifstream cached(cacheFile);
+      if (cached.good())
+      {
+        std::string cachedStr((std::istreambuf_iterator<char>(cached)), std::istreambuf_iterator<char>());
+        jsonParser::jValue j = jsonParser::parser::parse(cachedStr);
+        best.intraOpThreads = (j["intraOpThreads"].get_type()==jsonParser::JNUMBER) ? j["intraOpThreads"].as_int() : initial.intraOpThreads;
+        best.interOpThreads = (j["interOpThreads"].get_type()==jsonParser::JNUMBER) ? j["interOpThreads"].as_int() : initial.interOpThreads;
+        best.parallelExecution = j["parallelExecution"].as_bool();
+        best.memPattern = j["memPattern"].as_bool();
+        best.cpuArena = j["cpuArena"].as_bool();
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Using the tuned session settings of " + model_name[i] + " from " + cacheFile);
+        return best;
+      }
+
+      LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Tuning the session settings of " + model_name[i] + " for " + objective);
+      cv::Mat noise(cv::Size(input_width[i], input_height[i]), CV_8UC3);
+      cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(255));
+      PreprocessPlan plan;
+      imagePreprocessVec[i].resizeNormalize(noise.data, noise.cols, noise.rows, PIXEL_FORMAT_RGB, input_width[i], input_height[i], getModelPixelFormat(i), preprocess_params[i], plan, inputTensorData[i].data());
+
+      bool latency = (objective=="latency");
+      double bestScore = benchmarkSession(i, baseOptions, best, iterations, latency);
+      auto tryCandidate = [&](const OrtSessionConfig& candidate)
+      {
+        double score = benchmarkSession(i, baseOptions, candidate, iterations, latency);
+        if (score>=0 && (bestScore<0 || score<bestScore))
+        {
+          best = candidate;
+          bestScore = score;
+        }
+      };
+
+      // Threads and execution mode: the global pools, or an own pool of 1, half or all cores
+      int cores = (int)(std::max(std::thread::hardware_concurrency(), 1u));
+      std::vector<int> threadCounts{0, 1, cores / 2, cores};
+      std::sort(threadCounts.begin(), threadCounts.end());
+      threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+      OrtSessionConfig base = best;
+      for (int threads : threadCounts)
+      {
+        for (int parallel=0; parallel<((threads>0 && cores>1) ? 2 : 1); parallel++)
+        {
+          OrtSessionConfig candidate = base;
+          candidate.intraOpThreads = threads;
+          candidate.interOpThreads = (threads>0) ? (parallel ? 2 : 1) : 0;
+          candidate.parallelExecution = (parallel==1);
+          if (candidate.intraOpThreads==base.intraOpThreads && candidate.interOpThreads==base.interOpThreads && candidate.parallelExecution==base.parallelExecution)
+          {
+            continue; // already timed
+          }
+          tryCandidate(candidate);
+        }
+      }
+      OrtSessionConfig candidate = best;
+      candidate.memPattern = !best.memPattern;
+      tryCandidate(candidate);
+      candidate = best;
+      candidate.cpuArena = !best.cpuArena;
+      tryCandidate(candidate);
+
+      LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Tuned " + model_name[i] + ": " + (best.intraOpThreads>0 ? std::to_string(best.intraOpThreads) + " intra-op and " + std::to_string(best.interOpThreads) + " inter-op thread(s)" : std::string("global thread pools")) + ", " + (best.parallelExecution ? "parallel" : "sequential") + " execution, memory pattern " + (best.memPattern ? "on" : "off") + ", arena " + (best.cpuArena ? "on" : "off") + " (" + std::to_string(bestScore * 1000.0) + " ms)");
+
+      nlohmann::json tuned;
+      tuned["model"] = model_path[i];
+      tuned["objective"] = objective;
+      tuned["intraOpThreads"] = best.intraOpThreads;
+      tuned["interOpThreads"] = best.interOpThreads;
+      tuned["parallelExecution"] = best.parallelExecution;
+      tuned["memPattern"] = best.memPattern;
+      tuned["cpuArena"] = best.cpuArena;
+      tuned["score"] = bestScore;
+      std::error_code ec;
+      std::experimental::filesystem::create_directories(cacheDir, ec);
+      std::ofstream out(cacheFile);
+      if (bestScore<0 || !out.good())
+      {
+        LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Could not cache the tuned session settings in " + cacheFile);
+        return best;
+      }
+      out << tuned.dump(4);
+      return best;
+    }
+
+    /**
+      Picking the fastest variant of a model whose results agree with the configured model, the reference. All
+      variants run on the images of variants.calibrationDir (synthetic noise if there are none): the primary output
+      of every image is compared to the one of the reference by its relative L2 error and the variants within the
+      tolerance are timed at the 90th percentile of their runs. The choice is cached in variants.cacheDir per model
+      files, tolerance and machine, so later starts skip the measurement.
+      @param modelIndex index of the model, its session and tensors are set up
+      @param variants {"models": ["model_int8.onnx"], "tolerance": 0.01, "calibrationDir": "...", "iterations": 20, "cacheDir": "..."}
+      @return model file to run, the reference if no variant is faster within the tolerance
+    */
+    std::string OnnxRuntimeClient::selectModelVariant(int modelIndex, utils::jsonParser::jValue variants)
+    {
+      int i = modelIndex;
+      double tolerance = (variants["tolerance"].get_type()==jsonParser::JNUMBER) ? variants["tolerance"].as_double() : 0.01;
+      int iterations = (variants["iterations"].get_type()==jsonParser::JNUMBER && variants["iterations"].as_int()>0) ? variants["iterations"].as_int() : 20;
+      std::string cacheDir = variants["cacheDir"].as_string().empty() ? "/var/tmp/edge-ml-accelerator/variants" : variants["cacheDir"].as_string();
+      std::vector<std::string> candidates{model_path[i]};
+      for (int v=0; v<(int)(variants["models"].size()); v++)
+      {
+        candidates.push_back(variants["models"][v].as_string());
+      }
+
+      // The cache is keyed by the content of every candidate, not only the reference
+      std::string key = std::to_string(tolerance) + "/" + getMachineHash();
+      for (auto& candidate : candidates)
+      {
+        key += "/" + getModelHash(candidate);
+      }
+      uint64_t hash = 14695981039346656037ull;
+      for (char c : key)
+      {
+        hash = (hash ^ (unsigned char)(c)) * 1099511628211ull;
+      }
+      char hex[17];
+      snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)(hash));
+      std::string cacheFile = cacheDir + "/" + getModelHash(model_path[i]) + "-" + std::string(hex) + ".json";
+
+      std::ifstream cached(cacheFile);
+      if (cached.good())
+      {
+        std::string cachedStr((std::istreambuf_iterator<char>(cached)), std::istreambuf_iterator<char>());
+        jsonParser::jValue j = jsonParser::parser::parse(cachedStr);
+        std::string selected = j["selected"].as_string();
+        if (std::find(candidates.begin(), candidates.end(), selected)!=candidates.end())
+        {
+          LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Using variant " + selected + " of " + model_name[i] + " from " + cacheFile);
+          return selected;
+        }
+      }
+
+      // Calibration images, preprocessed once into the input tensor of every run
+      std::vector<AlignedVector<unsigned char> > calibrationInputs;
+      std::string calibrationDir = variants["calibrationDir"].as_string();
+      std::error_code ec;
+      if (!calibrationDir.empty() && std::experimental::filesystem::is_directory(calibrationDir, ec))
+      {
+        std::vector<std::string> files;
+        for (auto& entry : std::experimental::filesystem::directory_iterator(calibrationDir, ec))
+        {
+          files.push_back(entry.path().string());
+        }
+        std::sort(files.begin(), files.end());
+        for (auto& file : files)
+        {
+          cv::Mat image = cv::imread(file, cv::IMREAD_COLOR);
+          if (image.empty())
+            continue;
+          PreprocessPlan plan;
+          imagePreprocessVec[i].resizeNormalize(image.data, image.cols, image.rows, PIXEL_FORMAT_BGR, input_width[i], input_height[i], getModelPixelFormat(i), preprocess_params[i], plan, inputTensorData[i].data());
+          calibrationInputs.push_back(inputTensorData[i]);
+        }
+      }
+      if (calibrationInputs.empty())
+      {
+        LOG_ERROR("[INFERENCE::OnnxRuntimeClient] No calibration images in \"" + calibrationDir + "\", comparing the variants of " + model_name[i] + " on synthetic noise");
+        cv::Mat noise(cv::Size(input_width[i], input_height[i]), CV_8UC3);
+        cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(255));
+        PreprocessPlan plan;
+        imagePreprocessVec[i].resizeNormalize(noise.data, noise.cols, noise.rows, PIXEL_FORMAT_RGB, input_width[i], input_height[i], getModelPixelFormat(i), preprocess_params[i], plan, inputTensorData[i].data());
+        calibrationInputs.push_back(inputTensorData[i]);
+      }
+
+      // Every candidate runs on the bound input and output of the model
+      std::vector<std::vector<float> > referenceOutputs;
+      std::string selected = model_path[i];
+      double selectedScore = -1.0;
+      nlohmann::json measured = nlohmann::json::array();
+      for (int c=0; c<(int)(candidates.size()); c++)
+      {
+        OrtSession* session = nullptr;
+        OrtIoBinding* binding = nullptr;
+        std::vector<double> runTimes;
+        double error = 0.0;
+        try
+        {
+          session = (c==0) ? ort_session_vec[i] : createModelSession(i, session_options, session_configs[i], candidates[c]);
+          if (!hasModelSignature(i, session))
+          {
+            throw std::runtime_error("inputs or outputs differ from " + model_path[i]);
+          }
+          binding = bindTensors(i, inputTensorsVec[i], session);
+          double diffSum = 0.0, refSum = 0.0;
+          for (size_t k=0; k<calibrationInputs.size(); k++)
+          {
+            std::copy(calibrationInputs[k].begin(), calibrationInputs[k].end(), inputTensorData[i].begin());
+            CheckStatus(g_ort->RunWithBinding(session, NULL, binding));
+            if (c==0)
+            {
+              referenceOutputs.push_back(std::vector<float>(outputTensorValuesVec[i].begin(), outputTensorValuesVec[i].end()));
+              continue;
+            }
+            for (size_t e=0; e<referenceOutputs[k].size(); e++)
+            {
+              double diff = (double)(outputTensorValuesVec[i][e]) - referenceOutputs[k][e];
+              diffSum += diff * diff;
+              refSum += (double)(referenceOutputs[k][e]) * referenceOutputs[k][e];
+            }
+          }
+          error = (c==0) ? 0.0 : std::sqrt(diffSum / std::max(refSum, 1e-12));
+          for (int iter=0; iter<iterations && error<=tolerance; iter++)
+          {
+            std::copy(calibrationInputs[iter % calibrationInputs.size()].begin(), calibrationInputs[iter % calibrationInputs.size()].end(), inputTensorData[i].begin());
+            auto start = std::chrono::steady_clock::now();
+            CheckStatus(g_ort->RunWithBinding(session, NULL, binding));
+            runTimes.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+          }
+        }
+        catch (const std::runtime_error& e)
+        {
+          LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Variant " + candidates[c] + " of " + model_name[i] + " cannot run: " + std::string(e.what()));
+          error = -1.0;
+          runTimes.clear();
+        }
+        if (binding!=nullptr) g_ort->ReleaseIoBinding(binding);
+        if (session!=nullptr && c>0) g_ort->ReleaseSession(session);
+        if (c==0 && referenceOutputs.empty())
+        {
+          LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Reference " + model_path[i] + " cannot run, keeping it without comparing variants");
+          return model_path[i];
+        }
+
+        double score = -1.0;
+        if (!runTimes.empty())
+        {
+          auto p90 = runTimes.begin() + (runTimes.size() * 9) / 10;
+          std::nth_element(runTimes.begin(), p90, runTimes.end());
+          score = *p90;
+        }
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Variant " + candidates[c] + " of " + model_name[i] + ": error " + ((error<0) ? std::string("-") : std::to_string(error)) + ", " + ((score<0) ? std::string("not timed") : std::to_string(score * 1000.0) + " ms"));
+        nlohmann::json entry;
+        entry["model"] = candidates[c];
+        entry["error"] = error;
+        entry["score"] = score;
+        measured.push_back(entry);
+        if (score>=0 && (selectedScore<0 || score<selectedScore))
+        {
+          selected = candidates[c];
+          selectedScore = score;
+        }
+      }
+      std::copy(calibrationInputs[0].begin(), calibrationInputs[0].end(), inputTensorData[i].begin());
+      LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Selected variant " + selected + " of " + model_name[i] + " within a tolerance of " + std::to_string(tolerance) + " (" + std::to_string(selectedScore * 1000.0) + " ms)");
+
+      nlohmann::json decision;
+      decision["reference"] = model_path[i];
+      decision["tolerance"] = tolerance;
+      decision["variants"] = measured;
+      decision["selected"] = selected;
+      std::experimental::filesystem::create_directories(cacheDir, ec);
+      std::ofstream out(cacheFile);
+      if (!out.good())
+      {
+        LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Could not cache the selected variant in " + cacheFile);
+        return selected;
+      }
+      out << decision.dump(4);
+      return selected;
+    }
+
+    /**
+      Getting the pixel format a model takes, gray for single channel models else the configured color space
+      @param modelIndex index of the model
+      @return int pixel format
+    */
+    int OnnxRuntimeClient::getModelPixelFormat(int modelIndex)
+    {
+      return (input_channels[modelIndex]==1) ? PIXEL_FORMAT_GRAY : ImagePreProcess::getPixelFormat(colorSpace_);
+    }
+
+    /**
+      Resizing a frame to the model size and normalizing it straight into an input tensor of the model
+      @param modelIndex index of the model
+      @param inputImage frame to be inferred
+      @param height height of the input image
+      @param width width of the input image
+      @param frameFormat pixel format of the input image
+      @param tensor buffer of one input of the model, in the layout and element type of the model
+      @param pyramid pyramid of the frame shared with the other models and sinks, nullptr if the capture builds none
+    */
+    void OnnxRuntimeClient::preprocessFrame(int modelIndex, unsigned char* inputImage, int height, int width, int frameFormat, void* tensor, utils::FramePyramid* pyramid)
+    {
+      int i = modelIndex;
+      imagePreprocessVec[i].resizeNormalize(inputImage, width, height, frameFormat, input_width[i], input_height[i], getModelPixelFormat(i), preprocess_params[i], preprocess_plans[i], tensor, pyramid);
+    }
+
+    /**
+      Preprocessing the frame of a message into the input tensors of all models that infer the whole frame, tiled
+      models preprocess their tiles while running. Called by the preprocess worker with its own state and buffers,
+      or by the inference loop when there is no worker.
+      @param input message to preprocess, getting the frame to model input transform per model
+      @param height height of the input image
+      @param width width of the input image
+      @param preprocess preprocessing state of the calling thread
+      @param plans preprocess plans of the calling thread, one per model
+      @param tensors input buffers to fill, one per model
+      @return true if the message was preprocessed, false for bursts and regions of interest
+    */
+    bool OnnxRuntimeClient::prepareInput(PreparedInput& input, int height, int width, utils::ImagePreProcess& preprocess, std::vector<PreprocessPlan>& plans, std::vector<AlignedVector<unsigned char> >& tensors)
+    {
+      if (useRois || input.message.safeCaptureContainer_.size()!=1)
+      {
+        return false;
+      }
+
+      unsigned char* inputImage = input.message.safeCaptureContainer_.front();
+      int frameFormat = ImagePreProcess::resolvePixelFormat(input.message.pixelFormat_, colorSpace_);
+      utils::FramePyramid* pyramid = input.message.framePyramids_.empty() ? nullptr : input.message.framePyramids_[0].get();
+      input.transforms.assign(numModels, PreprocessTransform());
+      for (int i=0; i<numModels; i++)
+      {
+        if (tiling_params[i].enabled)
+        {
+          continue;
+        }
+        preprocess.resizeNormalize(inputImage, width, height, frameFormat, input_width[i], input_height[i], getModelPixelFormat(i), preprocess_params[i], plans[i], tensors[i].data(), pyramid);
+        input.transforms[i] = plans[i].transform;
+      }
+      return true;
+    }
+
+    /**
+      Running all frames of a burst through one model as a single batch. Models with a fixed batch size of 1 run the frames one after another.
+      @param modelIndex index of the model
+      @param inputImages frames of the burst
+      @param height height of the input images
+      @param width width of the input images
+      @param frameFormat pixel format of the input images
+      @param pyramids pyramids of the input images, empty if the capture builds none
+      @param burstOutputs passing by reference to get the outputs per frame and model
+    */
+    void OnnxRuntimeClient::runBatch(int modelIndex, std::vector<unsigned char*>& inputImages, int height, int width, int frameFormat, std::vector<std::shared_ptr<utils::FramePyramid>>& pyramids, std::vector<std::vector<std::vector<float> > >& burstOutputs)
+    {
+      int i = modelIndex;
+      int batchSize = (int)(inputImages.size());
+      if (!is_dynamic_batch_vec[i])
+      {
+        for (int b=0; b<batchSize; b++)
+        {
+          preprocessFrame(i, inputImages[b], height, width, frameFormat, inputTensorData[i].data(), (b<(int)(pyramids.size())) ? pyramids[b].get() : nullptr);
+          CheckStatus(g_ort->RunWithBinding(ort_session_vec[i], NULL, ioBindingVec[i]));
+          burstOutputs[b][i].assign(outputTensorValuesVec[i].begin(), outputTensorValuesVec[i].end());
+        }
+        return;
+      }
+
+      std::vector<int64_t> batchDims(input_tensor_shape[i].begin(), input_tensor_shape[i].end());
+      batchDims[0] = batchSize;
+      size_t frameBytes = inputTensorData[i].size();
+      AlignedVector<unsigned char> batchInput((size_t)(batchSize) * frameBytes, 0);
+      for (int b=0; b<batchSize; b++)
+      {
+        preprocessFrame(i, inputImages[b], height, width, frameFormat, batchInput.data() + (size_t)(b) * frameBytes, (b<(int)(pyramids.size())) ? pyramids[b].get() : nullptr);
+      }
+
+      OrtValue* batchInputTensor = nullptr;
+      OrtValue* batchOutputTensor = nullptr;
+      CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[i], batchInput.data(), batchInput.size(), batchDims.data(), batchDims.size(), input_tensor_type[i], &batchInputTensor));
+      CheckStatus(g_ort->Run(ort_session_vec[i], NULL, inputNamesVec[i].data(), &batchInputTensor, 1, outputNamesVec[i].data(), 1, &batchOutputTensor)); // output allocated by ONNX Runtime
+
+      float* batchOutput = nullptr;
+      CheckStatus(g_ort->GetTensorMutableData(batchOutputTensor, (void**)&batchOutput));
+      for (int b=0; b<batchSize; b++)
+      {
+        burstOutputs[b][i].assign(batchOutput + (size_t)(b) * output_tensor_size[i], batchOutput + (size_t)(b+1) * output_tensor_size[i]);
+      }
+      LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Batch of " + std::to_string(batchSize) + " frames inferred with [" + model_name[i] + "]");
+
+      g_ort->ReleaseValue(batchOutputTensor);
+      g_ort->ReleaseValue(batchInputTensor);
+    }
+
+    /**
+      Running crops of a frame through a model. Every crop is preprocessed straight from the frame into the input tensor
+      and the crops are inferred in batches for models with a dynamic batch dimension, else one after another.
+      @param modelIndex index of the model
+      @param inputImage frame to be inferred
+      @param height height of the input image
+      @param width width of the input image
+      @param frameFormat pixel format of the input image
+      @param pyramid pyramid of the frame, used for the conversion of frames that crops cannot be addressed in
+      @param crops regions of the frame to infer, empty crops are skipped
+      @param plans preprocess plans, one per crop or a single one shared by crops of the same size
+      @param batchLimit maximum number of crops per run, 0 for all crops
+      @param onOutput called with the index, the output and the frame to model input transform of every crop
+    */
+    void OnnxRuntimeClient::runCrops(int modelIndex, unsigned char* inputImage, int height, int width, int frameFormat, utils::FramePyramid* pyramid, const std::vector<cv::Rect>& crops, std::vector<PreprocessPlan>& plans, int batchLimit, const std::function<void(int, const float*, const PreprocessTransform&)>& onOutput)
+    {
+      int i = modelIndex;
+      int modelFormat = getModelPixelFormat(i);
+
+      // Crops are addressed in place inside RGB, BGR and GRAY frames, other formats are converted once per frame
+      int cropFormat = frameFormat;
+      if (frameFormat!=PIXEL_FORMAT_RGB && frameFormat!=PIXEL_FORMAT_BGR && frameFormat!=PIXEL_FORMAT_GRAY)
+      {
+        cropFormat = ImagePreProcess::getResizeFormat(frameFormat, modelFormat);
+        if (pyramid)
+        {
+          inputImage = pyramid->getLevel(width, height, cropFormat).data;
+        }
+        else
+        {
+          imagePreprocessVec[i].convert(inputImage, width, height, frameFormat, cropSourceVec[i], cropFormat);
+          inputImage = cropSourceVec[i].data;
+        }
+      }
+      if (inputImage==nullptr)
+      {
+        LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Frame of " + std::string(PixelFormatsE[frameFormat]) + " cannot be cropped for " + model_name[i]);
+        return;
+      }
+
+      std::vector<int> cropIndices;
+      for (int c=0; c<(int)(crops.size()); c++)
+      {
+        if (!crops[c].empty())
+          cropIndices.push_back(c);
+      }
+      int numCrops = (int)(cropIndices.size());
+      int batchSize = 1;
+      if (is_dynamic_batch_vec[i])
+      {
+        batchSize = (batchLimit>0) ? std::min(batchLimit, numCrops) : numCrops;
+      }
+
+      size_t pixelSize = (cropFormat==PIXEL_FORMAT_GRAY) ? 1 : 3;
+      size_t frameStep = (size_t)(width) * pixelSize;
+      size_t cropBytes = inputTensorData[i].size();
+      auto preprocessCrop = [&](int c, void* tensor)
+      {
+        const cv::Rect& crop = crops[c];
+        PreprocessPlan& plan = plans[(plans.size()==1) ? 0 : c];
+        unsigned char* cropImage = inputImage + (size_t)(crop.y) * frameStep + (size_t)(crop.x) * pixelSize;
+        imagePreprocessVec[i].resizeNormalize(cropImage, crop.width, crop.height, cropFormat, input_width[i], input_height[i], modelFormat, preprocess_params[i], plan, tensor, nullptr, frameStep);
+      };
+
+      for (int first=0; first<numCrops; first+=batchSize)
+      {
+        int count = std::min(batchSize, numCrops - first);
+        float* output = nullptr;
+        OrtValue* batchInputTensor = nullptr;
+        OrtValue* batchOutputTensor = nullptr;
+        if (!is_dynamic_batch_vec[i])
+        {
+          preprocessCrop(cropIndices[first], inputTensorData[i].data());
+          CheckStatus(g_ort->RunWithBinding(ort_session_vec[i], NULL, ioBindingVec[i]));
+          output = outputTensorValuesVec[i].data();
+        }
+        else
+        {
+          AlignedVector<unsigned char>& cropBatchInput = cropBatchInputVec[i];
+          cropBatchInput.resize((size_t)(count) * cropBytes);
+          for (int b=0; b<count; b++)
+          {
+            preprocessCrop(cropIndices[first + b], cropBatchInput.data() + (size_t)(b) * cropBytes);
+          }
+          std::vector<int64_t> batchDims(input_tensor_shape[i].begin(), input_tensor_shape[i].end());
+          batchDims[0] = count;
+          CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[i], cropBatchInput.data(), cropBatchInput.size(), batchDims.data(), batchDims.size(), input_tensor_type[i], &batchInputTensor));
+          CheckStatus(g_ort->Run(ort_session_vec[i], NULL, inputNamesVec[i].data(), &batchInputTensor, 1, outputNamesVec[i].data(), 1, &batchOutputTensor)); // output allocated by ONNX Runtime
+          CheckStatus(g_ort->GetTensorMutableData(batchOutputTensor, (void**)&output));
+        }
+
+        for (int b=0; b<count; b++)
+        {
+          int c = cropIndices[first + b];
+          // Frame to model input coordinates of this crop
+          PreprocessTransform transform = plans[(plans.size()==1) ? 0 : c].transform;
+          transform.padX -= crops[c].x * transform.gainX;
+          transform.padY -= crops[c].y * transform.gainY;
+          onOutput(c, output + (size_t)(b) * output_tensor_size[i], transform);
+        }
+
+        if (batchOutputTensor)
+          g_ort->ReleaseValue(batchOutputTensor);
+        if (batchInputTensor)
+          g_ort->ReleaseValue(batchInputTensor);
+      }
+      LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] " + std::to_string(numCrops) + " crops inferred in batches of " + std::to_string(batchSize) + " with [" + model_name[i] + "]");
+    }
+
+    /**
+      Running a frame through a model tile by tile. Detections are mapped back to the frame and merged across tiles
+      with NMS, segmentation masks are stitched into a mask of the whole frame.
+      @param modelIndex index of the model
+      @param inputImage frame to be inferred
+      @param height height of the input image
+      @param width width of the input image
+      @param frameFormat pixel format of the input image
+      @param pyramid pyramid of the frame
+      @param results passing by reference to get the boxes as x1,y1,x2,y2,class,score or the mask of the frame
+      @param resultShape passing by reference to get the shape of results: [1, boxes, 6], or [1, classes, H, W] / [1, H, W, classes] in the layout of the output
+    */
+    void OnnxRuntimeClient::runTiled(int modelIndex, unsigned char* inputImage, int height, int width, int frameFormat, utils::FramePyramid* pyramid, std::vector<float>& results, std::vector<int>& resultShape)
+    {
+      int i = modelIndex;
+      const TilingParams& tiling = tiling_params[i];
+      bool isDetection = (model_type[i]=="objectdetection");
+      std::vector<std::vector<float> > bboxes;
+      results.clear();
+
+      // All tiles have the same size and share one plan
+      std::vector<cv::Rect> tiles = ImagePreProcess::getTiles(width, height, tiling);
+      crop_plans[i].resize(1);
+      runCrops(i, inputImage, height, width, frameFormat, pyramid, tiles, crop_plans[i], tiling.batchSize, [&](int c, const float* output, const PreprocessTransform& transform)
+      {
+        if (isDetection)
+        {
+          resultPostprocessVec[i].getBBoxResults(bboxes, (float*)(output), output_tensor_shape[i], transform, height, width, tiling.scoreThreshold);
+        }
+        else
+        {
+          resultPostprocessVec[i].stitchMask(results, height, width, output, output_tensor_shape[i], is_chw_output_vec[i], input_height[i], input_width[i], crop_plans[i][0].transform, tiles[c]);
+        }
+      });
+
+      if (isDetection)
+      {
+        resultPostprocessVec[i].nms(bboxes, tiling.nmsThreshold);
+        for (auto& box : bboxes)
+        {
+          results.insert(results.end(), box.begin(), box.end());
+        }
+        resultShape = {1, (int)(bboxes.size()), 6};
+      }
+      else
+      {
+        resultShape = is_chw_output_vec[i] ? std::vector<int>{1, output_tensor_shape[i][1], height, width} : std::vector<int>{1, height, width, output_tensor_shape[i][3]};
+      }
+    }
+
+    /**
+      Running the regions of interest of a frame through a model instead of the whole frame. The outputs are stacked
+      per region like the outputs of a batch.
+      @param modelIndex index of the model
+      @param inputImage frame to be inferred
+      @param height height of the input image
+      @param width width of the input image
+      @param frameFormat pixel format of the input image
+      @param pyramid pyramid of the frame
+      @param rois regions of interest of the frame
+      @param results passing by reference to get the outputs of all regions, zero for regions outside the frame
+      @param resultShape passing by reference to get the shape of results, the output shape with one entry per region
+      @param transforms passing by reference to get the frame to model input transform per region
+    */
+    void OnnxRuntimeClient::runRois(int modelIndex, unsigned char* inputImage, int height, int width, int frameFormat, utils::FramePyramid* pyramid, const std::vector<RegionOfInterest>& rois, std::vector<float>& results, std::vector<int>& resultShape, std::vector<PreprocessTransform>& transforms)
+    {
+      int i = modelIndex;
+      std::vector<cv::Rect> crops = ImagePreProcess::getCrops(rois, width, height);
+      crop_plans[i].resize(crops.size()); // regions keep their plans as long as their size does not change
+      results.assign(crops.size() * output_tensor_size[i], 0.0f);
+      transforms.assign(crops.size(), PreprocessTransform());
+      runCrops(i, inputImage, height, width, frameFormat, pyramid, crops, crop_plans[i], 0, [&](int c, const float* output, const PreprocessTransform& transform)
+      {
+        std::copy(output, output + output_tensor_size[i], results.begin() + (size_t)(c) * output_tensor_size[i]);
+        transforms[c] = transform;
+      });
+      resultShape = output_tensor_shape[i];
+      resultShape[0] = (int)(crops.size());
+    }
+
+    /**
+      Turning the detections of a model into regions of interest, merged with NMS and padded
+      @param modelIndex index of the model
+      @param results outputs of the model, or boxes as x1,y1,x2,y2,class,score of a tiled model
+      @param transforms frame to model input transform per stacked output
+      @param height height of the input image
+      @param width width of the input image
+      @return regions of interest in frame coordinates
+    */
+    std::vector<RegionOfInterest> OnnxRuntimeClient::getDetectedRois(int modelIndex, std::vector<float>& results, const std::vector<PreprocessTransform>& transforms, int height, int width)
+    {
+      int i = modelIndex;
+      std::vector<std::vector<float> > bboxes;
+      if (tiling_params[i].enabled && !useRois)
+      {
+        for (size_t r=0; r+6<=results.size(); r+=6)
+        {
+          if (results[r+5] > emitRoiThreshold)
+            bboxes.push_back(std::vector<float>(results.begin() + r, results.begin() + r + 6));
+        }
+      }
+      else
+      {
+        for (size_t c=0; c<transforms.size() && (c+1) * output_tensor_size[i]<=results.size(); c++)
+        {
+          resultPostprocessVec[i].getBBoxResults(bboxes, results.data() + c * output_tensor_size[i], output_tensor_shape[i], transforms[c], height, width, emitRoiThreshold);
+        }
+      }
+      resultPostprocessVec[i].nms(bboxes, emitRoiNmsThreshold);
+
+      std::vector<RegionOfInterest> rois;
+      for (auto& box : bboxes)
+      {
+        RegionOfInterest roi;
+        roi.name = "detection" + std::to_string(rois.size());
+        roi.x = std::max((int)(box[0]) - emitRoiPadding, 0);
+        roi.y = std::max((int)(box[1]) - emitRoiPadding, 0);
+        roi.width = std::min((int)(std::ceil(box[2])) + emitRoiPadding, width) - roi.x;
+        roi.height = std::min((int)(std::ceil(box[3])) + emitRoiPadding, height) - roi.y;
+        roi.label = (int)(box[4]);
+        roi.score = box[5];
+        if (roi.width>0 && roi.height>0)
+          rois.push_back(roi);
+      }
+      return rois;
+    }
+
+    /**
+      Run inference for EdgeManager for Classification, Object Detection and Segmentation models
+      @param errc returning the error code of capture API
+      @param height height of the input image
+      @param width width of the input image
+      @param iter running for total iterations if > 0 else running infinite loop
+    */
+    void OnnxRuntimeClient::runInference(int& errc, int& height, int& width, int& iter, bool& completed)
+    {
+      if (!clientStarted_)
+      {
+        camera2ongoing_.WaitMessage();
+        startClient();
+      }
+      while (clientFailed_)
+      {
+        auto message = camera2ongoing_.GetMessage();
+        LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Models of " + inferName_ + " could not be set up, dropping frame of " + message.captureTrigger_.captureTriggersMessage_);
+        errc = INFERENCE_ERROR;
+        start_timeout = std::chrono::steady_clock::now();
+        completed = false;
+      }
+      startPreprocessWorker(numInputBuffers, [this, &height, &width](PreparedInput& input)
+      {
+        return prepareInput(input, height, width, slotPreprocess, slot_plans, inputSlotData[input.slot]);
+      });
+      if (asyncRequests>1 && !asyncThread_.joinable())
+      {
+        asyncThread_ = std::thread(&OnnxRuntimeClient::runAsyncDelivery, this);
+      }
+
+      while(1)
+      {
+        PreparedInput input = getPreparedInput();
+        auto& message = input.message;
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Capture Trigger Message = " + message.captureTrigger_.captureTriggersMessage_);
+        message.inferenceMode_ = InferenceInputModeE::ONNX;
+
+        // Whole frames go out with RunAsync and are delivered in capture order by the delivery thread
+        if (asyncRequests>1 && input.slot>=0)
+        {
+          launchAsync(input, height, width);
+          errc = INFERENCE_OK;
+          start_timeout = std::chrono::steady_clock::now();
+          completed = false;
+          continue;
+        }
+        drainAsync(); // frames run here wait for the frames in flight, keeping capture order
+
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient]");
+
+        inference_start_time = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> sessionLock(sessionMtx_); // models are swapped between frames
+        acquireSessions();
+
+        // All frames of a burst are inferred together, one result set per frame
+        std::vector<unsigned char*> inputImages;
+        std::queue<unsigned char*> burstFrames = message.safeCaptureContainer_;
+        while (!burstFrames.empty())
+        {
+          inputImages.push_back(burstFrames.front());
+          burstFrames.pop();
+        }
+        int burstCount = std::max((int)(inputImages.size()), 1);
+        int frameFormat = ImagePreProcess::resolvePixelFormat(message.pixelFormat_, colorSpace_);
+        // Single frames are inferred straight into outputDataVec, only bursts get results per frame
+        std::vector<std::vector<std::vector<float> > > burstOutputs;
+        if (burstCount>1)
+        {
+          burstOutputs.assign(burstCount, outputDataVec);
+        }
+        auto frameOutputs = [&](int b) -> std::vector<std::vector<float> >& { return (burstCount>1) ? burstOutputs[b] : outputDataVec; };
+        std::vector<std::vector<int> > resultsShape = output_tensor_shape;
+        std::vector<std::vector<PreprocessTransform> > roisTransform(numModels);
+        std::vector<RegionOfInterest> rois = staticRois.empty() ? message.rois_ : staticRois;
+
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Inference started for model(s)");
+        // Every model runs on its own buffers while the others run on the pool, models fed by others run in a later wave
+        auto runModel = [&](int i)
+        {
+          auto modelStart = std::chrono::steady_clock::now();
+          model_skipped[i] = !shouldRunModel(i, burstOutputs);
+          if (model_skipped[i])
+          {
+            // Results of a skipped model are zeros, not the results of an earlier frame
+            for (auto& outputs : burstOutputs)
+              std::fill(outputs[i].begin(), outputs[i].end(), 0.0f);
+            std::fill(outputDataVec[i].begin(), outputDataVec[i].end(), 0.0f);
+            model_run_times[i] = 0.0;
+            LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Inference for [" + model_name[i] + "] is skipped by its runIf condition");
+            return;
+          }
+
+          if (useRois)
+          {
+            for (int b=0; b<burstCount; b++)
+            {
+              runRois(i, inputImages[b], height, width, frameFormat, (b<(int)(message.framePyramids_.size())) ? message.framePyramids_[b].get() : nullptr, rois, frameOutputs(b)[i], resultsShape[i], roisTransform[i]);
+            }
+          }
+          else if (tiling_params[i].enabled)
+          {
+            for (int b=0; b<burstCount; b++)
+            {
+              runTiled(i, inputImages[b], height, width, frameFormat, (b<(int)(message.framePyramids_.size())) ? message.framePyramids_[b].get() : nullptr, frameOutputs(b)[i], resultsShape[i]);
+            }
+          }
+          else if (burstCount>1)
+          {
+            runBatch(i, inputImages, height, width, frameFormat, message.framePyramids_, burstOutputs);
+          }
+          else
+          {
+            // Frames the worker did not take are preprocessed here
+            OrtIoBinding* binding = ioBindingVec[i];
+            if (input.slot>=0)
+            {
+              binding = inputSlotBindings[input.slot][i];
+            }
+            else
+            {
+              preprocessFrame(i, inputImages[0], height, width, frameFormat, inputTensorData[i].data(), message.framePyramids_.empty() ? nullptr : message.framePyramids_[0].get());
+            }
+            CheckStatus(g_ort->RunWithBinding(ort_session_vec[i], NULL, binding));
+            outputDataVec[i].assign(outputTensorValuesVec[i].begin(), outputTensorValuesVec[i].end());
+          }
+
+          if (model_type[i]=="classification" || model_type[i]=="objectdetection" || model_type[i]=="segmentation" || model_type[i]=="undefined" || model_type[i]=="none")
+          {
+            if (burstCount>1)
+              outputDataVec[i] = burstOutputs[0][i];
+            std::transform(model_type[i].begin(), model_type[i].end(), model_type[i].begin(), std::ptr_fun<int, int>(std::toupper));
+            std::transform(model_type[i].begin(), model_type[i].end(), model_type[i].begin(), std::ptr_fun<int, int>(std::tolower));
+            LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Inference results for [" + model_name[i] + "] is completed");
+          }
+          else
+          {
+            LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Model type not correctly found. Should be one of: {classification OR objectdetection OR segmentation OR undefined OR none}");
+          }
+          model_run_times[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - modelStart).count();
+        };
+        for (auto& wave : modelWaves)
+        {
+          modelPool->run((int)(wave.size()), [&](int w)
+          {
+            runModel(wave[w]);
+          });
+        }
+        sessionLock.unlock();
+        releaseInputSlot(input.slot);
+
+        std::vector<PreprocessTransform> frameTransforms = input.transforms;
+        for (int i=0; input.slot<0 && i<numModels; i++)
+        {
+          frameTransforms.push_back(preprocess_plans[i].transform);
+        }
+
+        finishInference(message, frameTransforms, burstOutputs, resultsShape, roisTransform, rois, height, width, inference_start_time);
+
+        errc = INFERENCE_OK;
+        start_timeout = std::chrono::steady_clock::now();
+        completed = false;
+      }
+    }
+
+    /**
+      Starting all models of a preprocessed frame with RunAsync on the buffers of its input slot. Waits while
+      asyncRequests frames are in flight. Models that cannot be started asynchronously run synchronously instead.
+      @param input frame preprocessed into an input slot
+      @param height height of the input image
+      @param width width of the input image
+    */
+    void OnnxRuntimeClient::launchAsync(PreparedInput& input, int height, int width)
+    {
+      auto frame = std::make_shared<AsyncFrame>();
+      frame->client = this;
+      frame->height = height;
+      frame->width = width;
+      frame->startTime = std::chrono::steady_clock::now();
+      frame->input = std::move(input);
+      frame->pendingModels = numModels;
+      for (int i=0; i<numModels; i++)
+      {
+        frame->runs.push_back(std::make_pair(frame.get(), i));
+      }
+      {
+        std::unique_lock<std::mutex> lock(asyncMtx_);
+        asyncCv_.wait(lock, [this]() { return (int)(asyncFrames_.size())<asyncRequests; });
+        asyncFrames_.push_back(frame);
+        asyncLaunched_++;
+      }
+      asyncCv_.notify_all();
+
+      int slot = frame->input.slot;
+      std::lock_guard<std::mutex> sessionLock(sessionMtx_); // a swapped model is released after the frames launched on it
+      acquireSessions();
+      for (int i=0; i<numModels; i++)
+      {
+        OrtStatus* status = g_ort->RunAsync(ort_session_vec[i], NULL, asyncInputNames[i].data(), slotAsyncInputs[slot][i].data(), asyncInputNames[i].size(), asyncOutputNames[i].data(), asyncOutputNames[i].size(), slotAsyncOutputs[slot][i].data(), &OnnxRuntimeClient::onAsyncRunDone, &frame->runs[i]);
+        if (status!=NULL)
+        {
+          // e.g. sessions without an intra-op pool of their own
+          g_ort->ReleaseStatus(status);
+          status = g_ort->Run(ort_session_vec[i], NULL, asyncInputNames[i].data(), slotAsyncInputs[slot][i].data(), asyncInputNames[i].size(), asyncOutputNames[i].data(), asyncOutputNames[i].size(), slotAsyncOutputs[slot][i].data());
+          onAsyncRunDone(&frame->runs[i], slotAsyncOutputs[slot][i].data(), asyncOutputNames[i].size(), status);
+        }
+      }
+    }
+
+    /**
+      Completion of a model run started with RunAsync, called on a thread of ONNX Runtime
+      @param userData the frame and the index of the model
+      @param outputs outputs of the model, the preallocated buffers of the input slot
+      @param numOutputs number of outputs
+      @param status error of the run, nullptr on success, released here
+    */
+    void OnnxRuntimeClient::onAsyncRunDone(void* userData, OrtValue** outputs, size_t numOutputs, OrtStatus* status)
+    {
+      auto run = (std::pair<AsyncFrame*, int>*)(userData);
+      AsyncFrame* frame = run->first;
+      if (status!=NULL)
+      {
+        LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Asynchronous run of [" + frame->client->model_name[run->second] + "] failed: " + std::string(frame->client->g_ort->GetErrorMessage(status)));
+        frame->client->g_ort->ReleaseStatus(status);
+        frame->failed = true;
+      }
+      if (--frame->pendingModels==0)
+      {
+        std::lock_guard<std::mutex> lock(frame->client->asyncMtx_);
+        frame->done = true;
+        frame->client->asyncCv_.notify_all();
+      }
+    }
+
+    /**
+      Delivery thread of the asynchronous mode, finishing the frames in the order they were launched
+    */
+    void OnnxRuntimeClient::runAsyncDelivery()
+    {
+      while(1)
+      {
+        std::shared_ptr<AsyncFrame> frame;
+        {
+          std::unique_lock<std::mutex> lock(asyncMtx_);
+          asyncCv_.wait(lock, [this]() { return stopAsync_ || (!asyncFrames_.empty() && asyncFrames_.front()->done); });
+          if (stopAsync_)
+          {
+            break; // the client drained the frames in flight before stopping
+          }
+          frame = asyncFrames_.front();
+        }
+
+        int slot = frame->input.slot;
+        std::vector<std::vector<std::vector<float> > > burstOutputs; // single frames, the results are in outputDataVec
+        for (int i=0; i<numModels; i++)
+        {
+          const float* results = (const float*)(slotOutputData[slot][i][0].data());
+          outputDataVec[i].assign(results, results + output_tensor_size[i]);
+          for (size_t p=1; p<asyncOutputIndex[i].size(); p++)
+          {
+            int k = asyncOutputIndex[i][p];
+            std::copy(slotOutputData[slot][i][p].begin(), slotOutputData[slot][i][p].end(), extraOutputDataVec[i][k].begin());
+          }
+        }
+        releaseInputSlot(slot);
+
+        if (frame->failed)
+        {
+          LOG_ERROR("[INFERENCE::OnnxRuntimeClient] Frame " + frame->input.message.captureTrigger_.captureTriggersMessage_ + " delivered with the results of failed runs");
+        }
+        LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Inference results for all models are completed");
+        std::vector<std::vector<int> > resultsShape = output_tensor_shape;
+        std::vector<std::vector<PreprocessTransform> > roisTransform(numModels);
+        std::vector<RegionOfInterest> rois = frame->input.message.rois_;
+        finishInference(frame->input.message, frame->input.transforms, burstOutputs, resultsShape, roisTransform, rois, frame->height, frame->width, frame->startTime);
+
+        {
+          std::lock_guard<std::mutex> lock(asyncMtx_);
+          asyncFrames_.pop_front();
+          asyncDelivered_++;
+        }
+        asyncCv_.notify_all();
+      }
+    }
+
+    /**
+      Waiting until all frames in flight are delivered
+    */
+    void OnnxRuntimeClient::drainAsync()
+    {
+      if (asyncRequests<=1)
+      {
+        return;
+      }
+      std::unique_lock<std::mutex> lock(asyncMtx_);
+      asyncCv_.wait(lock, [this]() { return asyncFrames_.empty(); });
+    }
+
+    /**
+      Checking if a session has the inputs and outputs of a model, in name, type and shape, so it can run on the
+      buffers and bindings of the model
+      @param modelIndex index of the model
+      @param session session of another version of the model
+      @return true if the inputs and outputs match
+    */
+    bool OnnxRuntimeClient::hasModelSignature(int modelIndex, OrtSession* session)
+    {
+      std::vector<OrtTensorDetails> inputs = getTensorDetails(session, true);
+      std::vector<OrtTensorDetails> outputs = getTensorDetails(session, false);
+      if (inputs.size()!=input_details[modelIndex].size() || outputs.size()!=output_details[modelIndex].size())
+        return false;
+      for (size_t k=0; k<inputs.size(); k++)
+      {
+        if (inputs[k].name!=input_details[modelIndex][k].name || inputs[k].type!=input_details[modelIndex][k].type || inputs[k].shape!=input_details[modelIndex][k].shape)
+          return false;
+      }
+      for (size_t k=0; k<outputs.size(); k++)
+      {
+        if (outputs[k].name!=output_details[modelIndex][k].name || outputs[k].type!=output_details[modelIndex][k].type || outputs[k].shape!=output_details[modelIndex][k].shape)
+          return false;
+      }
+      return true;
+    }
+
+    /**
+      Model swap worker, taking the models of configchange commands meant for this client, e.g.
+      {"command": "configchange", "models": [{"inferName": "onnx1", "model_name": "detector", "model_path": "/models/detector_v2.onnx"}]}
+      where inferName is optional
+    */
+    void OnnxRuntimeClient::runModelSwaps()
+    {
+      while(!stopSwaps_)
+      {
+        nlohmann::json command = modelSwaps_.GetMessage();
+        if (stopSwaps_ || command.is_null())
+        {
+          break; // sentinel of the destructor
+        }
+        for (auto& model : command["models"])
+        {
+          if (stopSwaps_ || !model.is_object() || model.value("inferName", inferName_)!=inferName_)
+            continue;
+          std::string name = model.value("model_name", "");
+          std::string path = model.value("model_path", "");
+          for (int i=0; i<numModels && !path.empty(); i++)
+          {
+            if (model_name[i]==name && model_path[i]!=path)
+              swapModel(i, path);
+          }
+        }
+      }
+    }
+
+    /**
+      Replacing the session of a model with a new version of the model without stopping inference. The new version is
+      loaded and warmed up next to the old one, switched to between two frames and the old session is released once the
+      frames launched on it are delivered. Only versions with the same inputs and outputs can be swapped in, since the
+      buffers and their bindings are kept.
+      @param modelIndex index of the model
+      @param path model file of the new version
+      @return true if the new version is in use
+    */
+    bool OnnxRuntimeClient::swapModel(int modelIndex, const std::string& path)
+    {
+      int i = modelIndex;
+      LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] Loading " + path + " to replace " + model_path[i] + " of [" + model_name[i] + "]");
+      OrtSession* session = nullptr;
+      std::vector<OrtIoBinding*> bindings;
+      AlignedVector<unsigned char> warmInput(inputTensorData[i].size(), 0);
+      AlignedVector<float> warmOutput(outputTensorValuesVec[i].size());
+      OrtValue* warmInputTensor = nullptr;
+      OrtValue* warmOutputTensor = nullptr;
+      OrtIoBinding* warmBinding = nullptr;
+      bool ok = false;
+      try
+      {
+        session = createModelSession(i, session_options, session_configs[i], path);
+        if (!hasModelSignature(i, session))
+        {
+          LOG_ERROR("[INFERENCE::OnnxRuntimeClient] " + path + " does not have the inputs and outputs of [" + model_name[i] + "], keeping " + model_path[i]);
+        }
+        else
+        {
+          // Warming up on buffers of its own, the current version keeps running on the bound ones
+          std::vector<int64_t> inputDims(input_tensor_shape[i].begin(), input_tensor_shape[i].end());
+          std::vector<int64_t> outputDims(output_tensor_shape[i].begin(), output_tensor_shape[i].end());
+          CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[i], warmInput.data(), warmInput.size(), inputDims.data(), inputDims.size(), input_tensor_type[i], &warmInputTensor));
+          CheckStatus(g_ort->CreateTensorWithDataAsOrtValue(ort_memory_vec[i], warmOutput.data(), warmOutput.size() * sizeof(float), outputDims.data(), outputDims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &warmOutputTensor));
+          CheckStatus(g_ort->CreateIoBinding(session, &warmBinding));
+          CheckStatus(g_ort->BindInput(warmBinding, inputNamesVec[i][0], warmInputTensor));
+          for (auto& extraInput : extraInputsVec[i])
+          {
+            CheckStatus(g_ort->BindInput(warmBinding, extraInput.first.c_str(), extraInput.second));
+          }
+          CheckStatus(g_ort->BindOutput(warmBinding, outputNamesVec[i][0], warmOutputTensor));
+          for (int iter=0; iter<5; iter++)
+          {
+            CheckStatus(g_ort->RunWithBinding(session, NULL, warmBinding));
+          }
+
+          bindings.push_back(bindTensors(i, inputTensorsVec[i], session));
+          for (auto& slotTensors : inputSlotTensors)
+          {
+            bindings.push_back(bindTensors(i, slotTensors[i], session));
+          }
+          ok = true;
+        }
+      }
+      catch (const std::runtime_error& e)
+      {
+        LOG_ERROR("[INFERENCE::OnnxRuntimeClient] " + path + " cannot replace [" + model_name[i] + "]: " + std::string(e.what()));
+      }
+      if (warmBinding!=nullptr) g_ort->ReleaseIoBinding(warmBinding);
+      if (warmOutputTensor!=nullptr) g_ort->ReleaseValue(warmOutputTensor);
+      if (warmInputTensor!=nullptr) g_ort->ReleaseValue(warmInputTensor);
+      if (!ok)
+      {
+        for (OrtIoBinding* binding : bindings)
+          g_ort->ReleaseIoBinding(binding);
+        if (session!=nullptr)
+          g_ort->ReleaseSession(session);
+        return false;
+      }
+
+      // Switching between two frames
+      OrtSession* oldSession = nullptr;
+      std::vector<OrtIoBinding*> oldBindings;
+      unsigned long launched = 0;
+      {
+        std::lock_guard<std::mutex> lock(sessionMtx_);
+        oldSession = ort_session_vec[i];
+        ort_session_vec[i] = session;
+        oldBindings.push_back(ioBindingVec[i]);
+        ioBindingVec[i] = bindings[0];
+        for (size_t s=0; s<inputSlotBindings.size(); s++)
+        {
+          oldBindings.push_back(inputSlotBindings[s][i]);
+          inputSlotBindings[s][i] = bindings[s+1];
+        }
+        model_path[i] = path;
+        {
+          // The new version counts against the session budget instead of the old one
+          std::lock_guard<std::mutex> residentLock(residentMtx_);
+          size_t bytes = getSessionBytes();
+          if (std::find(residentClients_.begin(), residentClients_.end(), this)!=residentClients_.end())
+            residentBytes_ = residentBytes_ - sessionBytes_ + bytes;
+          sessionBytes_ = bytes;
+        }
+        std::lock_guard<std::mutex> asyncLock(asyncMtx_);
+        launched = asyncLaunched_;
+      }
+
+      // Frames launched asynchronously before the switch still run on the old session
+      {
+        std::unique_lock<std::mutex> lock(asyncMtx_);
+        asyncCv_.wait(lock, [this, launched]() { return asyncDelivered_>=launched; });
+      }
+      for (OrtIoBinding* binding : oldBindings)
+        g_ort->ReleaseIoBinding(binding);
+      g_ort->ReleaseSession(oldSession);
+      LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] [" + model_name[i] + "] now runs " + path);
+      return true;
+    }
+
+    /**
+      Checking if a model runs on the current frame. A model fed or gated by a skipped model is skipped. With a runIf
+      condition, the primary output of the gating model is checked entry by entry (every frame of a burst, every
+      region or batch item): the model runs if one entry has its top class among the classes, its top score within
+      [minScore, maxScore] and its first value above the anomaly threshold, for the parts of the condition configured.
+      @param modelIndex index of the model
+      @param burstOutputs outputs per frame and model of a burst, of the models of earlier waves, empty for single frames in outputDataVec
+      @return true if the model runs
+    */
+    bool OnnxRuntimeClient::shouldRunModel(int modelIndex, const std::vector<std::vector<std::vector<float> > >& burstOutputs)
+    {
+      for (int j : model_sources[modelIndex])
+      {
+        if (model_skipped[j])
+          return false;
+      }
+      const RunCondition& condition = run_conditions[modelIndex];
+      if (condition.sourceModel<0)
+      {
+        return true;
+      }
+
+      size_t entrySize = (size_t)(std::max(output_tensor_size[condition.sourceModel], 1));
+      for (size_t b=0; b<std::max(burstOutputs.size(), (size_t)(1)); b++)
+      {
+        const std::vector<float>& output = burstOutputs.empty() ? outputDataVec[condition.sourceModel] : burstOutputs[b][condition.sourceModel];
+        for (size_t start=0; start<output.size(); start+=entrySize)
+        {
+          auto first = output.begin() + start;
+          auto last = output.begin() + std::min(start + entrySize, output.size());
+          auto top = std::max_element(first, last);
+          int topClass = (int)(top - first);
+          if (!condition.classes.empty() && std::find(condition.classes.begin(), condition.classes.end(), topClass)==condition.classes.end())
+            continue;
+          if (*top<condition.minScore || *top>condition.maxScore)
+            continue;
+          if (condition.anomalyThreshold>=0 && *first<=condition.anomalyThreshold)
+            continue;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+      Finishing the inference of a message: emitting regions, filling the results and sending the message to the outputs
+      @param message message whose frames were inferred
+      @param frameTransforms frame to model input transform per model
+      @param burstOutputs outputs per frame and model of a burst, empty for single frames whose results are in outputDataVec
+      @param resultsShape shape of the results per model
+      @param roisTransform per model, the transform of every region when inferring regions of interest
+      @param rois regions of interest the models ran on
+      @param height height of the input image
+      @param width width of the input image
+      @param startTime time the inference of the message started
+    */
+    void OnnxRuntimeClient::finishInference(MessageCaptureInference& message, std::vector<PreprocessTransform>& frameTransforms, std::vector<std::vector<std::vector<float> > >& burstOutputs, std::vector<std::vector<int> >& resultsShape, std::vector<std::vector<PreprocessTransform> >& roisTransform, std::vector<RegionOfInterest>& rois, int height, int width, std::chrono::steady_clock::time_point startTime)
+    {
+      if (useGpio)
+      {
+        // Running GPIO logic here
+        gpioRet = GPIO_FAIL;
+        while (gpioRet==GPIO_FAIL)
+        {
+          gpioRet = gpio.gpio_setvalue(GPIO_DATA_OUT_1, 1); // Setting the Data Valid Output
+        }
+        gpioRet = GPIO_FAIL;
+        while (gpioRet==GPIO_FAIL)
+        {
+          gpioRet = gpio.gpio_setvalue(GPIO_DATA_OUT_1, 0); // Un-Setting the Data Valid Output
+        }
+      }
+
+      // Detections of the first detector are the regions of interest of the next stage
+      message.rois_ = useRois ? rois : message.rois_;
+      if (emitRois)
+      {
+        for (int i=0; i<numModels; i++)
+        {
+          if (model_type[i]=="objectdetection")
+          {
+            message.rois_ = getDetectedRois(i, outputDataVec[i], useRois ? roisTransform[i] : std::vector<PreprocessTransform>{frameTransforms[i]}, height, width);
+            LOG_ALWAYS("[INFERENCE::OnnxRuntimeClient] " + std::to_string(message.rois_.size()) + " detections of [" + model_name[i] + "] passed on as regions of interest");
+            break;
+          }
+        }
+      }
+
+      inference_end_time = std::chrono::steady_clock::now();
+      inference_duration = std::chrono::duration_cast<std::chrono::milliseconds>(inference_end_time - startTime);
+
+      // Queue updates
+      customResultsNlohmannJson_["inputShape"] = input_tensor_shape;
+      customResultsNlohmannJson_["outputShape"] = resultsShape;
+      customResultsNlohmannJson_["inputTransform"] = nlohmann::json::array();
+      std::vector<PreprocessTransform> resultsTransform;
+      for (int i=0; i<numModels; i++)
+      {
+        // Tiled results are already in frame coordinates, results of regions have a transform per region
+        resultsTransform.push_back((tiling_params[i].enabled || useRois) ? PreprocessTransform() : frameTransforms[i]);
+        customResultsNlohmannJson_["inputTransform"].push_back({{"gainX", resultsTransform[i].gainX}, {"gainY", resultsTransform[i].gainY}, {"padX", resultsTransform[i].padX}, {"padY", resultsTransform[i].padY}});
+      }
+      // Entry r of the results of every model belongs to region r
+      customResultsNlohmannJson_["rois"] = nlohmann::json::array();
+      for (int r=0; useRois && r<(int)(rois.size()); r++)
+      {
+        nlohmann::json roiTransform = nlohmann::json::array();
+        for (int i=0; i<numModels; i++)
+        {
+          const PreprocessTransform& transform = roisTransform[i][r];
+          roiTransform.push_back({{"gainX", transform.gainX}, {"gainY", transform.gainY}, {"padX", transform.padX}, {"padY", transform.padY}});
+        }
+        customResultsNlohmannJson_["rois"].push_back({{"name", rois[r].name}, {"x", rois[r].x}, {"y", rois[r].y}, {"width", rois[r].width}, {"height", rois[r].height}, {"label", rois[r].label}, {"score", rois[r].score}, {"inputTransform", roiTransform}});
+      }
+      if (emitRois)
+      {
+        customResultsNlohmannJson_["detectedRois"] = nlohmann::json::array();
+        for (auto& roi : message.rois_)
+        {
+          customResultsNlohmannJson_["detectedRois"].push_back({{"name", roi.name}, {"x", roi.x}, {"y", roi.y}, {"width", roi.width}, {"height", roi.height}, {"label", roi.label}, {"score", roi.score}});
+        }
+      }
+      customResultsNlohmannJson_["modelType"] = model_type[0];
+      if (model_type[0]=="classification" || model_type[0]=="objectdetection" || model_type[0]=="undefined" || model_type[0]=="none")
+      {
+        customResultsNlohmannJson_["resultType"] = "json";
+      }
+      else if (model_type[0]=="segmentation")
+      {
+        customResultsNlohmannJson_["resultType"] = "mask";
+      }
+      else
+      {
+        customResultsNlohmannJson_["resultType"] = "__undefined__";
+      }
+      customResultsNlohmannJson_["results"] = outputDataVec;
+      // The other outputs of every model, as written by its last run
+      customResultsNlohmannJson_["outputs"] = nlohmann::json::array();
+      for (int i=0; i<numModels; i++)
+      {
+        nlohmann::json modelOutputs = nlohmann::json::array();
+        for (int k=0; k<(int)(extraOutputTensorsVec[i].size()); k++)
+        {
+          if (extraOutputTensorsVec[i][k]!=nullptr)
+          {
+            modelOutputs.push_back({{"name", output_details[i][k].name}, {"shape", output_details[i][k].shape}, {"values", getOutputValues(extraOutputDataVec[i][k].data(), output_details[i][k])}});
+          }
+        }
+        customResultsNlohmannJson_["outputs"].push_back(modelOutputs);
+      }
+      // Which models of a cascade ran on the message and how long every model took
+      if (hasCascade)
+      {
+        customResultsNlohmannJson_["cascade"] = nlohmann::json::array();
+        for (int i=0; i<numModels; i++)
+        {
+          std::string gate = (run_conditions[i].sourceModel>=0) ? model_name[run_conditions[i].sourceModel] : "";
+          customResultsNlohmannJson_["cascade"].push_back({{"model", model_name[i]}, {"runIf", gate}, {"skipped", model_skipped[i]!=0}, {"inferenceTime", model_run_times[i]}});
+        }
+      }
+      if (burstOutputs.size()>1)
+      {
+        customResultsNlohmannJson_["burstCount"] = burstOutputs.size();
+        customResultsNlohmannJson_["burstResults"] = burstOutputs;
+      }
+      else
+      {
+        // Single frames do not report the results of an earlier burst
+        customResultsNlohmannJson_.erase("burstCount");
+        customResultsNlohmannJson_.erase("burstResults");
+      }
+
+      inferenceBaseInferenceResultsNlohmannJson_["inferenceResults"] = customResultsNlohmannJson_;
+      inferenceBaseInferenceResultsNlohmannJson_["inferenceTime"] = std::to_string(inference_duration.count());
+      inferenceBaseInferenceResultsNlohmannJson_["framesPerSecond"] = std::to_string(1./inference_duration.count());
+      inferenceBaseInferenceResultsNlohmannJson_["imageLocation"] = "__undefined__";
+      inferenceBaseInferenceResultsNlohmannJson_["resultLocation"] = "__undefined__";
+
+      message.inferenceDetailsMap_["response"] = inferenceBaseInferenceResultsNlohmannJson_;
+      message.inferenceDetailsMap_["numInferencesDone"] = std::to_string(1);
+      message.em_models_shape_ = input_tensor_shape;
+      message.em_results_shape_ = resultsShape;
+      message.em_model_type_ = model_type;
+      message.em_models_transform_ = resultsTransform;
+      message.em_rois_transform_ = useRois ? roisTransform : std::vector<std::vector<PreprocessTransform> >();
+      if (burstOutputs.empty())
+      {
+        message.inferenceEMDetails_.push(outputDataVec);
+      }
+      for (auto& frameOutputs : burstOutputs)
+      {
+        message.inferenceEMDetails_.push(frameOutputs);
+      }
+
+      if(produce_output_)
+      {
+        output_inference_.produce_message(message);
+        LOG_ALWAYS("[PIPELINE::GENERAL] Message Size = " + std::to_string(output_inference_.size()));
       }
     }
 
@@ -144,7 +144,11 @@ namespace edgeml
 
             auto inputImage = message.safeCaptureContainer_.front();
 
-            std::vector<uint8_t> image_data(inputImage, inputImage + (height * width) * 3);
+            // The model takes packed frames in the configured color space, converted on the copy if the frame differs
+            std::vector<uint8_t> image_data((height * width) * 3);
+            int frameFormat = ImagePreProcess::resolvePixelFormat(message.pixelFormat_, colorSpace_);
+            int modelFormat = (colorSpace_=="BGR") ? PIXEL_FORMAT_BGR : PIXEL_FORMAT_RGB;
+            imagePreprocess.resize(inputImage, width, height, frameFormat, image_data.data(), width, height, modelFormat);
 
             if (!err.IsOk())
             {
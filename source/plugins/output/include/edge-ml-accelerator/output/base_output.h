@@ -21,6 +21,7 @@
 #include <edge-ml-accelerator/utils/json_parser.h>
 #include <edge-ml-accelerator/utils/yaml_parser.h>
 #include <edge-ml-accelerator/utils/image_preprocess.h>
+#include <edge-ml-accelerator/utils/frame_pyramid.h>
 #include <edge-ml-accelerator/utils/result_postprocess.h>
 #include <edge-ml-accelerator/utils/edge_ml_config.h>
 #include <edge-ml-accelerator/utils/logger.h>
@@ -74,6 +75,7 @@ namespace edgeml
                 std::string getAWSRegion();
                 std::string getLocalPath();
                 std::string getImageFormat();
+                void getSaveSize(int& saveHeight, int& saveWidth);
                 std::string getOutputFileName();
                 std::string getFileExt(std::string& s);
                 void getS3BucketAndKey(std::string& bucket, std::string& key);
@@ -88,6 +90,7 @@ namespace edgeml
                 std::string s3bucket, s3key, s3region, localDisk, imageFormat, ipcTopicName, mqttTopicName;
                 utils::GPIO gpio;
                 std::string colorSpace_;
+                int saveHeight_ = 0, saveWidth_ = 0;
 
             protected:
                 SharedMessage<MessageCaptureInference> &incoming_message_;
@@ -50,7 +50,9 @@ namespace edgeml
                 std::string savePathInferenceResultsJson_;
                 std::string filesSavePath, filesSavePathResults;
                 std::string imageFormat_ = "png", colorSpace_ = "BGR";
+                int saveHeight_ = 0, saveWidth_ = 0;
                 unsigned char* imageData;
+                cv::Mat savedImage;
                 unsigned char* outputVecLFVE;
                 std::vector<std::vector<float> > outputVec;
                 std::mutex mtx_;
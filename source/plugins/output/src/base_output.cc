@@ -45,6 +45,9 @@ namespace edgeml
             imageFormat = "jpeg";
           if (imageFormat=="PNG")
             imageFormat = "png";
+          // Missing sizes keep the frame size, jValue leaves missing numbers uninitialized
+          saveHeight_ = (jsonParams_["outputsink"][i]["saveHeight"].get_type()==utils::jsonParser::JNUMBER) ? jsonParams_["outputsink"][i]["saveHeight"].as_int() : 0;
+          saveWidth_ = (jsonParams_["outputsink"][i]["saveWidth"].get_type()==utils::jsonParser::JNUMBER) ? jsonParams_["outputsink"][i]["saveWidth"].as_int() : 0;
         }
         if (jsonParams_["outputsink"][i]["outputSinkType"].as_string() == "s3")
         {
@@ -92,6 +95,17 @@ namespace edgeml
       return imageFormat;
     }
 
+    /**
+      Getting the size the images are saved at
+      @param saveHeight passing by reference to get the height, 0 to save the frame as captured
+      @param saveWidth passing by reference to get the width, 0 to save the frame as captured
+    */
+    void Output::getSaveSize(int& saveHeight, int& saveWidth)
+    {
+      saveHeight = saveHeight_;
+      saveWidth = saveWidth_;
+    }
+
     /**
       Creating the image colorspace
       @return image colorspace rgb or bgr
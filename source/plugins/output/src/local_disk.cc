@@ -38,6 +38,7 @@ namespace edgeml
 
       imageFormat_ = getImageFormat();
       colorSpace_ = getColorSpace();
+      getSaveSize(saveHeight_, saveWidth_);
       if (imageFormat_ == "jpg" || imageFormat_ == "jpeg")
       {
         LOG_ALWAYS("[OUTPUT::LOCALDISK] Trying to save image as JPG");
@@ -158,10 +159,28 @@ namespace edgeml
           filesSavePathResults = "";
 
           imageData = message.safeCaptureContainer_.front();
+          int frameFormat = ImagePreProcess::resolvePixelFormat(message.pixelFormat_, colorSpace_);
+          int imageHeight = height, imageWidth = width;
 
-          ret = imagePreprocess.write((const char *)filesSavePath.c_str(), width, height, img_c, (const void *)imageData, colorSpace_);
+          if (saveHeight_>0 && saveWidth_>0 && (saveHeight_!=height || saveWidth_!=width))
+          {
+            // Resized in the format the models take, so a model of the same size shares the level of the frame pyramid
+            int saveFormat = ImagePreProcess::getResizeFormat(frameFormat, ImagePreProcess::getPixelFormat(colorSpace_));
+            savedImage = message.framePyramids_.empty() ? cv::Mat() : message.framePyramids_[0]->getLevel(saveWidth_, saveHeight_, saveFormat);
+            if (savedImage.empty())
+            {
+              savedImage.create(saveHeight_, saveWidth_, (saveFormat==PIXEL_FORMAT_GRAY) ? CV_8UC1 : CV_8UC3);
+              imagePreprocess.resize(imageData, width, height, frameFormat, savedImage.data, saveWidth_, saveHeight_, saveFormat);
+            }
+            imageData = savedImage.data;
+            frameFormat = saveFormat;
+            imageHeight = saveHeight_;
+            imageWidth = saveWidth_;
+          }
+
+          ret = imagePreprocess.write((const char *)filesSavePath.c_str(), imageWidth, imageHeight, frameFormat, (const void *)imageData);
 
-          LOG_ALWAYS("[OUTPUT::LOCALDISK] Saving the image as: " + filesSavePath + " of size [H,W] = [" + std::to_string(height) + "," + std::to_string(width) + "]");
+          LOG_ALWAYS("[OUTPUT::LOCALDISK] Saving the image as: " + filesSavePath + " of size [H,W] = [" + std::to_string(imageHeight) + "," + std::to_string(imageWidth) + "]");
 
           message.image_file_names_ = filesSavePath;
           message.inferenceDetailsMap_["response"]["imageLocation"] = filesSavePath;
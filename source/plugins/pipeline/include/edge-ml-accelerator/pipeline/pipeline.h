@@ -47,6 +47,10 @@
 
 #include <edge-ml-accelerator/capture/base_capture.h>
 #include <edge-ml-accelerator/capture/opencv_capture.h>
+#include <edge-ml-accelerator/capture/synthetic_capture.h>
+#ifdef WITH_GSTREAMER
+#include <edge-ml-accelerator/capture/gstreamer_capture.h>
+#endif
 #ifdef WITH_GENICAM
 #include <edge-ml-accelerator/capture/genicam_capture.h>
 #endif
@@ -104,8 +108,8 @@ namespace edgeml
                 int N = 0, iter = 0, ret = -100;
                 bool completed = false;
 
-                // OpenCV, Pylon, GenICam or GStreamer
-                bool isOpencv = false, isPylon = false, isGenicam = false, isGstreamer = false;
+                // OpenCV, Pylon, GenICam, GStreamer or Synthetic
+                bool isOpencv = false, isPylon = false, isGenicam = false, isGstreamer = false, isSynthetic = false;
 
                 // LFVE or EdgeManager
                 bool isLFVE = false, isEdgeManager = false, isTritonClient = false, isOnnxRuntime = false;
@@ -56,10 +56,22 @@ namespace edgeml
             if (jsonParams_["capture"][cameraIndex]["cameraType"].as_string()=="GSTREAMER")
             {
                 LOG_ALWAYS("[PIPELINE::Capture] Starting test with GStreamer Capture.");
+#ifdef WITH_GSTREAMER
+                pCapture = new GstreamerCapture(jsonParams_, cameraIndex, pTrigger->trigger2camera_);
+#else
                 pCapture = new OpenCVCapture(jsonParams_, cameraIndex, pTrigger->trigger2camera_);
+#endif
                 isGstreamer = true;
             }
 
+            // Using Synthetic Capture API
+            if (jsonParams_["capture"][cameraIndex]["cameraType"].as_string()=="SYNTHETIC")
+            {
+                LOG_ALWAYS("[PIPELINE::Capture] Starting test with Synthetic Capture.");
+                pCapture = new SyntheticCapture(jsonParams_, cameraIndex, pTrigger->trigger2camera_);
+                isSynthetic = true;
+            }
+
 #ifdef WITH_GENICAM
             // Using GenICam Capture API
             if (jsonParams_["capture"][cameraIndex]["cameraType"].as_string()=="GENICAM")
@@ -80,13 +92,6 @@ namespace edgeml
             }
 #endif
 
-            pCapture->initCapture(cameraIndex);
-            height = pCapture->getInputHeight();
-            width = pCapture->getInputWidth();
-
-            frameBufferSize = height * width * 3;
-            frameBuffer = new unsigned char[frameBufferSize]();
-
             // All Inferences defined
             std::vector<std::string> inferenceNamesVec;
             for (int inferenceIndex=0; inferenceIndex<jsonParams_["inference"].size(); inferenceIndex++)
@@ -196,6 +201,29 @@ namespace edgeml
                 }
             }
             std::string pipelineName_ = jsonParams_["capture"][cameraIndex]["subpipelines"].to_string_key(0);
+
+            // The camera is set up once the models are known, so its size can be negotiated from their input shapes
+            int modelHeight = 0, modelWidth = 0;
+            for (auto pClient : pOnnxRuntimeClientVec)
+            {
+                int h, w;
+                pClient->getModelInputSize(h, w);
+                modelHeight = std::max(modelHeight, h); modelWidth = std::max(modelWidth, w);
+            }
+            for (auto pClient : pEdgeManagerClientVec)
+            {
+                int h, w;
+                pClient->getModelInputSize(h, w);
+                modelHeight = std::max(modelHeight, h); modelWidth = std::max(modelWidth, w);
+            }
+            pCapture->setRequiredModelSize(modelHeight, modelWidth);
+
+            pCapture->initCapture(cameraIndex);
+            height = pCapture->getInputHeight();
+            width = pCapture->getInputWidth();
+
+            frameBufferSize = height * width * 3;
+            frameBuffer = new unsigned char[frameBufferSize]();
         }
 
         /**
@@ -24,6 +24,7 @@
 #include <edge-ml-accelerator/utils/image_preprocess.h>
 #include <edge-ml-accelerator/utils/result_postprocess.h>
 #include <edge-ml-accelerator/utils/edge_ml_config.h>
+#include <edge-ml-accelerator/utils/control_bus.h>
 #include <edge-ml-accelerator/utils/logger.h>
 
 #ifdef WITH_MIC730AI
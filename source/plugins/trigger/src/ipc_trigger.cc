@@ -128,6 +128,12 @@ namespace edgeml
                 message.captureTriggersType_ = "ipc";
                 trigger2camera_.produce_message(message);
 
+                // Stages other than the cameras pick their part of a config change, e.g. a new model version
+                if (commandStr=="configchange")
+                {
+                    utils::ControlBus::instance()->publish(outMessageStringJson_);
+                }
+
                 outMessageStringIpc_ = "";
 
                 // Keep the main thread alive, or the process will exit.
@@ -0,0 +1,61 @@
+/**
+ * @aligned_allocator.h
+ * @brief Utils for aligned buffers
+ *
+ * This contains an allocator handing out memory aligned to cache lines, so tensor buffers start on a boundary
+ * that SIMD loads and stores of the inference runtimes handle without splitting.
+ *
+ */
+
+#ifndef __ALIGNED_ALLOCATOR_H__
+#define __ALIGNED_ALLOCATOR_H__
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#define BUFFER_ALIGNMENT 64
+
+namespace edgeml
+{
+    namespace utils
+    {
+
+        template<typename T, std::size_t Alignment = BUFFER_ALIGNMENT>
+        struct AlignedAllocator
+        {
+            typedef T value_type;
+
+            template<typename U>
+            struct rebind
+            {
+                typedef AlignedAllocator<U, Alignment> other;
+            };
+
+            AlignedAllocator() noexcept {}
+            template<typename U>
+            AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+            T* allocate(std::size_t n)
+            {
+                return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+            }
+
+            void deallocate(T* p, std::size_t) noexcept
+            {
+                ::operator delete(p, std::align_val_t(Alignment));
+            }
+
+            template<typename U>
+            bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+            template<typename U>
+            bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+        };
+
+        template<typename T>
+        using AlignedVector = std::vector<T, AlignedAllocator<T> >; // contiguous buffer starting on a cache line
+
+    }
+}
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * @control_bus.h
+ * @brief Utils for passing control commands to the stages of the process
+ *
+ * This contains the prototypes of a process wide bus for control commands like `configchange`. Triggers publish the
+ * commands they receive, stages subscribe with a callback and pick the commands meant for them.
+ *
+ */
+
+#ifndef __CONTROL_BUS_H__
+#define __CONTROL_BUS_H__
+
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <functional>
+
+#include <nlohmann/json.hpp>
+
+namespace edgeml
+{
+    namespace utils
+    {
+
+        class ControlBus
+        {
+            public:
+                static ControlBus* instance();
+                int subscribe(const std::function<void(const nlohmann::json&)>& onCommand); // returning the id to unsubscribe with
+                void unsubscribe(int id);
+                void publish(const nlohmann::json& command); // calling every subscriber on the publishing thread
+
+            private:
+                std::mutex mtx_;
+                std::map<int, std::function<void(const nlohmann::json&)> > subscribers_;
+                int nextId_ = 0;
+        };
+
+    }
+}
+
+#endif
@@ -24,6 +24,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <any>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <edge-ml-accelerator/utils/json_parser.h>
 
@@ -73,7 +74,8 @@ typedef enum CaptureInputMode
     CAMERAMODE = 0,
 	IMAGEFILEMODE = 1,
     VIDEOFILEMODE = 2,
-    GSTREAMERMODE = 3
+    GSTREAMERMODE = 3,
+    SYNTHETICMODE = 4
 } CaptureInputModeE;
 
 /* Define Inference modes */
@@ -86,7 +88,37 @@ typedef enum InferenceInputMode
     TRITON = 3
 } InferenceInputModeE;
 
+/* Define Pixel formats of captured frames */
+typedef enum PixelFormat
+{
+    PIXEL_FORMAT_UNKNOWN = -1,
+    PIXEL_FORMAT_RGB = 0,
+    PIXEL_FORMAT_BGR = 1,
+    PIXEL_FORMAT_GRAY = 2,
+    PIXEL_FORMAT_NV12 = 3,
+    PIXEL_FORMAT_I420 = 4
+} PixelFormatE;
+
+/* Define Layouts of model input tensors */
+typedef enum TensorLayout
+{
+    TENSOR_LAYOUT_NCHW = 0,
+    TENSOR_LAYOUT_NHWC = 1
+} TensorLayoutE;
+
+/* Define Element types of model input tensors */
+typedef enum TensorType
+{
+    TENSOR_TYPE_FLOAT32 = 0,
+    TENSOR_TYPE_FLOAT16 = 1,
+    TENSOR_TYPE_UINT8 = 2,
+    TENSOR_TYPE_INT8 = 3
+} TensorTypeE;
+
 extern const char *CaptureTypesE[];
+extern const char *PixelFormatsE[];
+extern const char *TensorLayoutsE[];
+extern const char *TensorTypesE[];
 extern const char *ModelTypesE[];
 extern const char *LfveModelStatusE[];
 extern const char *EdgeManagerModelStatusE[];
@@ -176,10 +208,32 @@ struct MessageT2C
 
 };
 
+/* Define Mapping of frame coordinates to model input coordinates: model = frame * gain + pad */
+struct PreprocessTransform
+{
+    float gainX = 1.0f, gainY = 1.0f;
+    float padX = 0.0f, padY = 0.0f;
+};
+
+/* Define Region of a frame that is inferred instead of the whole frame */
+struct RegionOfInterest
+{
+    std::string name;
+    int x = 0, y = 0, width = 0, height = 0;
+    int label = -1; // class of the detection the region comes from, -1 for configured regions
+    float score = 1.0f;
+};
+
+/* Define Resized versions of a frame shared by its consumers, see frame_pyramid.h */
+namespace edgeml { namespace utils { class FramePyramid; } }
+
 struct MessageCaptureInference
 {
     std::queue<unsigned char*> safeCaptureContainer_; // storing the streaming data
     std::queue<int> safeCaptureSizeContainer_; // storing the streaming data size
+    std::vector<std::shared_ptr<void>> safeCaptureOwnerContainer_; // keeping pooled frame buffers alive until the last consumer drops the message
+    PixelFormat pixelFormat_ = PixelFormatE::PIXEL_FORMAT_UNKNOWN; // format of the frames, unknown means the configured colorSpace
+    std::vector<std::shared_ptr<edgeml::utils::FramePyramid>> framePyramids_; // per frame when the capture builds pyramids, empty otherwise
     std::queue<std::vector<std::vector<float>>> inferenceEMDetails_;
     nlohmann::json inferenceDetailsMap_;
     std::queue<unsigned char*> inferenceLFVEDetails_;
@@ -187,6 +241,9 @@ struct MessageCaptureInference
     std::vector<std::vector<int>> em_models_shape_;
     std::vector<std::vector<int>> em_results_shape_;
     std::vector<std::string> em_model_type_;
+    std::vector<PreprocessTransform> em_models_transform_; // per model, to map results back to frame coordinates
+    std::vector<RegionOfInterest> rois_; // crops to infer, configured per camera or subpipeline or found by an upstream detector
+    std::vector<std::vector<PreprocessTransform>> em_rois_transform_; // per model and region when inferred on rois_
     std::string image_file_names_ = "";
     std::string result_file_names_ = "";
     std::string topics_to_publish_;
@@ -233,6 +290,14 @@ class SharedMessage{
             return message;
         }
 
+        void WaitMessage() {
+            // waiting for a message without taking it
+            std::unique_lock<std::mutex> lock(shared_mutex_);
+            cv_.wait(lock, [&](){
+                return not message_queue_.empty();
+                });
+        }
+
         int size()
         {
             return message_queue_.size();
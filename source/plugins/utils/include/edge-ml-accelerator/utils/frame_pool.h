@@ -0,0 +1,49 @@
+/**
+ * @frame_pool.h
+ * @brief Utils for pooling frame buffers
+ *
+ * This contains the prototypes of a fixed size pool of frame buffers that are handed
+ * downstream and returned to the pool once the last consumer releases them.
+ *
+ */
+
+#ifndef __FRAME_POOL_H__
+#define __FRAME_POOL_H__
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+namespace edgeml
+{
+    namespace utils
+    {
+
+        class FramePool
+        {
+            public:
+                FramePool(int numBuffers, size_t bufferSize);
+                ~FramePool();
+                std::shared_ptr<unsigned char> acquire(int* index = nullptr); // nullptr when all buffers are in flight
+                unsigned char* getBuffer(int index); // direct access, e.g. for pre-rendering buffer contents
+                int getNumBuffers();
+                int getNumAvailable();
+                size_t getBufferSize();
+
+            private:
+                struct PoolState
+                {
+                    std::mutex mtx;
+                    std::vector<std::unique_ptr<unsigned char[]>> buffers;
+                    std::deque<int> freeList;
+                };
+                std::shared_ptr<PoolState> state_;
+                size_t bufferSize_;
+        };
+
+    }
+}
+
+#endif
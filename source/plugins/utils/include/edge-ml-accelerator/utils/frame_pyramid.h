@@ -0,0 +1,55 @@
+/**
+ * @frame_pyramid.h
+ * @brief Utils for sharing resized versions of a frame
+ *
+ * This contains the prototypes of a lazily populated pyramid of a captured frame. Every consumer asks for the
+ * size and pixel format it needs, every level is computed once per frame and shared by all consumers asking for it.
+ *
+ */
+
+#ifndef __FRAME_PYRAMID_H__
+#define __FRAME_PYRAMID_H__
+
+#include <iostream>
+#include <memory>
+#include <map>
+#include <tuple>
+#include <mutex>
+
+#include <opencv2/opencv.hpp>
+
+#include <edge-ml-accelerator/utils/image_preprocess.h>
+
+namespace edgeml
+{
+    namespace utils
+    {
+
+        class FramePyramid
+        {
+            public:
+                FramePyramid(const unsigned char* frame, int width, int height, int pixelFormat, std::shared_ptr<void> owner = nullptr);
+                ~FramePyramid();
+                const cv::Mat& getLevel(int width, int height, int pixelFormat, int interpolation = cv::INTER_NEAREST); // computed by the first caller, shared afterwards
+                int getNumLevels();
+                int getWidth();
+                int getHeight();
+                int getPixelFormat();
+
+            private:
+                struct Level
+                {
+                    std::once_flag once;
+                    cv::Mat image;
+                };
+                std::mutex mtx_;
+                std::map<std::tuple<int, int, int, int>, std::shared_ptr<Level>> levels_; // by width, height, pixel format and interpolation
+                const unsigned char* frame_;
+                int width_, height_, pixelFormat_;
+                std::shared_ptr<void> owner_; // keeping the frame alive as long as the pyramid
+        };
+
+    }
+}
+
+#endif
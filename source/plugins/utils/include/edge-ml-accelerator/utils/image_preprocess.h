@@ -2,7 +2,8 @@
  * @image_preprocess.h
  * @brief Utils for pre-processing image before inference
  *
- * This contains the routines of pre-processing image like resize and scaling
+ * This contains the routines of pre-processing image like resize, color conversion and normalizing
+ * the image into the input tensor of a model
  *
  */
 
@@ -12,6 +13,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstring>
 #include <vector>
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,27 +23,93 @@
 #include <sys/ioctl.h>
 #include <algorithm>
 #include <cmath>
+#include <functional>
 
 #include <opencv2/opencv.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 
 #include <edge-ml-accelerator/utils/logger.h>
+#include <edge-ml-accelerator/utils/json_parser.h>
+#include <edge-ml-accelerator/utils/edge_ml_config.h>
+
+/* Define Tensor sizes from which preprocessing is split into row bands over threads */
+#define PARALLEL_PREPROCESS_MIN_ELEMENTS    (1 << 18)
+
+/* Define Fixed point precision of bilinear sampling weights */
+#define SAMPLING_WEIGHT_BITS                (11)
+#define SAMPLING_WEIGHT_ONE                 (1 << SAMPLING_WEIGHT_BITS)
 
 namespace edgeml
 {
     namespace utils
     {
 
+        /* Parameters of preprocessing a frame into a model input tensor: value = pixel * scale[c] + offset[c], quantization folded in */
+        struct PreprocessParams
+        {
+            float scale[4] = {1.0f, 1.0f, 1.0f, 1.0f}; // per channel of the tensor, 1 / (scaleBy * std)
+            float offset[4] = {0.0f, 0.0f, 0.0f, 0.0f}; // per channel of the tensor, -mean / std
+            int layout = TENSOR_LAYOUT_NCHW;
+            int dataType = TENSOR_TYPE_FLOAT32;
+            int interpolation = cv::INTER_NEAREST; // sampling of the fused resize, INTER_NEAREST or INTER_LINEAR
+            bool isIdentity = true; // no scale or offset, uint8 tensors are plain copies
+            bool isInteger = false; // 8-bit tensor with a scale of 1 and integer offsets, filled without going through floats
+            cv::Mat cameraMatrix, distCoeffs; // lens undistortion of the frame, empty if not used
+            bool letterbox = false; // keeping the aspect ratio and padding the rest of the model input
+            int padValue = 114;
+            int stride = 1; // padding rounded down to a multiple of stride
+            bool scaleUp = true;
+        };
+
+        /* Sampling of one frame size into one model input size, built once and reused for every frame */
+        struct PreprocessPlan
+        {
+            int width = 0, height = 0, channels = 0, output_width = 0, output_height = 0;
+            std::vector<int> xOffset0, xOffset1, xWeight; // source byte offsets and bilinear weight per output column
+            std::vector<int> yRow0, yRow1, yWeight; // source rows and bilinear weight per output row
+            cv::Mat mapXY, mapWeights; // fixed point remap maps from output to source pixels when undistorting
+            int contentX0 = 0, contentX1 = 0, contentY0 = 0, contentY1 = 0; // output region covered by the frame, padded outside
+            PreprocessTransform transform; // frame to model input coordinates
+
+            bool matches(int w, int h, int c, int ow, int oh) const {return width==w && height==h && channels==c && output_width==ow && output_height==oh;}
+        };
+
+        /* Tiling of a large frame into tiles that are preprocessed straight from the frame and inferred in batches */
+        struct TilingParams
+        {
+            bool enabled = false;
+            int tileWidth = 0, tileHeight = 0; // 0 for the model input size
+            int overlap = 0; // pixels shared by neighbouring tiles
+            int batchSize = 0; // tiles per run, 0 for all tiles of a frame
+            float scoreThreshold = 0.25f, nmsThreshold = 0.45f; // for merging detections across tiles
+        };
+
         class ImagePreProcess
         {
             public:
                 ImagePreProcess();
                 ~ImagePreProcess();
-                std::vector<float> scale(std::vector<unsigned char>& image, int& w, int& h, int& c, int& scaleBy);
+                int normalize(const unsigned char* image, int width, int height, int channels, const PreprocessParams& params, void* tensor, bool swapRB = false, size_t step = 0); // writing the image into a tensor in one pass
+                int resizeNormalize(const unsigned char* inputImage, int width, int height, int inputFormat, int output_width, int output_height, int modelFormat, const PreprocessParams& params, PreprocessPlan& plan, void* tensor, FramePyramid* pyramid = nullptr, size_t inputStep = 0); // resize fused with normalize
                 int resize(unsigned char* inputImage, int width, int height, unsigned char* outputImage, int output_width, int output_height, int input_channels);
+                int resize(unsigned char* inputImage, int width, int height, int inputFormat, unsigned char* outputImage, int output_width, int output_height, int outputFormat); // resize fused with the format conversion
+                int convert(const unsigned char* inputImage, int width, int height, int inputFormat, cv::Mat& outputImage, int outputFormat);
                 int write(const char *filename, int width, int height, int channel, const void *data, std::string colorspace);
+                int write(const char *filename, int width, int height, int pixelFormat, const void *data); // encoding a frame of any pixel format
+                static int getPixelFormat(std::string colorspace);
+                static int resolvePixelFormat(int pixelFormat, std::string colorspace);
+                static int getFrameSize(int width, int height, int pixelFormat);
+                static int getResizeFormat(int frameFormat, int modelFormat);
+                static PreprocessParams getPreprocessParams(jsonParser::jValue preprocess, int layout, int dataType);
+                static int getTensorElementSize(int dataType);
+                static TilingParams getTilingParams(jsonParser::jValue tiling);
+                static std::vector<cv::Rect> getTiles(int width, int height, const TilingParams& tiling);
+                static std::vector<RegionOfInterest> getRois(jsonParser::jValue rois);
+                static std::vector<cv::Rect> getCrops(const std::vector<RegionOfInterest>& rois, int width, int height);
+                static int buildPlan(PreprocessPlan& plan, int width, int height, int channels, int output_width, int output_height, const PreprocessParams& params);
             private:
                 int ret;
-                cv::Mat src, dst;
+                cv::Mat src, dst, converted, resized, tile, yuvLuma, yuvChroma, yuvPlanar;
         };
 
     }
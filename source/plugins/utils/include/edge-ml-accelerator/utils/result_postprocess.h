@@ -20,6 +20,11 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <limits>
+
+#include <opencv2/opencv.hpp>
+
+#include <edge-ml-accelerator/utils/edge_ml_config.h>
 
 namespace edgeml
 {
@@ -59,11 +64,14 @@ namespace edgeml
                 ~ResultPostProcess();
                 void getClassifyResults(std::vector<float>& outputConf, float* results, std::vector<int> results_shape, float thresh);
                 void getBBoxResults(std::vector<std::vector<float> >& outputBboxes, float* results, std::vector<int> models_shape, std::vector<int> results_shape, int height, int width, float thresh);
+                void getBBoxResults(std::vector<std::vector<float> >& outputBboxes, float* results, std::vector<int> results_shape, const PreprocessTransform& transform, int height, int width, float thresh); // mapping boxes back through the preprocess transform
+                void nms(std::vector<std::vector<float> >& outputBboxes, float iouThresh); // per class non-maximum suppression of boxes in x1,y1,x2,y2,class,score
+                void stitchMask(std::vector<float>& mask, int height, int width, const float* results, std::vector<int> results_shape, bool is_chw, int model_height, int model_width, const PreprocessTransform& transform, const cv::Rect& tile); // placing the mask of a tile into the mask of the frame
                 MaskResultsS getMaskResults(std::vector<float>& results);
 
             private:
                 int rows, cols;
-                float xGain, yGain, x1, y1, x2, y2, confidence;
+                float x1, y1, x2, y2, confidence;
         };
 
     }
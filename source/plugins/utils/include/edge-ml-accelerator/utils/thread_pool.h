@@ -0,0 +1,50 @@
+/**
+ * @thread_pool.h
+ * @brief Utils for running independent tasks in parallel
+ *
+ * This contains the prototypes of a fixed size pool of worker threads. A batch of tasks is spread over the
+ * workers and the calling thread, and the call returns once every task of the batch is done.
+ *
+ */
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+namespace edgeml
+{
+    namespace utils
+    {
+
+        class ThreadPool
+        {
+            public:
+                ThreadPool(int numThreads);
+                ~ThreadPool();
+                void run(int numTasks, const std::function<void(int)>& task); // running task(0..numTasks-1) and waiting for all of them
+                int getNumThreads();
+
+            private:
+                std::mutex mtx_;
+                std::condition_variable workCv_, doneCv_;
+                std::vector<std::thread> workers_;
+                const std::function<void(int)>* task_ = nullptr;
+                int numTasks_ = 0, nextTask_ = 0, pendingTasks_ = 0;
+                unsigned long batch_ = 0;
+                bool stop_ = false;
+                std::exception_ptr error_;
+                void runWorker();
+                void runTasks(std::unique_lock<std::mutex>& lock);
+        };
+
+    }
+}
+
+#endif
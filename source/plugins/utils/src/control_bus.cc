@@ -0,0 +1,61 @@
+/**
+ * @control_bus.cc
+ * @brief Control bus utils and routines
+ *
+ * This contains the functions used for passing control commands from the triggers to the stages of the process
+ *
+ */
+
+#include <edge-ml-accelerator/utils/control_bus.h>
+
+namespace edgeml
+{
+  namespace utils
+  {
+
+    /**
+      Instance of the class, shared by the whole process
+    */
+    ControlBus* ControlBus::instance()
+    {
+      static ControlBus inst;
+      return &inst;
+    }
+
+    /**
+      Subscribing to the commands of the bus
+      @param onCommand called with every published command, it should hand the command off and return quickly
+      @return id of the subscription
+    */
+    int ControlBus::subscribe(const std::function<void(const nlohmann::json&)>& onCommand)
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      subscribers_[nextId_] = onCommand;
+      return nextId_++;
+    }
+
+    /**
+      Ending a subscription, its callback is not called once this returns
+      @param id id of the subscription
+    */
+    void ControlBus::unsubscribe(int id)
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      subscribers_.erase(id);
+    }
+
+    /**
+      Publishing a command to all subscribers
+      @param command the command as received by the trigger
+    */
+    void ControlBus::publish(const nlohmann::json& command)
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      for (auto& subscriber : subscribers_)
+      {
+        subscriber.second(command);
+      }
+    }
+
+  }
+}
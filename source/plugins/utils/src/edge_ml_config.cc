@@ -1,6 +1,9 @@
 #include <edge-ml-accelerator/utils/edge_ml_config.h>
 
-const char *CaptureTypesE[] = {"CAMERAMODE", "IMAGEFILEMODE", "VIDEOFILEMODE", "GSTREAMERMODE"};
+const char *CaptureTypesE[] = {"CAMERAMODE", "IMAGEFILEMODE", "VIDEOFILEMODE", "GSTREAMERMODE", "SYNTHETICMODE"};
+const char *PixelFormatsE[] = {"RGB", "BGR", "GRAY", "NV12", "I420"};
+const char *TensorLayoutsE[] = {"NCHW", "NHWC"};
+const char *TensorTypesE[] = {"FLOAT32", "FLOAT16", "UINT8", "INT8"};
 const char *ModelTypesE[] = {"LFVE", "EDGEMANAGER", "ONNX", "TRITON", "NONE"};
 const char *LfveModelStatusE[] = {"STOPPED", "STARTING", "RUNNING", "FAILED", "STOPPING"};
 const char *EdgeManagerModelStatusE[] = {"OK", "UNKNOWN", "INTERNAL", "NOT_FOUND"};
@@ -0,0 +1,104 @@
+/**
+ * @frame_pool.cc
+ * @brief Frame buffer pool utils and routines
+ *
+ * This contains the functions used for acquiring and recycling pooled frame buffers
+ *
+ */
+
+#include <edge-ml-accelerator/utils/frame_pool.h>
+
+namespace edgeml
+{
+  namespace utils
+  {
+
+    /**
+      Creates the class constructor
+      @param numBuffers number of buffers allocated up front
+      @param bufferSize size of every buffer in bytes
+    */
+    FramePool::FramePool(int numBuffers, size_t bufferSize) : state_(std::make_shared<PoolState>()), bufferSize_(bufferSize)
+    {
+      for (int i=0; i<numBuffers; i++)
+      {
+        state_->buffers.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[bufferSize]()));
+        state_->freeList.push_back(i);
+      }
+    }
+
+    /**
+      Creates the class destructor. Buffers still held downstream stay valid until released.
+    */
+    FramePool::~FramePool()
+    {
+    }
+
+    /**
+      Acquiring a free buffer from the pool. Buffers are handed out in round-robin order and
+      go back to the pool when the last copy of the returned pointer is released.
+      @param index optional output of the index of the acquired buffer
+      @return shared pointer to the buffer, or nullptr if every buffer is in flight
+    */
+    std::shared_ptr<unsigned char> FramePool::acquire(int* index)
+    {
+      std::lock_guard<std::mutex> lock(state_->mtx);
+      if (state_->freeList.empty())
+      {
+        return nullptr;
+      }
+      int idx = state_->freeList.front();
+      state_->freeList.pop_front();
+      if (index != nullptr)
+      {
+        *index = idx;
+      }
+
+      std::shared_ptr<PoolState> state = state_;
+      return std::shared_ptr<unsigned char>(state_->buffers[idx].get(), [state, idx](unsigned char*)
+      {
+        std::lock_guard<std::mutex> lock(state->mtx);
+        state->freeList.push_back(idx);
+      });
+    }
+
+    /**
+      Getting a buffer of the pool without acquiring it
+      @param index index of the buffer
+      @return pointer to the buffer data
+    */
+    unsigned char* FramePool::getBuffer(int index)
+    {
+      return state_->buffers[index].get();
+    }
+
+    /**
+      Getting the number of buffers in the pool
+      @return int number of buffers
+    */
+    int FramePool::getNumBuffers()
+    {
+      return (int)(state_->buffers.size());
+    }
+
+    /**
+      Getting the number of buffers not in flight
+      @return int number of free buffers
+    */
+    int FramePool::getNumAvailable()
+    {
+      std::lock_guard<std::mutex> lock(state_->mtx);
+      return (int)(state_->freeList.size());
+    }
+
+    /**
+      Getting the size of every buffer
+      @return size_t buffer size in bytes
+    */
+    size_t FramePool::getBufferSize()
+    {
+      return bufferSize_;
+    }
+
+  }
+}
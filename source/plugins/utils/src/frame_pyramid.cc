@@ -0,0 +1,128 @@
+/**
+ * @frame_pyramid.cc
+ * @brief Frame pyramid utils and routines
+ *
+ * This contains the functions used for computing and sharing the resized versions of a frame
+ *
+ */
+
+#include <edge-ml-accelerator/utils/frame_pyramid.h>
+
+namespace edgeml
+{
+  namespace utils
+  {
+
+    /**
+      Creates the class constructor. No level is computed until a consumer asks for it.
+      @param frame unsigned char array of the captured frame
+      @param width int width of the frame
+      @param height int height of the frame
+      @param pixelFormat int pixel format of the frame
+      @param owner keeping the frame buffer alive as long as the pyramid
+    */
+    FramePyramid::FramePyramid(const unsigned char* frame, int width, int height, int pixelFormat, std::shared_ptr<void> owner) : frame_(frame), width_(width), height_(height), pixelFormat_(pixelFormat), owner_(owner)
+    {
+    }
+
+    /**
+      Creates the class destructor
+    */
+    FramePyramid::~FramePyramid()
+    {
+    }
+
+    /**
+      Getting the frame at the given size and pixel format. The first caller of a level computes it while callers
+      of the same level wait for it, callers of other levels are not blocked. Nearest sampling goes through the
+      resize fused with the format conversion, bilinear sampling converts first.
+      @param width int width of the level
+      @param height int height of the level
+      @param pixelFormat int pixel format of the level: RGB, BGR or GRAY
+      @param interpolation int sampling of the resize, INTER_NEAREST or INTER_LINEAR
+      @return the level, empty if the frame could not be converted
+    */
+    const cv::Mat& FramePyramid::getLevel(int width, int height, int pixelFormat, int interpolation)
+    {
+      if (width==width_ && height==height_)
+      {
+        interpolation = cv::INTER_NEAREST; // no sampling, one level per format
+      }
+
+      std::shared_ptr<Level> level;
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto& slot = levels_[std::make_tuple(width, height, pixelFormat, interpolation)];
+        if (!slot)
+        {
+          slot = std::make_shared<Level>();
+        }
+        level = slot;
+      }
+
+      std::call_once(level->once, [&]()
+      {
+        ImagePreProcess imagePreprocess;
+        int type = (pixelFormat==PIXEL_FORMAT_GRAY) ? CV_8UC1 : CV_8UC3;
+        if (width==width_ && height==height_ && pixelFormat==pixelFormat_)
+        {
+          level->image = cv::Mat(cv::Size(width, height), type, (void*)(frame_));
+          return;
+        }
+
+        cv::Mat image(cv::Size(width, height), type);
+        bool ret;
+        if (interpolation==cv::INTER_NEAREST)
+        {
+          ret = imagePreprocess.resize((unsigned char*)(frame_), width_, height_, pixelFormat_, image.data, width, height, pixelFormat);
+        }
+        else
+        {
+          cv::Mat converted;
+          if (pixelFormat==pixelFormat_)
+          {
+            converted = cv::Mat(cv::Size(width_, height_), type, (void*)(frame_));
+            ret = true;
+          }
+          else
+          {
+            ret = imagePreprocess.convert(frame_, width_, height_, pixelFormat_, converted, pixelFormat);
+          }
+          if (ret)
+            cv::resize(converted, image, image.size(), 0, 0, interpolation);
+        }
+
+        if (!ret)
+        {
+          LOG_ERROR("[Utils::FramePyramid] Could not compute level [H,W] = [" + std::to_string(height) + "," + std::to_string(width) + "] in " + std::string(PixelFormatsE[pixelFormat]));
+          return;
+        }
+        level->image = image;
+      });
+
+      return level->image;
+    }
+
+    int FramePyramid::getNumLevels()
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      return (int)(levels_.size());
+    }
+
+    int FramePyramid::getWidth()
+    {
+      return width_;
+    }
+
+    int FramePyramid::getHeight()
+    {
+      return height_;
+    }
+
+    int FramePyramid::getPixelFormat()
+    {
+      return pixelFormat_;
+    }
+
+  }
+}
@@ -7,6 +7,7 @@
  */
 
 #include <edge-ml-accelerator/utils/image_preprocess.h>
+#include <edge-ml-accelerator/utils/frame_pyramid.h>
 
 namespace edgeml
 {
@@ -27,42 +28,507 @@ namespace edgeml
     {
     }
 
+#if CV_SIMD128
     /**
-      Routine for scaling the image values by a scalar
-      @param image std::vector of unsigned char that is the input image
-      @param w int width
-      @param h int height
-      @param c int channels
-      @param scaleBy int scaling value
-      @return std::vector of float that is the scaled image
+      Widening 16 pixels of one channel into four float vectors
     */
-    std::vector<float> ImagePreProcess::scale(std::vector<unsigned char>& image, int& w, int& h, int& c, int& scaleBy)
+    static inline void expandToFloat(const cv::v_uint8x16& pixels, cv::v_float32x4* values)
     {
-        std::vector<float> data;
-        const unsigned char* ptr = image.data();
-        auto dataSize = w * h * c;
+      cv::v_uint16x8 low, high;
+      cv::v_expand(pixels, low, high);
+      cv::v_uint32x4 a, b, c, d;
+      cv::v_expand(low, a, b);
+      cv::v_expand(high, c, d);
+      values[0] = cv::v_cvt_f32(cv::v_reinterpret_as_s32(a));
+      values[1] = cv::v_cvt_f32(cv::v_reinterpret_as_s32(b));
+      values[2] = cv::v_cvt_f32(cv::v_reinterpret_as_s32(c));
+      values[3] = cv::v_cvt_f32(cv::v_reinterpret_as_s32(d));
+    }
+#endif
 
-        std::vector<float> in_data;
-        for (auto i = 0; i < dataSize; i ++)
+    /**
+      Normalizing one row of a packed image into floats. Tensor channel k is read from image channel order[k] and
+      written to dst[k] every dstStep floats, so the same routine fills planar (step 1) and interleaved (step C) rows.
+      1 and 3 channel rows are processed 16 pixels at a time with SIMD.
+    */
+    static void normalizeRow(const unsigned char* src, int width, int channels, const int* order, const float* scale, const float* offset, float* const* dst, int dstStep)
+    {
+      int x = 0;
+#if CV_SIMD128
+      cv::v_float32x4 vScale[4], vOffset[4], values[3][4];
+      for (int k=0; k<std::min(channels, 3); k++)
+      {
+        vScale[k] = cv::v_setall_f32(scale[k]);
+        vOffset[k] = cv::v_setall_f32(offset[k]);
+      }
+      if (channels==1)
+      {
+        for (; x<=width-16; x+=16)
         {
-            in_data.push_back(float(ptr[i] & 0xff));
+          expandToFloat(cv::v_load(src + x), values[0]);
+          for (int j=0; j<4; j++)
+          {
+            cv::v_store(dst[0] + x + 4*j, cv::v_fma(values[0][j], vScale[0], vOffset[0]));
+          }
         }
-
-        if (c == 3)
+      }
+      else if (channels==3)
+      {
+        for (; x<=width-16; x+=16)
         {
-            data.resize(w * h);
-            for (int i = 0; i < (int)in_data.size(); i = i + 3)
+          cv::v_uint8x16 pixels[3];
+          cv::v_load_deinterleave(src + 3*x, pixels[0], pixels[1], pixels[2]);
+          for (int k=0; k<3; k++)
+          {
+            expandToFloat(pixels[order[k]], values[k]);
+            for (int j=0; j<4; j++)
+            {
+              values[k][j] = cv::v_fma(values[k][j], vScale[k], vOffset[k]);
+            }
+          }
+          for (int j=0; j<4; j++)
+          {
+            if (dstStep==1)
+            {
+              for (int k=0; k<3; k++)
+              {
+                cv::v_store(dst[k] + x + 4*j, values[k][j]);
+              }
+            }
+            else
             {
-                auto me_ = std::max_element(in_data.begin() + i, in_data.begin() + i + 2);
-                float value = *me_;
-                data[i / 3] = value / (float)scaleBy;
+              cv::v_store_interleave(dst[0] + 3*(x + 4*j), values[0][j], values[1][j], values[2][j]);
             }
+          }
+        }
+      }
+#endif
+      for (; x<width; x++)
+      {
+        for (int k=0; k<channels; k++)
+        {
+          dst[k][(size_t)(x) * dstStep] = src[x*channels + order[k]] * scale[k] + offset[k];
+        }
+      }
+    }
+
+    /**
+      Narrowing a row of normalized floats into fp16, uint8 or int8 (saturated) tensor elements
+    */
+    static inline void narrowRow(const float* src, void* dst, int size, int dataType)
+    {
+      int depth = (dataType==TENSOR_TYPE_FLOAT16) ? CV_16F : (dataType==TENSOR_TYPE_INT8) ? CV_8S : CV_8U;
+      cv::Mat(1, size, CV_32FC1, (void*)(src)).convertTo(cv::Mat(1, size, CV_MAKETYPE(depth, 1), dst), depth);
+    }
+
+    /**
+      Writing one row of a packed image into 8-bit tensor elements without going through floats: the element is the
+      pixel plus an integer offset, saturated to the element type, e.g. pixel - 128 for int8 models with a zero point
+      of -128. Tensor channel k is read from image channel order[k] and written to dst[k] every dstStep elements.
+    */
+    template<typename T>
+    static void offsetRow(const unsigned char* src, int width, int channels, const int* order, const int* offset, T* const* dst, int dstStep)
+    {
+      for (int x=0; x<width; x++)
+      {
+        for (int k=0; k<channels; k++)
+        {
+          dst[k][(size_t)(x) * dstStep] = cv::saturate_cast<T>(src[x*channels + order[k]] + offset[k]);
+        }
+      }
+    }
+
+    /**
+      Normalizing one row of a packed image into row y of a tensor. Float32 tensors are written in place, 8-bit
+      tensors with integer parameters are offset in place, other element types are normalized into rowBuffer of
+      width x channels floats first and narrowed from there.
+    */
+    static void writeTensorRow(const unsigned char* row, int y, int width, int height, int channels, const int* order, const PreprocessParams& params, void* tensor, float* rowBuffer)
+    {
+      bool isPlanar = (params.layout==TENSOR_LAYOUT_NCHW && channels>1);
+      bool isFloat = (params.dataType==TENSOR_TYPE_FLOAT32);
+      size_t planeSize = (size_t)(width) * height, rowSize = (size_t)(width) * channels;
+
+      if (params.isInteger)
+      {
+        int offset[4];
+        unsigned char* dst[4];
+        for (int k=0; k<channels; k++)
+        {
+          offset[k] = (int)(std::lround(params.offset[k]));
+          dst[k] = (unsigned char*)(tensor) + (isPlanar ? k * planeSize + (size_t)(y) * width : (size_t)(y) * rowSize + k);
         }
+        if (params.dataType==TENSOR_TYPE_INT8)
+          offsetRow(row, width, channels, order, offset, (signed char* const*)(dst), isPlanar ? 1 : channels);
         else
+          offsetRow(row, width, channels, order, offset, (unsigned char* const*)(dst), isPlanar ? 1 : channels);
+        return;
+      }
+
+      float* dst[4];
+      for (int k=0; k<channels; k++)
+      {
+        size_t offset = isPlanar ? k * planeSize + (size_t)(y) * width : (size_t)(y) * rowSize + k;
+        dst[k] = isFloat ? (float*)(tensor) + offset : rowBuffer + (isPlanar ? k * width : k);
+      }
+      normalizeRow(row, width, channels, order, params.scale, params.offset, dst, isPlanar ? 1 : channels);
+      if (isFloat)
+      {
+        return;
+      }
+
+      unsigned char* output = (unsigned char*)(tensor);
+      size_t elementSize = ImagePreProcess::getTensorElementSize(params.dataType);
+      if (isPlanar)
+      {
+        for (int k=0; k<channels; k++)
+          narrowRow(dst[k], output + (k * planeSize + (size_t)(y) * width) * elementSize, width, params.dataType);
+      }
+      else
+      {
+        narrowRow(rowBuffer, output + (size_t)(y) * rowSize * elementSize, (int)(rowSize), params.dataType);
+      }
+    }
+
+    /**
+      Running a routine over the rows of a tensor, split into row bands over the OpenCV worker threads for large tensors
+    */
+    static void forEachRowBand(int rows, size_t elements, const std::function<void(const cv::Range&)>& body)
+    {
+      if (rows>1 && elements>=PARALLEL_PREPROCESS_MIN_ELEMENTS)
+        cv::parallel_for_(cv::Range(0, rows), body);
+      else
+        body(cv::Range(0, rows));
+    }
+
+    /**
+      Routine for normalizing a packed 8-bit image straight into the input tensor of a model in a single pass:
+      per channel scale and offset, channel order, NCHW or NHWC layout, and float32, float16, uint8 or int8 elements.
+      @param image unsigned char array of the image of size width x height x channels
+      @param width int width
+      @param height int height
+      @param channels int channels of the image and the tensor
+      @param params scale, offset, layout and element type of the tensor
+      @param tensor buffer of the tensor of size width x height x channels x element size
+      @param swapRB writing the first and third channel swapped, to take BGR images for RGB models and vice versa
+      @param step bytes per row of the image, e.g. of a tile inside a larger frame; 0 for packed rows
+      @return error code based on success/failure
+    */
+    int ImagePreProcess::normalize(const unsigned char* image, int width, int height, int channels, const PreprocessParams& params, void* tensor, bool swapRB, size_t step)
+    {
+      if (image==nullptr || tensor==nullptr || channels<1 || channels>4)
+      {
+        LOG_ERROR("[Utils::ImagePreProcessing] Cannot normalize an image with " + std::to_string(channels) + " channels");
+        return false;
+      }
+
+      int order[4] = {0, 1, 2, 3};
+      if (swapRB && channels>=3)
+      {
+        std::swap(order[0], order[2]);
+      }
+      bool isPlanar = (params.layout==TENSOR_LAYOUT_NCHW && channels>1);
+      size_t planeSize = (size_t)(width) * height;
+      size_t rowSize = (size_t)(width) * channels;
+      size_t imageStep = (step>0) ? step : rowSize;
+
+      // uint8 tensors without scaling only need their channels rearranged
+      if (params.dataType==TENSOR_TYPE_UINT8 && params.isIdentity)
+      {
+        if (!isPlanar && order[0]==0 && imageStep==rowSize)
+        {
+          std::memcpy(tensor, image, planeSize * channels);
+          return true;
+        }
+        src = cv::Mat(cv::Size(width, height), CV_8UC(channels), (void*)(image), imageStep);
+        std::vector<cv::Mat> outputs;
+        std::vector<int> fromTo;
+        for (int k=0; k<channels; k++)
+        {
+          fromTo.push_back(order[k]);
+          fromTo.push_back(k);
+          if (isPlanar)
+            outputs.push_back(cv::Mat(cv::Size(width, height), CV_8UC1, (unsigned char*)(tensor) + k * planeSize));
+        }
+        if (!isPlanar)
+          outputs.push_back(cv::Mat(cv::Size(width, height), CV_8UC(channels), tensor));
+        cv::mixChannels(std::vector<cv::Mat>{src}, outputs, fromTo);
+        return true;
+      }
+
+      forEachRowBand(height, planeSize * channels, [&](const cv::Range& band)
+      {
+        std::vector<float> rowBuffer((params.dataType==TENSOR_TYPE_FLOAT32 || params.isInteger) ? 0 : rowSize);
+        for (int y=band.start; y<band.end; y++)
+        {
+          writeTensorRow(image + (size_t)(y) * imageStep, y, width, height, channels, order, params, tensor, rowBuffer.data());
+        }
+      });
+
+      return true;
+    }
+
+    /**
+      Routine for resizing a frame and normalizing it into the input tensor of a model in one traversal. Every output
+      row is sampled (nearest or bilinear) from the frame into a small row buffer and normalized from there, so no
+      resized image is ever stored; row bands are spread over threads for large tensors. The sampling positions come
+      from a plan that is built on the first frame and reused as long as the frame size stays the same. Letterboxing
+      and lens undistortion are part of the plan, so the padding and the undistortion come with the same lookup.
+      YUV frames, and color frames for gray models, are converted first; with nearest sampling the conversion is
+      fused with the resize, with bilinear sampling the whole frame is converted and sampled through the plan.
+      @param inputImage unsigned char array of input image
+      @param width int width
+      @param height int height
+      @param inputFormat int pixel format of the input image
+      @param output_width int width of the model input
+      @param output_height int height of the model input
+      @param modelFormat int pixel format the model takes: RGB, BGR or GRAY
+      @param params interpolation, letterbox, undistortion, scale, offset, layout and element type of the tensor
+      @param plan passing by reference the plan of the model, rebuilt if it does not match the frame; its transform maps frame to tensor coordinates
+      @param tensor buffer of the tensor of size output_width x output_height x channels x element size
+      @param pyramid optional pyramid of the frame, the resized frame is then taken from it and shared with other consumers
+      @param inputStep bytes per row of an RGB, BGR or GRAY input image that is a tile of a larger frame; 0 for packed rows
+      @return error code based on success/failure
+    */
+    int ImagePreProcess::resizeNormalize(const unsigned char* inputImage, int width, int height, int inputFormat, int output_width, int output_height, int modelFormat, const PreprocessParams& params, PreprocessPlan& plan, void* tensor, FramePyramid* pyramid, size_t inputStep)
+    {
+      int resizeFormat = getResizeFormat(inputFormat, modelFormat);
+      bool swapRB = (resizeFormat!=modelFormat);
+      bool isUndistort = !params.cameraMatrix.empty();
+      int channels = (modelFormat==PIXEL_FORMAT_GRAY) ? 1 : 3;
+
+      if (!plan.matches(width, height, channels, output_width, output_height))
+      {
+        ret = buildPlan(plan, width, height, channels, output_width, output_height, params);
+        if (!ret)
+        {
+          return ret;
+        }
+      }
+
+      // Padded or undistorted inputs are specific to the model, anything else is a level of the pyramid
+      bool isSameFrame = (width==output_width && height==output_height && resizeFormat==inputFormat);
+      if (pyramid && !isUndistort && !params.letterbox && !isSameFrame)
+      {
+        const cv::Mat& level = pyramid->getLevel(output_width, output_height, resizeFormat, params.interpolation);
+        if (level.empty())
+        {
+          return false;
+        }
+        return normalize(level.data, output_width, output_height, channels, params, tensor, swapRB);
+      }
+
+      // Tiles are read in place from the frame, only tiles that need converting are copied since conversions take packed images
+      if (inputStep>0 && resizeFormat!=inputFormat)
+      {
+        cv::Mat(cv::Size(width, height), (inputFormat==PIXEL_FORMAT_GRAY) ? CV_8UC1 : CV_8UC3, (void*)(inputImage), inputStep).copyTo(tile);
+        inputImage = tile.data;
+        inputStep = 0;
+      }
+
+      bool isLinear = (params.interpolation==cv::INTER_LINEAR);
+      if (resizeFormat!=inputFormat)
+      {
+        // The resize fused with the conversion samples the nearest pixel only
+        if (!isUndistort && !params.letterbox && !isLinear)
+        {
+          resized.create(output_height, output_width, CV_8UC(channels));
+          ret = resize((unsigned char*)(inputImage), width, height, inputFormat, resized.data, output_width, output_height, resizeFormat);
+          return ret && normalize(resized.data, output_width, output_height, channels, params, tensor, swapRB);
+        }
+        // Bilinear sampling, undistortion and letterboxing go through the plan, so the whole frame is converted first
+        ret = convert(inputImage, width, height, inputFormat, converted, resizeFormat);
+        if (!ret)
+        {
+          return ret;
+        }
+        inputImage = converted.data;
+      }
+      if (width==output_width && height==output_height && !isUndistort)
+      {
+        return normalize(inputImage, width, height, channels, params, tensor, swapRB, inputStep);
+      }
+
+      int order[4] = {0, 1, 2, 3};
+      if (swapRB)
+      {
+        std::swap(order[0], order[2]);
+      }
+      size_t inputRowSize = (inputStep>0) ? inputStep : (size_t)(width) * channels;
+      size_t rowSize = (size_t)(output_width) * channels;
+      cv::Mat frame(cv::Size(width, height), CV_8UC(channels), (void*)(inputImage), inputRowSize);
+
+      forEachRowBand(output_height, rowSize * output_height, [&](const cv::Range& band)
+      {
+        std::vector<float> rowBuffer((params.dataType==TENSOR_TYPE_FLOAT32 || params.isInteger) ? 0 : rowSize);
+        if (isUndistort)
+        {
+          cv::Mat sampled;
+          cv::remap(frame, sampled, plan.mapXY.rowRange(band.start, band.end), plan.mapWeights.empty() ? cv::Mat() : plan.mapWeights.rowRange(band.start, band.end), params.interpolation, cv::BORDER_CONSTANT, cv::Scalar::all(params.letterbox ? params.padValue : 0));
+          for (int y=band.start; y<band.end; y++)
+          {
+            writeTensorRow(sampled.ptr<unsigned char>(y - band.start), y, output_width, output_height, channels, order, params, tensor, rowBuffer.data());
+          }
+          return;
+        }
+
+        // Columns outside the content are never sampled and keep the pad value
+        std::vector<unsigned char> sampled(rowSize, (unsigned char)(params.padValue));
+        std::vector<unsigned char> padded(plan.contentY1-plan.contentY0<output_height ? rowSize : 0, (unsigned char)(params.padValue));
+        for (int y=band.start; y<band.end; y++)
+        {
+          if (y<plan.contentY0 || y>=plan.contentY1)
+          {
+            writeTensorRow(padded.data(), y, output_width, output_height, channels, order, params, tensor, rowBuffer.data());
+            continue;
+          }
+          const unsigned char* row0 = inputImage + (size_t)(plan.yRow0[y]) * inputRowSize;
+          if (isLinear)
+          {
+            const unsigned char* row1 = inputImage + (size_t)(plan.yRow1[y]) * inputRowSize;
+            int wy = plan.yWeight[y];
+            for (int x=plan.contentX0; x<plan.contentX1; x++)
+            {
+              int x0 = plan.xOffset0[x], x1 = plan.xOffset1[x], wx = plan.xWeight[x];
+              for (int k=0; k<channels; k++)
+              {
+                int top = row0[x0+k] * (SAMPLING_WEIGHT_ONE - wx) + row0[x1+k] * wx;
+                int bottom = row1[x0+k] * (SAMPLING_WEIGHT_ONE - wx) + row1[x1+k] * wx;
+                sampled[x*channels + k] = (unsigned char)((top * (SAMPLING_WEIGHT_ONE - wy) + bottom * wy + (1 << (2*SAMPLING_WEIGHT_BITS - 1))) >> (2*SAMPLING_WEIGHT_BITS));
+              }
+            }
+          }
+          else
+          {
+            for (int x=plan.contentX0; x<plan.contentX1; x++)
+            {
+              for (int k=0; k<channels; k++)
+              {
+                sampled[x*channels + k] = row0[plan.xOffset0[x] + k];
+              }
+            }
+          }
+          writeTensorRow(sampled.data(), y, output_width, output_height, channels, order, params, tensor, rowBuffer.data());
+        }
+      });
+
+      return true;
+    }
+
+    /**
+      Computing the source position and bilinear weight of one output coordinate along one axis
+    */
+    static inline void getSamplePosition(int index, float scale, int size, bool isLinear, int& position, int& weight)
+    {
+      weight = 0;
+      if (!isLinear)
+      {
+        position = std::min((int)((index + 0.5f) * scale), size-1);
+        return;
+      }
+      float f = (index + 0.5f) * scale - 0.5f;
+      position = (int)(std::floor(f));
+      weight = std::min((int)((f - position) * SAMPLING_WEIGHT_ONE + 0.5f), SAMPLING_WEIGHT_ONE);
+      if (position<0)
+      {
+        position = 0;
+        weight = 0;
+      }
+      if (position>=size-1)
+      {
+        position = size-1;
+        weight = 0;
+      }
+    }
+
+    /**
+      Building the sampling plan of a frame size into a model input size: the frame to model transform (a stretch,
+      or with letterboxing one scale for both axes plus padding), then either the source rows, columns and bilinear
+      weights of the covered region, or with lens undistortion the remap maps that undistort straight into the model input.
+      @param plan passing by reference the plan to build
+      @param width int width of the frame
+      @param height int height of the frame
+      @param channels int channels of the frame
+      @param output_width int width of the model input
+      @param output_height int height of the model input
+      @param params interpolation, letterbox and undistortion of the model
+      @return error code based on success/failure
+    */
+    int ImagePreProcess::buildPlan(PreprocessPlan& plan, int width, int height, int channels, int output_width, int output_height, const PreprocessParams& params)
+    {
+      plan = PreprocessPlan();
+      if (width<=0 || height<=0 || output_width<=0 || output_height<=0)
+      {
+        LOG_ERROR("[Utils::ImagePreProcessing] Cannot build a preprocess plan for [H,W] = [" + std::to_string(height) + "," + std::to_string(width) + "]");
+        return false;
+      }
+
+      // Output region covered by the frame and the frame to model transform
+      int contentWidth = output_width, contentHeight = output_height;
+      plan.transform.gainX = (float)(output_width) / width;
+      plan.transform.gainY = (float)(output_height) / height;
+      if (params.letterbox)
+      {
+        float gain = std::min(plan.transform.gainX, plan.transform.gainY);
+        if (!params.scaleUp)
+        {
+          gain = std::min(gain, 1.0f);
+        }
+        contentWidth = std::min((int)(std::round(width * gain)), output_width);
+        contentHeight = std::min((int)(std::round(height * gain)), output_height);
+        int stride = std::max(params.stride, 1);
+        plan.contentX0 = ((output_width - contentWidth) / 2 / stride) * stride;
+        plan.contentY0 = ((output_height - contentHeight) / 2 / stride) * stride;
+        plan.transform.gainX = (float)(contentWidth) / width;
+        plan.transform.gainY = (float)(contentHeight) / height;
+        plan.transform.padX = (float)(plan.contentX0);
+        plan.transform.padY = (float)(plan.contentY0);
+      }
+      plan.contentX1 = plan.contentX0 + contentWidth;
+      plan.contentY1 = plan.contentY0 + contentHeight;
+
+      if (!params.cameraMatrix.empty())
+      {
+        // The new camera matrix maps the undistorted frame onto the model input, so one lookup does all of it
+        cv::Mat outputMatrix = params.cameraMatrix.clone();
+        cv::Mat rowX = outputMatrix.row(0), rowY = outputMatrix.row(1);
+        rowX *= plan.transform.gainX;
+        rowY *= plan.transform.gainY;
+        outputMatrix.at<double>(0, 2) += plan.transform.padX;
+        outputMatrix.at<double>(1, 2) += plan.transform.padY;
+        cv::initUndistortRectifyMap(params.cameraMatrix, params.distCoeffs, cv::Mat(), outputMatrix, cv::Size(output_width, output_height), CV_16SC2, plan.mapXY, plan.mapWeights);
+      }
+      else
+      {
+        bool isLinear = (params.interpolation==cv::INTER_LINEAR);
+        float scaleX = (float)(width) / contentWidth, scaleY = (float)(height) / contentHeight;
+        plan.xOffset0.assign(output_width, 0);
+        plan.xOffset1.assign(output_width, 0);
+        plan.xWeight.assign(output_width, 0);
+        for (int x=plan.contentX0; x<plan.contentX1; x++)
+        {
+          int x0;
+          getSamplePosition(x - plan.contentX0, scaleX, width, isLinear, x0, plan.xWeight[x]);
+          plan.xOffset0[x] = x0 * channels;
+          plan.xOffset1[x] = std::min(x0+1, width-1) * channels;
+        }
+        plan.yRow0.assign(output_height, 0);
+        plan.yRow1.assign(output_height, 0);
+        plan.yWeight.assign(output_height, 0);
+        for (int y=plan.contentY0; y<plan.contentY1; y++)
         {
-            LOG_ALWAYS("[Utils::ImagePreProcessing] Support 3 channels bmp only, and the input is " + std::to_string(c) + " channels.");
+          getSamplePosition(y - plan.contentY0, scaleY, height, isLinear, plan.yRow0[y], plan.yWeight[y]);
+          plan.yRow1[y] = std::min(plan.yRow0[y]+1, height-1);
         }
-        return data;
+      }
+
+      plan.width = width;
+      plan.height = height;
+      plan.channels = channels;
+      plan.output_width = output_width;
+      plan.output_height = output_height;
+      LOG_ALWAYS("[Utils::ImagePreProcessing] Built preprocess plan from [H,W] = [" + std::to_string(height) + "," + std::to_string(width) + "] to [" + std::to_string(output_height) + "," + std::to_string(output_width) + "]" + (params.letterbox ? " letterboxed at [" + std::to_string(plan.contentY0) + "," + std::to_string(plan.contentX0) + "]" : "") + (params.cameraMatrix.empty() ? "" : " with undistortion"));
+      return true;
     }
 
     /**
@@ -82,12 +548,133 @@ namespace edgeml
         src = cv::Mat(cv::Size(width, height), CV_8UC1, (void*)(inputImage));
       else if (input_channels==3)
         src = cv::Mat(cv::Size(width, height), CV_8UC3, (void*)(inputImage));
+      dst = cv::Mat(cv::Size(output_width, output_height), src.type(), (void*)(outputImage));
       cv::resize(src, dst, cv::Size(output_width, output_height), 0, 0, cv::INTER_NEAREST_EXACT);
-      outputImage = (unsigned char*)(dst.data);
 
       return true;
     }
 
+    /**
+      Routine for resizing a frame of any pixel format into a packed RGB, BGR or GRAY image. When downscaling YUV
+      frames, the planes are resized first so that only the output pixels are color converted.
+      @param inputImage unsigned char array of input image
+      @param width int width
+      @param height int height
+      @param inputFormat int pixel format of the input image
+      @param outputImage unsigned char array of output image of size output_width x output_height x channels
+      @param output_width int width for output
+      @param output_height int height for output
+      @param outputFormat int pixel format for output: RGB, BGR or GRAY
+      @return error code based on success/failure
+    */
+    int ImagePreProcess::resize(unsigned char* inputImage, int width, int height, int inputFormat, unsigned char* outputImage, int output_width, int output_height, int outputFormat)
+    {
+      cv::Mat output(cv::Size(output_width, output_height), (outputFormat==PIXEL_FORMAT_GRAY) ? CV_8UC1 : CV_8UC3, (void*)(outputImage));
+      bool isSameSize = (width==output_width && height==output_height);
+      bool isYuv = (inputFormat==PIXEL_FORMAT_NV12 || inputFormat==PIXEL_FORMAT_I420);
+
+      if (inputFormat==outputFormat || (isYuv && outputFormat==PIXEL_FORMAT_GRAY))
+      {
+        // Same format, or the luma plane of a YUV frame is the gray image
+        src = cv::Mat(cv::Size(width, height), output.type(), (void*)(inputImage));
+        if (isSameSize)
+          src.copyTo(output);
+        else
+          cv::resize(src, output, output.size(), 0, 0, cv::INTER_NEAREST_EXACT);
+        return true;
+      }
+
+      bool isDownscale = (output_width * output_height <= width * height);
+      bool isEven = (width%2==0 && height%2==0 && output_width%2==0 && output_height%2==0);
+      if (isYuv && !isSameSize && isDownscale && isEven)
+      {
+        size_t lumaSize = (size_t)(width) * height, outputLumaSize = (size_t)(output_width) * output_height;
+        cv::Mat luma(cv::Size(width, height), CV_8UC1, (void*)(inputImage));
+        if (inputFormat==PIXEL_FORMAT_NV12)
+        {
+          cv::Mat chroma(cv::Size(width/2, height/2), CV_8UC2, (void*)(inputImage + lumaSize));
+          cv::resize(luma, yuvLuma, output.size(), 0, 0, cv::INTER_NEAREST_EXACT);
+          cv::resize(chroma, yuvChroma, cv::Size(output_width/2, output_height/2), 0, 0, cv::INTER_NEAREST_EXACT);
+          cv::cvtColorTwoPlane(yuvLuma, yuvChroma, output, (outputFormat==PIXEL_FORMAT_BGR) ? cv::COLOR_YUV2BGR_NV12 : cv::COLOR_YUV2RGB_NV12);
+        }
+        else
+        {
+          yuvPlanar.create(output_height * 3 / 2, output_width, CV_8UC1);
+          cv::Mat outputLuma(output.size(), CV_8UC1, yuvPlanar.data);
+          cv::Mat outputU(cv::Size(output_width/2, output_height/2), CV_8UC1, yuvPlanar.data + outputLumaSize);
+          cv::Mat outputV(cv::Size(output_width/2, output_height/2), CV_8UC1, yuvPlanar.data + outputLumaSize + outputLumaSize/4);
+          cv::resize(luma, outputLuma, outputLuma.size(), 0, 0, cv::INTER_NEAREST_EXACT);
+          cv::resize(cv::Mat(cv::Size(width/2, height/2), CV_8UC1, (void*)(inputImage + lumaSize)), outputU, outputU.size(), 0, 0, cv::INTER_NEAREST_EXACT);
+          cv::resize(cv::Mat(cv::Size(width/2, height/2), CV_8UC1, (void*)(inputImage + lumaSize + lumaSize/4)), outputV, outputV.size(), 0, 0, cv::INTER_NEAREST_EXACT);
+          cv::cvtColor(yuvPlanar, output, (outputFormat==PIXEL_FORMAT_BGR) ? cv::COLOR_YUV2BGR_I420 : cv::COLOR_YUV2RGB_I420);
+        }
+        return true;
+      }
+
+      // Converting at the smaller of both sizes: directly into the output if no resize is needed
+      if (isSameSize)
+      {
+        return convert(inputImage, width, height, inputFormat, output, outputFormat);
+      }
+      if (isDownscale && !isYuv)
+      {
+        src = cv::Mat(cv::Size(width, height), (inputFormat==PIXEL_FORMAT_GRAY) ? CV_8UC1 : CV_8UC3, (void*)(inputImage));
+        cv::resize(src, dst, output.size(), 0, 0, cv::INTER_NEAREST_EXACT);
+        return convert(dst.data, output_width, output_height, inputFormat, output, outputFormat);
+      }
+      ret = convert(inputImage, width, height, inputFormat, converted, outputFormat);
+      cv::resize(converted, output, output.size(), 0, 0, cv::INTER_NEAREST_EXACT);
+      return ret;
+    }
+
+    /**
+      Routine for converting a frame between pixel formats in a single pass
+      @param inputImage unsigned char array of input image
+      @param width int width
+      @param height int height
+      @param inputFormat int pixel format of the input image
+      @param outputImage cv::Mat to write into, reused if it already has the right size and type
+      @param outputFormat int pixel format for output: RGB, BGR or GRAY
+      @return error code based on success/failure
+    */
+    int ImagePreProcess::convert(const unsigned char* inputImage, int width, int height, int inputFormat, cv::Mat& outputImage, int outputFormat)
+    {
+      bool isGray = (outputFormat==PIXEL_FORMAT_GRAY), isBGR = (outputFormat==PIXEL_FORMAT_BGR);
+      int code = -1;
+      switch (inputFormat)
+      {
+        case PIXEL_FORMAT_RGB:
+          src = cv::Mat(cv::Size(width, height), CV_8UC3, (void*)(inputImage));
+          code = isGray ? cv::COLOR_RGB2GRAY : (isBGR ? cv::COLOR_RGB2BGR : -1);
+          break;
+        case PIXEL_FORMAT_BGR:
+          src = cv::Mat(cv::Size(width, height), CV_8UC3, (void*)(inputImage));
+          code = isGray ? cv::COLOR_BGR2GRAY : (isBGR ? -1 : cv::COLOR_BGR2RGB);
+          break;
+        case PIXEL_FORMAT_GRAY:
+          src = cv::Mat(cv::Size(width, height), CV_8UC1, (void*)(inputImage));
+          code = isGray ? -1 : cv::COLOR_GRAY2BGR;
+          break;
+        case PIXEL_FORMAT_NV12:
+          src = cv::Mat(cv::Size(width, height * 3 / 2), CV_8UC1, (void*)(inputImage));
+          code = isGray ? cv::COLOR_YUV2GRAY_NV12 : (isBGR ? cv::COLOR_YUV2BGR_NV12 : cv::COLOR_YUV2RGB_NV12);
+          break;
+        case PIXEL_FORMAT_I420:
+          src = cv::Mat(cv::Size(width, height * 3 / 2), CV_8UC1, (void*)(inputImage));
+          code = isGray ? cv::COLOR_YUV2GRAY_I420 : (isBGR ? cv::COLOR_YUV2BGR_I420 : cv::COLOR_YUV2RGB_I420);
+          break;
+        default:
+          LOG_ERROR("[Utils::ImagePreProcessing] Unsupported input pixel format " + std::to_string(inputFormat));
+          return false;
+      }
+
+      if (code<0)
+        src.copyTo(outputImage);
+      else
+        cv::cvtColor(src, outputImage, code);
+      return true;
+    }
+
     /**
       Routine for scaling the image values by a scalar
       @param filename char const array of filename
@@ -108,7 +695,10 @@ namespace edgeml
       {
         src = cv::Mat(cv::Size(width, height), CV_8UC3, (void*)(data));
         if (colorspace=="RGB" || colorspace=="rgb")
-          cv::cvtColor(src, src, cv::COLOR_RGB2BGR);
+        {
+          cv::cvtColor(src, converted, cv::COLOR_RGB2BGR); // the frame may still be read by other consumers
+          src = converted;
+        }
       }
 
       cv::imwrite(filename, src);
@@ -116,5 +706,324 @@ namespace edgeml
       return true;
     }
 
+    /**
+      Routine for encoding a frame of any pixel format. BGR and GRAY frames are encoded as they are, other formats
+      are converted in a single pass into a reused buffer without touching the frame itself.
+      @param filename char const array of filename
+      @param width int width
+      @param height int height
+      @param pixelFormat int pixel format of the frame
+      @param data constant char array of the data to be stored
+      @return error code based on success/failure
+    */
+    int ImagePreProcess::write(const char *filename, int width, int height, int pixelFormat, const void *data)
+    {
+      if (pixelFormat==PIXEL_FORMAT_BGR || pixelFormat==PIXEL_FORMAT_GRAY)
+      {
+        src = cv::Mat(cv::Size(width, height), (pixelFormat==PIXEL_FORMAT_GRAY) ? CV_8UC1 : CV_8UC3, (void*)(data));
+        cv::imwrite(filename, src);
+        return true;
+      }
+
+      // The OpenCV encoders only take BGR or GRAY
+      ret = convert((const unsigned char*)(data), width, height, pixelFormat, converted, PIXEL_FORMAT_BGR);
+      if (ret)
+      {
+        cv::imwrite(filename, converted);
+      }
+      return ret;
+    }
+
+    /**
+      Getting the pixel format of a color space name
+      @param colorspace name of the color space like RGB, BGR, GRAY, NV12 or I420
+      @return int pixel format, RGB if unknown
+    */
+    int ImagePreProcess::getPixelFormat(std::string colorspace)
+    {
+      std::transform(colorspace.begin(), colorspace.end(), colorspace.begin(), ::toupper);
+      if (colorspace=="BGR")
+        return PIXEL_FORMAT_BGR;
+      if (colorspace=="GRAY" || colorspace=="MONO8")
+        return PIXEL_FORMAT_GRAY;
+      if (colorspace=="NV12")
+        return PIXEL_FORMAT_NV12;
+      if (colorspace=="I420")
+        return PIXEL_FORMAT_I420;
+      return PIXEL_FORMAT_RGB;
+    }
+
+    /**
+      Getting the pixel format of a frame, falling back to the configured color space for untagged frames
+      @param pixelFormat int pixel format tag of the frame
+      @param colorspace configured color space
+      @return int pixel format
+    */
+    int ImagePreProcess::resolvePixelFormat(int pixelFormat, std::string colorspace)
+    {
+      return (pixelFormat==PIXEL_FORMAT_UNKNOWN) ? getPixelFormat(colorspace) : pixelFormat;
+    }
+
+    /**
+      Getting the size of a frame in bytes
+      @param width int width
+      @param height int height
+      @param pixelFormat int pixel format of the frame
+      @return int size in bytes
+    */
+    int ImagePreProcess::getFrameSize(int width, int height, int pixelFormat)
+    {
+      switch (pixelFormat)
+      {
+        case PIXEL_FORMAT_GRAY:
+          return width * height;
+        case PIXEL_FORMAT_NV12:
+        case PIXEL_FORMAT_I420:
+          return width * height * 3 / 2;
+        default:
+          return width * height * 3;
+      }
+    }
+
+      /**
+      Getting the format to resize a frame into for a model. RGB and BGR frames keep their channel order since
+      the normalize step can swap channels for free, other formats are converted to the model format.
+      @param frameFormat int pixel format of the frame
+      @param modelFormat int pixel format the model takes
+      @return int pixel format of the resized image, swap the channels while normalizing if it differs from modelFormat
+    */
+    int ImagePreProcess::getResizeFormat(int frameFormat, int modelFormat)
+    {
+      bool isFrameColor = (frameFormat==PIXEL_FORMAT_RGB || frameFormat==PIXEL_FORMAT_BGR);
+      bool isModelColor = (modelFormat==PIXEL_FORMAT_RGB || modelFormat==PIXEL_FORMAT_BGR);
+      return (isFrameColor && isModelColor) ? frameFormat : modelFormat;
+    }
+
+    /**
+      Getting the preprocess parameters of a model from the preprocess config. The value written for a pixel p of
+      channel c is (p / scaleBy - mean[c]) / std[c], with mean and std given in the channel order of the model.
+      8-bit tensors of quantized models get v / quantization.scale + quantization.zeroPoint instead, int8 tensors
+      without quantization default to a zero point of -128 so the pixel range maps onto the element range.
+      @param preprocess preprocess section of the config with scaleBy, mean, std, quantization, layout, interpolation, letterbox and undistort
+      @param layout int layout of the model input, overridden by layout "NCHW" | "NHWC" in the config
+      @param dataType int element type of the model input
+      @return PreprocessParams of the model
+    */
+    PreprocessParams ImagePreProcess::getPreprocessParams(jsonParser::jValue preprocess, int layout, int dataType)
+    {
+      PreprocessParams params;
+      params.layout = layout;
+      params.dataType = dataType;
+
+      std::string layoutName = preprocess["layout"].as_string();
+      std::transform(layoutName.begin(), layoutName.end(), layoutName.begin(), ::toupper);
+      if (layoutName=="NCHW")
+        params.layout = TENSOR_LAYOUT_NCHW;
+      else if (layoutName=="NHWC")
+        params.layout = TENSOR_LAYOUT_NHWC;
+
+      std::string interpolation = preprocess["interpolation"].as_string();
+      std::transform(interpolation.begin(), interpolation.end(), interpolation.begin(), ::toupper);
+      if (interpolation=="LINEAR" || interpolation=="BILINEAR")
+        params.interpolation = cv::INTER_LINEAR;
+
+      // Aspect preserving resize with padding, like the letterbox used for training most detectors
+      if (preprocess["letterbox"].get_type()==jsonParser::JOBJECT || preprocess["letterbox"].as_bool())
+      {
+        params.letterbox = true;
+        if (preprocess["letterbox"]["padValue"].get_type()!=jsonParser::JUNKNOWN)
+          params.padValue = std::min(std::max(preprocess["letterbox"]["padValue"].as_int(), 0), 255);
+        if (preprocess["letterbox"]["stride"].get_type()==jsonParser::JNUMBER && preprocess["letterbox"]["stride"].as_int()>0)
+          params.stride = preprocess["letterbox"]["stride"].as_int();
+        if (preprocess["letterbox"]["scaleUp"].get_type()!=jsonParser::JUNKNOWN)
+          params.scaleUp = preprocess["letterbox"]["scaleUp"].as_bool();
+      }
+
+      // Lens undistortion with the camera matrix and distortion coefficients of the frame as captured
+      if (preprocess["undistort"]["cameraMatrix"].size()==9)
+      {
+        params.cameraMatrix = cv::Mat(3, 3, CV_64FC1);
+        for (int k=0; k<9; k++)
+          params.cameraMatrix.at<double>(k/3, k%3) = preprocess["undistort"]["cameraMatrix"][k].as_double();
+        params.distCoeffs = cv::Mat::zeros(1, std::max(preprocess["undistort"]["distCoeffs"].size(), 4), CV_64FC1);
+        for (int k=0; k<preprocess["undistort"]["distCoeffs"].size(); k++)
+          params.distCoeffs.at<double>(0, k) = preprocess["undistort"]["distCoeffs"][k].as_double();
+      }
+
+      // Missing numbers are not read, jValue leaves them uninitialized
+      double scaleBy = (preprocess["scaleBy"].get_type()==jsonParser::JNUMBER) ? preprocess["scaleBy"].as_double() : 1.0;
+      if (scaleBy<=0)
+      {
+        scaleBy = 1.0;
+      }
+      int numMean = preprocess["mean"].size(), numStd = preprocess["std"].size();
+      for (int k=0; k<4; k++)
+      {
+        double mean = (numMean>0) ? preprocess["mean"][std::min(k, numMean-1)].as_double() : 0.0;
+        double stdDev = (numStd>0) ? preprocess["std"][std::min(k, numStd-1)].as_double() : 1.0;
+        if (stdDev==0)
+        {
+          stdDev = 1.0;
+        }
+        params.scale[k] = (float)(1.0 / (scaleBy * stdDev));
+        params.offset[k] = (float)(-mean / stdDev);
+        params.isIdentity = params.isIdentity && params.scale[k]==1.0f && params.offset[k]==0.0f;
+      }
+
+      // Folding the input quantization of uint8 / int8 models into the scale and offset
+      if (dataType==TENSOR_TYPE_UINT8 || dataType==TENSOR_TYPE_INT8)
+      {
+        double quantScale = (preprocess["quantization"]["scale"].get_type()==jsonParser::JNUMBER) ? preprocess["quantization"]["scale"].as_double() : 1.0;
+        double zeroPoint = (preprocess["quantization"]["zeroPoint"].get_type()==jsonParser::JNUMBER) ? preprocess["quantization"]["zeroPoint"].as_double() : 0.0;
+        if (quantScale<=0)
+        {
+          quantScale = 1.0;
+        }
+        if (preprocess["quantization"]["zeroPoint"].get_type()==jsonParser::JUNKNOWN && dataType==TENSOR_TYPE_INT8 && params.isIdentity)
+        {
+          zeroPoint = -128.0;
+        }
+
+        params.isInteger = true;
+        for (int k=0; k<4; k++)
+        {
+          params.scale[k] = (float)(params.scale[k] / quantScale);
+          params.offset[k] = (float)(params.offset[k] / quantScale + zeroPoint);
+          params.isInteger = params.isInteger && std::fabs(params.scale[k] - 1.0f)<1e-4f && std::fabs(params.offset[k] - std::round(params.offset[k]))<1e-4f;
+        }
+        params.isIdentity = params.isInteger && dataType==TENSOR_TYPE_UINT8;
+        for (int k=0; k<4 && params.isIdentity; k++)
+        {
+          params.isIdentity = (std::lround(params.offset[k])==0);
+        }
+      }
+
+      LOG_ALWAYS("[Utils::ImagePreProcessing] Normalizing into " + std::string(TensorLayoutsE[params.layout]) + " " + std::string(TensorTypesE[params.dataType]) + " tensors with scale " + std::to_string(params.scale[0]) + " and offset " + std::to_string(params.offset[0]) + " for the first channel");
+      return params;
+    }
+
+    /**
+      Getting the size of a tensor element in bytes
+      @param dataType int element type of the tensor
+      @return int size in bytes
+    */
+    int ImagePreProcess::getTensorElementSize(int dataType)
+    {
+      switch (dataType)
+      {
+        case TENSOR_TYPE_FLOAT16:
+          return 2;
+        case TENSOR_TYPE_UINT8:
+        case TENSOR_TYPE_INT8:
+          return 1;
+        default:
+          return 4;
+      }
+    }
+
+    /**
+      Getting the tiling of a model from its config: true, or an object with tileWidth, tileHeight, overlap,
+      batchSize, scoreThreshold and nmsThreshold
+      @param tiling jValue tiling section of the model
+      @return tiling parameters, disabled if not configured
+    */
+    TilingParams ImagePreProcess::getTilingParams(jsonParser::jValue tiling)
+    {
+      TilingParams params;
+      if (tiling.get_type()!=jsonParser::JOBJECT && !tiling.as_bool())
+      {
+        return params;
+      }
+
+      params.enabled = true;
+      if (tiling["tileWidth"].get_type()==jsonParser::JNUMBER)
+        params.tileWidth = std::max(tiling["tileWidth"].as_int(), 0);
+      if (tiling["tileHeight"].get_type()==jsonParser::JNUMBER)
+        params.tileHeight = std::max(tiling["tileHeight"].as_int(), 0);
+      if (tiling["overlap"].get_type()==jsonParser::JNUMBER)
+        params.overlap = std::max(tiling["overlap"].as_int(), 0);
+      if (tiling["batchSize"].get_type()==jsonParser::JNUMBER)
+        params.batchSize = std::max(tiling["batchSize"].as_int(), 0);
+      if (tiling["scoreThreshold"].get_type()!=jsonParser::JUNKNOWN)
+        params.scoreThreshold = (float)(tiling["scoreThreshold"].as_double());
+      if (tiling["nmsThreshold"].get_type()!=jsonParser::JUNKNOWN)
+        params.nmsThreshold = (float)(tiling["nmsThreshold"].as_double());
+      return params;
+    }
+
+    /**
+      Getting the tiles covering a frame. All tiles have the same size, the last tile of a row or column is moved
+      back inside the frame instead of being cut, so one preprocess plan serves every tile.
+      @param width int width of the frame
+      @param height int height of the frame
+      @param tiling tile size and overlap, the tile size must be set
+      @return tiles in row major order
+    */
+    std::vector<cv::Rect> ImagePreProcess::getTiles(int width, int height, const TilingParams& tiling)
+    {
+      std::vector<cv::Rect> tiles;
+      int tileWidth = std::min(tiling.tileWidth, width), tileHeight = std::min(tiling.tileHeight, height);
+      if (tileWidth<=0 || tileHeight<=0)
+      {
+        return tiles;
+      }
+      int stepX = std::max(tileWidth - tiling.overlap, 1), stepY = std::max(tileHeight - tiling.overlap, 1);
+      for (int y=0; ; y+=stepY)
+      {
+        int tileY = std::min(y, height - tileHeight);
+        for (int x=0; ; x+=stepX)
+        {
+          int tileX = std::min(x, width - tileWidth);
+          tiles.push_back(cv::Rect(tileX, tileY, tileWidth, tileHeight));
+          if (tileX + tileWidth>=width)
+            break;
+        }
+        if (tileY + tileHeight>=height)
+          break;
+      }
+      return tiles;
+    }
+
+    /**
+      Getting regions of interest from the config: an array of objects with name, x, y, width and height
+      @param rois jValue array of regions
+      @return regions, unnamed regions are named by their index and missing coordinates are 0
+    */
+    std::vector<RegionOfInterest> ImagePreProcess::getRois(jsonParser::jValue rois)
+    {
+      std::vector<RegionOfInterest> regions;
+      for (int r=0; r<rois.size(); r++)
+      {
+        RegionOfInterest roi;
+        roi.name = rois[r]["name"].as_string();
+        if (roi.name.empty())
+          roi.name = "roi" + std::to_string(r);
+        roi.x = (rois[r]["x"].get_type()==jsonParser::JNUMBER) ? rois[r]["x"].as_int() : 0;
+        roi.y = (rois[r]["y"].get_type()==jsonParser::JNUMBER) ? rois[r]["y"].as_int() : 0;
+        roi.width = (rois[r]["width"].get_type()==jsonParser::JNUMBER) ? rois[r]["width"].as_int() : 0;
+        roi.height = (rois[r]["height"].get_type()==jsonParser::JNUMBER) ? rois[r]["height"].as_int() : 0;
+        regions.push_back(roi);
+      }
+      return regions;
+    }
+
+    /**
+      Getting the crops of regions of interest inside a frame. Regions are clipped to the frame, a region outside the
+      frame gives an empty crop so crops stay aligned with the regions.
+      @param rois regions of interest
+      @param width int width of the frame
+      @param height int height of the frame
+      @return one crop per region
+    */
+    std::vector<cv::Rect> ImagePreProcess::getCrops(const std::vector<RegionOfInterest>& rois, int width, int height)
+    {
+      std::vector<cv::Rect> crops;
+      for (auto& roi : rois)
+      {
+        crops.push_back(cv::Rect(roi.x, roi.y, roi.width, roi.height) & cv::Rect(0, 0, width, height));
+      }
+      return crops;
+    }
+
   }
 }
@@ -60,12 +60,29 @@ namespace edgeml
       @return BBoxResultsS
     */
     void ResultPostProcess::getBBoxResults(std::vector<std::vector<float> >& outputBboxes, float* results, std::vector<int> models_shape, std::vector<int> results_shape, int height, int width, float thresh)
+    {
+      // The model input is a plain stretch of the image
+      PreprocessTransform transform;
+      transform.gainX = (float) models_shape[2]/ (float) width;
+      transform.gainY = (float) models_shape[1]/ (float) height;
+      getBBoxResults(outputBboxes, results, results_shape, transform, height, width, thresh);
+    }
+
+    /**
+      Routine to postprocess ObjectDetection output of a model fed through a letterbox or any other preprocess transform.
+      The boxes are mapped back exactly to image coordinates and clipped to the image.
+      @param outputBboxes output to be stored as a vector of vector of float
+      @param results vector of the output results in float
+      @param results_shape vector of the output shape
+      @param transform mapping of image to model input coordinates used while preprocessing
+      @param height of the image
+      @param width of the image
+      @param thresh confidence higher than this is considered
+    */
+    void ResultPostProcess::getBBoxResults(std::vector<std::vector<float> >& outputBboxes, float* results, std::vector<int> results_shape, const PreprocessTransform& transform, int height, int width, float thresh)
     {
       // Output is of type: 0,1,2,3 ->box, 4->confidence，5-85 -> coco classes confidence
       rows = results_shape[1]; cols = results_shape[2];
-      xGain = (float) models_shape[2]/ (float) width;
-      yGain = (float) models_shape[1]/ (float) height;
-      std::vector<float> output;
 
       for (int i=0; i<rows; ++i)
       {
@@ -76,24 +93,108 @@ namespace edgeml
         {
           if ((results[i*cols + j]*confidence) <= thresh) continue;
 
-          x1 = (results[i*cols + 0] - results[i*cols + 2] / 2) / xGain;
-          y1 = (results[i*cols + 1] - results[i*cols + 3] / 2) / yGain;
-          x2 = (results[i*cols + 0] + results[i*cols + 2] / 2) / xGain;
-          y2 = (results[i*cols + 1] + results[i*cols + 3] / 2) / yGain;
+          x1 = (results[i*cols + 0] - results[i*cols + 2] / 2 - transform.padX) / transform.gainX;
+          y1 = (results[i*cols + 1] - results[i*cols + 3] / 2 - transform.padY) / transform.gainY;
+          x2 = (results[i*cols + 0] + results[i*cols + 2] / 2 - transform.padX) / transform.gainX;
+          y2 = (results[i*cols + 1] + results[i*cols + 3] / 2 - transform.padY) / transform.gainY;
 
           std::vector<float> output;
-          output.push_back(x1); // bbox x1
-          output.push_back(y1); // bbox y1
-          output.push_back(x2); // bbox x2
-          output.push_back(y2); // bbox y2
+          output.push_back(std::min(std::max(x1, 0.0f), (float)(width))); // bbox x1
+          output.push_back(std::min(std::max(y1, 0.0f), (float)(height))); // bbox y1
+          output.push_back(std::min(std::max(x2, 0.0f), (float)(width))); // bbox x2
+          output.push_back(std::min(std::max(y2, 0.0f), (float)(height))); // bbox y2
           output.push_back(j-5); // class
           output.push_back(results[i*cols + j]*confidence); // confidence score
 
           outputBboxes.push_back(output);
-          output.clear();
         }
       }
     }
 
+    /**
+      Routine to suppress overlapping boxes of the same class, e.g. the detections of one object in neighbouring tiles.
+      The box with the higher score is kept.
+      @param outputBboxes boxes as x1,y1,x2,y2,class,score, replaced by the boxes kept in descending score
+      @param iouThresh boxes overlapping a kept box by more than this intersection over union are dropped
+    */
+    void ResultPostProcess::nms(std::vector<std::vector<float> >& outputBboxes, float iouThresh)
+    {
+      std::stable_sort(outputBboxes.begin(), outputBboxes.end(), [](const std::vector<float>& a, const std::vector<float>& b) {return a[5] > b[5];});
+
+      std::vector<std::vector<float> > kept;
+      for (auto& box : outputBboxes)
+      {
+        float area = std::max(box[2] - box[0], 0.0f) * std::max(box[3] - box[1], 0.0f);
+        bool suppressed = false;
+        for (auto& other : kept)
+        {
+          if (other[4]!=box[4]) continue;
+          float overlap = std::max(std::min(box[2], other[2]) - std::max(box[0], other[0]), 0.0f) * std::max(std::min(box[3], other[3]) - std::max(box[1], other[1]), 0.0f);
+          float otherArea = std::max(other[2] - other[0], 0.0f) * std::max(other[3] - other[1], 0.0f);
+          float unionArea = area + otherArea - overlap;
+          if (unionArea>0 && overlap / unionArea > iouThresh)
+          {
+            suppressed = true;
+            break;
+          }
+        }
+        if (!suppressed)
+        {
+          kept.push_back(box);
+        }
+      }
+      outputBboxes.swap(kept);
+    }
+
+    /**
+      Routine to stitch the segmentation output of a tile into the mask of the whole frame. The part of the tile mask
+      covering the tile is resized to the tile and merged by keeping the higher score where tiles overlap.
+      @param mask mask of the frame of size height x width x classes in the layout of the output, allocated with the lowest score if it does not have that size
+      @param height of the frame
+      @param width of the frame
+      @param results output of the model for the tile
+      @param results_shape vector of the output shape in N,C,H,W or N,H,W,C
+      @param is_chw true if the output and the mask are channels first
+      @param model_height height of the model input
+      @param model_width width of the model input
+      @param transform mapping of tile to model input coordinates used while preprocessing
+      @param tile region of the tile in the frame
+    */
+    void ResultPostProcess::stitchMask(std::vector<float>& mask, int height, int width, const float* results, std::vector<int> results_shape, bool is_chw, int model_height, int model_width, const PreprocessTransform& transform, const cv::Rect& tile)
+    {
+      int channels = results_shape[3];
+      rows = results_shape[1]; cols = results_shape[2];
+      if (is_chw)
+      {
+        channels = results_shape[1];
+        rows = results_shape[2]; cols = results_shape[3];
+      }
+      if (mask.size()!=(size_t)(height) * width * channels)
+      {
+        mask.assign((size_t)(height) * width * channels, std::numeric_limits<float>::lowest());
+      }
+
+      // Region of the tile inside the model input, in mask coordinates
+      float scaleX = (float)(cols) / model_width, scaleY = (float)(rows) / model_height;
+      cv::Rect content(cvRound(transform.padX * scaleX), cvRound(transform.padY * scaleY), cvRound(tile.width * transform.gainX * scaleX), cvRound(tile.height * transform.gainY * scaleY));
+      content &= cv::Rect(0, 0, cols, rows);
+      if (content.empty())
+      {
+        return;
+      }
+
+      // Channels first masks are stitched plane by plane
+      int planes = is_chw ? channels : 1;
+      int planeChannels = is_chw ? 1 : channels;
+      for (int c=0; c<planes; c++)
+      {
+        cv::Mat tileMask(rows, cols, CV_32FC(planeChannels), (void*)(results + (size_t)(c) * rows * cols)), resizedMask;
+        cv::resize(tileMask(content), resizedMask, tile.size(), 0, 0, cv::INTER_LINEAR);
+        cv::Mat frameMask(height, width, CV_32FC(planeChannels), mask.data() + (size_t)(c) * height * width);
+        cv::Mat region = frameMask(tile);
+        cv::max(region, resizedMask, region);
+      }
+    }
+
   }
 }
\ No newline at end of file
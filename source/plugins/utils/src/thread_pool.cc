@@ -0,0 +1,136 @@
+/**
+ * @thread_pool.cc
+ * @brief Thread pool utils and routines
+ *
+ * This contains the functions used for spreading a batch of independent tasks over a pool of threads
+ *
+ */
+
+#include <edge-ml-accelerator/utils/thread_pool.h>
+
+namespace edgeml
+{
+  namespace utils
+  {
+
+    /**
+      Creates the class constructor
+      @param numThreads number of threads running tasks, including the thread calling run
+    */
+    ThreadPool::ThreadPool(int numThreads)
+    {
+      for (int t=1; t<numThreads; t++)
+      {
+        workers_.push_back(std::thread(&ThreadPool::runWorker, this));
+      }
+    }
+
+    /**
+      Creates the class destructor, waiting for the workers to finish
+    */
+    ThreadPool::~ThreadPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+      }
+      workCv_.notify_all();
+      for (auto& worker : workers_)
+      {
+        if (worker.joinable())
+          worker.join();
+      }
+    }
+
+    /**
+      Running a batch of tasks on the pool. The calling thread takes tasks as well, so a pool of one thread runs
+      them one after another. The first exception thrown by a task is rethrown once the whole batch is done.
+      @param numTasks number of tasks
+      @param task routine called with the index of every task
+    */
+    void ThreadPool::run(int numTasks, const std::function<void(int)>& task)
+    {
+      if (numTasks<=0)
+      {
+        return;
+      }
+      std::unique_lock<std::mutex> lock(mtx_);
+      task_ = &task;
+      numTasks_ = numTasks;
+      nextTask_ = 0;
+      pendingTasks_ = numTasks;
+      error_ = nullptr;
+      batch_++;
+      workCv_.notify_all();
+
+      runTasks(lock);
+      doneCv_.wait(lock, [&](){ return pendingTasks_==0; });
+      task_ = nullptr;
+
+      if (error_)
+      {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+      }
+    }
+
+    /**
+      Taking tasks of the current batch until none is left, called with the lock held
+    */
+    void ThreadPool::runTasks(std::unique_lock<std::mutex>& lock)
+    {
+      while (task_!=nullptr && nextTask_<numTasks_)
+      {
+        int index = nextTask_++;
+        const std::function<void(int)>* task = task_;
+        lock.unlock();
+        try
+        {
+          (*task)(index);
+        }
+        catch (...)
+        {
+          lock.lock();
+          if (!error_)
+            error_ = std::current_exception();
+          lock.unlock();
+        }
+        lock.lock();
+        if (--pendingTasks_==0)
+        {
+          doneCv_.notify_all();
+        }
+      }
+    }
+
+    /**
+      Worker loop, waiting for a new batch and helping with its tasks
+    */
+    void ThreadPool::runWorker()
+    {
+      unsigned long seenBatch = 0;
+      std::unique_lock<std::mutex> lock(mtx_);
+      while (true)
+      {
+        workCv_.wait(lock, [&](){ return stop_ || (batch_!=seenBatch && task_!=nullptr); });
+        if (stop_)
+        {
+          return;
+        }
+        seenBatch = batch_;
+        runTasks(lock);
+      }
+    }
+
+    /**
+      Getting the number of threads running tasks
+      @return int number of threads including the calling one
+    */
+    int ThreadPool::getNumThreads()
+    {
+      return (int)(workers_.size()) + 1;
+    }
+
+  }
+}
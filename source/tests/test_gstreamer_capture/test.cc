@@ -14,6 +14,7 @@
 #include <vector>
 #include <cstdio>
 #include <stdio.h>
+#include <cassert>
 
 #include <edge-ml-accelerator/pipeline/pipeline.h>
 
@@ -43,13 +44,42 @@ int main(int argc, char *argv[])
     // Using GStreamer Capture API
     int cameraIndex = 0;
     pTrigger = new SoftTrigger(jsonParams_, cameraIndex);
+#ifdef WITH_GSTREAMER
+    pCapture = new GstreamerCapture(jsonParams_, cameraIndex, pTrigger->trigger2camera_);
+#else
     pCapture = new OpenCVCapture(jsonParams_, cameraIndex, pTrigger->trigger2camera_);
+#endif
     int ret;
 
     ret = pCapture->initCapture(cameraIndex);
-    assert((ret==CAPTURE_OK || ret==CAMERA_MISSING) && "Camera: " + std::to_string(ret));
+    assert((ret==CAPTURE_OK || ret==CAMERA_MISSING) && "GStreamer capture could not be initialized");
     LOG_ALWAYS("[TESTS::CAPTURE::GSTREAMER] Successfully tested GStreamerCapture->initCapture()");
 
+#ifdef WITH_GSTREAMER
+    // Pulling two videotestsrc frames which are handed over as mapped memory
+    assert(ret==CAPTURE_OK && "videotestsrc pipeline could not be launched");
+    std::string pipelineName = "pipeline1";
+    pCapture->camera2forward_.insert(pipelineName);
+    for (int i=0; i<2; i++)
+    {
+        MessageT2C message;
+        message.captureTriggersMessage_ = pipelineName;
+        pTrigger->trigger2camera_.produce_message(message);
+    }
+
+    int errc = -100, iter = 1, frameDataSize = 0;
+    unsigned char* frameData = nullptr;
+    pCapture->getCapture(errc, frameData, frameDataSize, iter);
+    assert(errc==CAPTURE_OK && "GStreamer capture could not pull frames");
+    assert(pCapture->camera2forward_.size_queue(pipelineName)==2 && "GStreamer capture did not forward all frames");
+    assert(frameDataSize==pCapture->getInputHeight()*pCapture->getInputWidth()*3 && "GStreamer frame has wrong size");
+
+    auto forwarded = pCapture->camera2forward_.GetMessage(pipelineName);
+    assert(forwarded.safeCaptureOwnerContainer_.size()==1 && forwarded.safeCaptureOwnerContainer_[0] && "GStreamer frame is not kept alive by its sample");
+    assert(forwarded.pixelFormat_==PIXEL_FORMAT_RGB && "GStreamer frame is not tagged with the format of its caps");
+    LOG_ALWAYS("[TESTS::CAPTURE::GSTREAMER] Successfully tested GStreamerCapture->getCapture()");
+#endif
+
     delete pTrigger;
     delete pCapture;
 
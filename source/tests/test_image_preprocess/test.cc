@@ -0,0 +1,353 @@
+/**
+ * @test.cc
+ * @brief Unit Test for the Image Preprocess and Result Postprocess utils
+ *
+ * This contains the tests of the frame to model input mapping on known sizes and of the normalization
+ * and quantization parameters read from the preprocess config.
+ * Synthetic images are normalized into every tensor layout and element type and compared pixel by pixel
+ * with a scalar reference, at a width that runs both the SIMD and the tail of a row.
+ * Frames are resized and normalized in one pass and compared with cv::resize followed by the same normalization.
+ * The letterbox plan is built and detections are mapped back through it to frame coordinates,
+ * frames are cut into tiles and the detections of neighbouring tiles are merged.
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cassert>
+
+#include <edge-ml-accelerator/utils/image_preprocess.h>
+#include <edge-ml-accelerator/utils/result_postprocess.h>
+
+using namespace edgeml::utils;
+
+static bool near(float a, float b, float tolerance = 1e-3f)
+{
+    return std::fabs(a - b) <= tolerance;
+}
+
+/* Pixel of the synthetic images, running through the whole 0..255 range within a few rows */
+static unsigned char testPixel(int x, int y, int c)
+{
+    return (unsigned char)((x * 37 + y * 101 + c * 71) % 256);
+}
+
+/* Scalar reference of one tensor element: pixel * scale + offset, rounded and saturated to the element type */
+static float referenceValue(unsigned char pixel, int k, const PreprocessParams& params)
+{
+    float value = pixel * params.scale[k] + params.offset[k];
+    if (params.dataType==TENSOR_TYPE_FLOAT16)
+        return (float)(cv::float16_t(value));
+    if (params.dataType==TENSOR_TYPE_UINT8)
+        return cv::saturate_cast<unsigned char>(value);
+    if (params.dataType==TENSOR_TYPE_INT8)
+        return cv::saturate_cast<signed char>(value);
+    return value;
+}
+
+/* Reading one element of a tensor of any element type as float */
+static float tensorValue(const std::vector<unsigned char>& tensor, size_t index, int dataType)
+{
+    if (dataType==TENSOR_TYPE_FLOAT16)
+    {
+        cv::float16_t h;
+        std::memcpy(&h, tensor.data() + index * 2, 2);
+        return (float)(h);
+    }
+    if (dataType==TENSOR_TYPE_UINT8)
+        return tensor[index];
+    if (dataType==TENSOR_TYPE_INT8)
+        return (signed char)(tensor[index]);
+    float value;
+    std::memcpy(&value, tensor.data() + index * 4, 4);
+    return value;
+}
+
+/* Normalizing a synthetic image, rows padded by padding bytes, and comparing every tensor element with the scalar reference */
+static bool checkNormalize(int width, int height, int channels, const PreprocessParams& params, bool swapRB, size_t padding = 0)
+{
+    size_t step = (size_t)(width) * channels + padding;
+    std::vector<unsigned char> image(step * height, 0);
+    for (int y=0; y<height; y++)
+        for (int x=0; x<width; x++)
+            for (int c=0; c<channels; c++)
+                image[y * step + x * channels + c] = testPixel(x, y, c);
+
+    std::vector<unsigned char> tensor((size_t)(width) * height * channels * ImagePreProcess::getTensorElementSize(params.dataType), 0);
+    ImagePreProcess imagePreprocess;
+    if (!imagePreprocess.normalize(image.data(), width, height, channels, params, tensor.data(), swapRB, (padding>0) ? step : 0))
+        return false;
+
+    bool isPlanar = (params.layout==TENSOR_LAYOUT_NCHW && channels>1);
+    for (int y=0; y<height; y++)
+    {
+        for (int x=0; x<width; x++)
+        {
+            for (int k=0; k<channels; k++)
+            {
+                int c = (swapRB && channels>=3 && (k==0 || k==2)) ? 2-k : k;
+                size_t index = isPlanar ? ((size_t)(k) * height + y) * width + x : ((size_t)(y) * width + x) * channels + k;
+                float expected = referenceValue(testPixel(x, y, c), k, params);
+                float tolerance = (params.dataType==TENSOR_TYPE_UINT8 || params.dataType==TENSOR_TYPE_INT8) ? 0.0f : 1e-3f * (1.0f + std::fabs(expected));
+                if (!near(tensorValue(tensor, index, params.dataType), expected, tolerance))
+                {
+                    LOG_ERROR("[TESTS::UTILS::PREPROCESS] Tensor element of pixel [" + std::to_string(y) + "," + std::to_string(x) + "] channel " + std::to_string(k) + " is " + std::to_string(tensorValue(tensor, index, params.dataType)) + ", expected " + std::to_string(expected));
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/* Resizing and normalizing a frame into a float32 NCHW tensor and comparing it within 1 LSB of the pixel range with
+   the reference image (the frame in the model format) resized by OpenCV and normalized by hand */
+static bool checkResizeNormalize(const std::vector<unsigned char>& frame, int width, int height, int inputFormat, int output_width, int output_height, int modelFormat, const PreprocessParams& params, const cv::Mat& reference)
+{
+    int channels = (modelFormat==PIXEL_FORMAT_GRAY) ? 1 : 3;
+    cv::Mat expected;
+    cv::resize(reference, expected, cv::Size(output_width, output_height), 0, 0, (params.interpolation==cv::INTER_LINEAR) ? cv::INTER_LINEAR : cv::INTER_NEAREST_EXACT);
+
+    std::vector<float> tensor((size_t)(output_width) * output_height * channels, 0.0f);
+    ImagePreProcess imagePreprocess;
+    PreprocessPlan plan;
+    if (!imagePreprocess.resizeNormalize(frame.data(), width, height, inputFormat, output_width, output_height, modelFormat, params, plan, tensor.data()))
+        return false;
+
+    for (int y=0; y<output_height; y++)
+    {
+        for (int x=0; x<output_width; x++)
+        {
+            for (int k=0; k<channels; k++)
+            {
+                float value = tensor[((size_t)(k) * output_height + y) * output_width + x];
+                float normalized = expected.ptr<unsigned char>(y)[x * channels + k] * params.scale[k] + params.offset[k];
+                if (!near(value, normalized, std::fabs(params.scale[k]) + 1e-3f))
+                {
+                    LOG_ERROR("[TESTS::UTILS::PREPROCESS] Resized tensor element of pixel [" + std::to_string(y) + "," + std::to_string(x) + "] channel " + std::to_string(k) + " is " + std::to_string(value) + ", expected " + std::to_string(normalized));
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Starting Unit Tests for Image Preprocess.");
+
+    // Mean / std normalization with the last value repeated for the remaining channels
+    PreprocessParams normalizeParams = ImagePreProcess::getPreprocessParams(jsonParser::parser::parse("{\"scaleBy\": 255, \"mean\": [0.485, 0.456, 0.406], \"std\": [0.229, 0.224, 0.225]}"), TENSOR_LAYOUT_NCHW, TENSOR_TYPE_FLOAT32);
+    assert(near(normalizeParams.scale[0], 1.0f / (255.0f * 0.229f), 1e-6f) && near(normalizeParams.offset[0], -0.485f / 0.229f));
+    assert(near(normalizeParams.scale[2], 1.0f / (255.0f * 0.225f), 1e-6f) && near(normalizeParams.offset[2], -0.406f / 0.225f));
+    assert(near(normalizeParams.scale[3], normalizeParams.scale[2], 1e-6f) && near(normalizeParams.offset[3], normalizeParams.offset[2]));
+    assert(near(255.0f * normalizeParams.scale[1] + normalizeParams.offset[1], (1.0f - 0.456f) / 0.224f));
+    assert(!normalizeParams.isIdentity && !normalizeParams.isInteger && normalizeParams.layout==TENSOR_LAYOUT_NCHW);
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::getPreprocessParams() mean and std");
+
+    // No preprocess config is a plain copy, the layout can be overridden
+    PreprocessParams identityParams = ImagePreProcess::getPreprocessParams(jsonParser::parser::parse("{\"layout\": \"nhwc\"}"), TENSOR_LAYOUT_NCHW, TENSOR_TYPE_FLOAT32);
+    assert(identityParams.isIdentity && near(identityParams.scale[0], 1.0f) && near(identityParams.offset[0], 0.0f));
+    assert(identityParams.layout==TENSOR_LAYOUT_NHWC);
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::getPreprocessParams() identity and layout");
+
+    // uint8 model quantized with a scale of 1/255 and no zero point takes the pixels as they are
+    PreprocessParams uint8Params = ImagePreProcess::getPreprocessParams(jsonParser::parser::parse("{\"scaleBy\": 255, \"quantization\": {\"scale\": 0.00392156862745098, \"zeroPoint\": 0}}"), TENSOR_LAYOUT_NCHW, TENSOR_TYPE_UINT8);
+    assert(uint8Params.isInteger && uint8Params.isIdentity);
+    assert(near(uint8Params.scale[0], 1.0f) && near(uint8Params.offset[0], 0.0f));
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::getPreprocessParams() uint8 quantization");
+
+    // int8 model without quantization config shifts the pixels by the default zero point of -128
+    PreprocessParams int8Params = ImagePreProcess::getPreprocessParams(jsonParser::parser::parse("{}"), TENSOR_LAYOUT_NCHW, TENSOR_TYPE_INT8);
+    assert(int8Params.isInteger && !int8Params.isIdentity);
+    assert(near(int8Params.scale[0], 1.0f) && near(int8Params.offset[0], -128.0f));
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::getPreprocessParams() int8 default zero point");
+
+    // int8 model quantized from [-1, 1] with a scale of 1/128 and a zero point of 0
+    PreprocessParams quantParams = ImagePreProcess::getPreprocessParams(jsonParser::parser::parse("{\"scaleBy\": 127.5, \"mean\": [1.0], \"quantization\": {\"scale\": 0.0078125, \"zeroPoint\": 0}}"), TENSOR_LAYOUT_NHWC, TENSOR_TYPE_INT8);
+    assert(!quantParams.isInteger && !quantParams.isIdentity);
+    assert(near(quantParams.scale[0], 128.0f / 127.5f, 1e-5f) && near(quantParams.offset[0], -128.0f));
+    assert(near(255.0f * quantParams.scale[0] + quantParams.offset[0], 128.0f));
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::getPreprocessParams() int8 scale and zero point");
+
+    // 17 pixel rows run one SIMD block and a scalar tail; mean / std parameters into float32 tensors
+    bool checked = checkNormalize(17, 3, 3, normalizeParams, false);
+    assert(checked);
+    normalizeParams.layout = TENSOR_LAYOUT_NHWC;
+    checked = checkNormalize(17, 3, 3, normalizeParams, true);
+    assert(checked);
+    checked = checkNormalize(17, 3, 1, normalizeParams, false);
+    assert(checked);
+    checked = checkNormalize(17, 3, 3, normalizeParams, false, 5);
+    assert(checked);
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::normalize() float32 NCHW, NHWC, swapRB, gray and row step");
+
+    // Narrowed element types, scales and offsets chosen so that negative and overflowing values are saturated
+    PreprocessParams narrowParams;
+    narrowParams.isIdentity = false;
+    narrowParams.scale[0] = 0.5f; narrowParams.scale[1] = 0.75f; narrowParams.scale[2] = 1.25f;
+    narrowParams.offset[0] = -20.0f; narrowParams.offset[1] = 3.0f; narrowParams.offset[2] = -100.0f;
+    for (int dataType : {TENSOR_TYPE_FLOAT16, TENSOR_TYPE_UINT8, TENSOR_TYPE_INT8})
+    {
+        narrowParams.dataType = dataType;
+        for (int layout : {TENSOR_LAYOUT_NCHW, TENSOR_LAYOUT_NHWC})
+        {
+            narrowParams.layout = layout;
+            checked = checkNormalize(17, 3, 3, narrowParams, false) && checkNormalize(17, 3, 3, narrowParams, true) && checkNormalize(17, 3, 1, narrowParams, false);
+            assert(checked);
+        }
+    }
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::normalize() float16, uint8 and int8");
+
+    // Integer offsets into 8-bit tensors skip the floats, the int8 default zero point and a saturating uint8 offset
+    checked = checkNormalize(17, 3, 3, int8Params, true) && checkNormalize(17, 3, 1, int8Params, false);
+    assert(checked);
+    PreprocessParams offsetParams = int8Params;
+    offsetParams.dataType = TENSOR_TYPE_UINT8;
+    offsetParams.layout = TENSOR_LAYOUT_NHWC;
+    offsetParams.offset[0] = offsetParams.offset[1] = offsetParams.offset[2] = 100.0f;
+    checked = checkNormalize(17, 3, 3, offsetParams, true);
+    assert(checked);
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::normalize() integer offsets");
+
+    // Identity uint8 tensors are copies, rearranged into planes or swapped channels
+    checked = checkNormalize(17, 3, 3, uint8Params, false) && checkNormalize(17, 3, 3, uint8Params, true);
+    assert(checked);
+    uint8Params.layout = TENSOR_LAYOUT_NHWC;
+    checked = checkNormalize(17, 3, 3, uint8Params, false) && checkNormalize(17, 3, 3, uint8Params, true) && checkNormalize(17, 3, 3, uint8Params, false, 5);
+    assert(checked);
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::normalize() uint8 copies");
+
+    // RGB frames resized by OpenCV, smooth gradients keep the fixed point weights of both within 1 LSB
+    PreprocessParams resizeParams = ImagePreProcess::getPreprocessParams(jsonParser::parser::parse("{\"scaleBy\": 255, \"mean\": [0.485, 0.456, 0.406], \"std\": [0.229, 0.224, 0.225]}"), TENSOR_LAYOUT_NCHW, TENSOR_TYPE_FLOAT32);
+    std::vector<unsigned char> rgbFrame(34 * 26 * 3);
+    for (int y=0; y<26; y++)
+        for (int x=0; x<34; x++)
+            for (int c=0; c<3; c++)
+                rgbFrame[(y * 34 + x) * 3 + c] = (unsigned char)(x * 4 + y * 3 + c * 20);
+    cv::Mat rgbImage(cv::Size(34, 26), CV_8UC3, rgbFrame.data()), bgrImage;
+    cv::cvtColor(rgbImage, bgrImage, cv::COLOR_RGB2BGR);
+    checked = checkResizeNormalize(rgbFrame, 34, 26, PIXEL_FORMAT_RGB, 17, 13, PIXEL_FORMAT_RGB, resizeParams, rgbImage);
+    assert(checked);
+    resizeParams.interpolation = cv::INTER_LINEAR;
+    checked = checkResizeNormalize(rgbFrame, 34, 26, PIXEL_FORMAT_RGB, 17, 13, PIXEL_FORMAT_BGR, resizeParams, bgrImage);
+    assert(checked);
+    checked = checkResizeNormalize(rgbFrame, 34, 26, PIXEL_FORMAT_RGB, 23, 19, PIXEL_FORMAT_RGB, resizeParams, rgbImage);
+    assert(checked);
+    checked = checkResizeNormalize(rgbFrame, 34, 26, PIXEL_FORMAT_RGB, 61, 47, PIXEL_FORMAT_RGB, resizeParams, rgbImage);
+    assert(checked);
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::resizeNormalize() nearest and bilinear against cv::resize");
+
+    // NV12 frames into RGB and GRAY models are converted and then sampled bilinearly like any other frame
+    std::vector<unsigned char> nv12Frame(40 * 30 * 3 / 2);
+    for (int y=0; y<30; y++)
+        for (int x=0; x<40; x++)
+            nv12Frame[y * 40 + x] = (unsigned char)(16 + x * 4 + y * 2);
+    for (int y=0; y<15; y++)
+        for (int x=0; x<20; x++)
+        {
+            nv12Frame[40 * 30 + y * 40 + 2 * x] = (unsigned char)(100 + x * 2);
+            nv12Frame[40 * 30 + y * 40 + 2 * x + 1] = (unsigned char)(150 - y * 2);
+        }
+    cv::Mat nv12Image(cv::Size(40, 45), CV_8UC1, nv12Frame.data()), nv12Rgb;
+    cv::cvtColor(nv12Image, nv12Rgb, cv::COLOR_YUV2RGB_NV12);
+    checked = checkResizeNormalize(nv12Frame, 40, 30, PIXEL_FORMAT_NV12, 20, 16, PIXEL_FORMAT_RGB, resizeParams, nv12Rgb);
+    assert(checked);
+    checked = checkResizeNormalize(nv12Frame, 40, 30, PIXEL_FORMAT_NV12, 20, 16, PIXEL_FORMAT_GRAY, resizeParams, nv12Image.rowRange(0, 30));
+    assert(checked);
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::resizeNormalize() bilinear NV12 frames");
+
+    PreprocessParams params;
+    PreprocessPlan plan;
+
+    // 1280x720 into 640x640: halved and centered vertically
+    params.letterbox = true;
+    int built = ImagePreProcess::buildPlan(plan, 1280, 720, 3, 640, 640, params);
+    assert(built);
+    assert(near(plan.transform.gainX, 0.5f) && near(plan.transform.gainY, 0.5f));
+    assert(near(plan.transform.padX, 0.0f) && near(plan.transform.padY, 140.0f));
+    assert(plan.contentX0==0 && plan.contentX1==640 && plan.contentY0==140 && plan.contentY1==500);
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::buildPlan() letterbox gain and padding");
+
+    // Padding rounded down to the stride
+    PreprocessPlan stridePlan;
+    params.stride = 32;
+    built = ImagePreProcess::buildPlan(stridePlan, 1280, 720, 3, 640, 640, params);
+    assert(built);
+    assert(near(stridePlan.transform.padY, 128.0f) && stridePlan.contentY0==128 && stridePlan.contentY1==488);
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::buildPlan() letterbox stride");
+
+    // Small frames are not enlarged without scaleUp
+    PreprocessPlan smallPlan;
+    params.stride = 1;
+    params.scaleUp = false;
+    built = ImagePreProcess::buildPlan(smallPlan, 320, 240, 3, 640, 640, params);
+    assert(built);
+    assert(near(smallPlan.transform.gainX, 1.0f) && near(smallPlan.transform.gainY, 1.0f));
+    assert(near(smallPlan.transform.padX, 160.0f) && near(smallPlan.transform.padY, 200.0f));
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::buildPlan() without scaleUp");
+
+    // Without letterbox the frame is stretched
+    PreprocessPlan stretchPlan;
+    built = ImagePreProcess::buildPlan(stretchPlan, 1280, 720, 3, 640, 640, PreprocessParams());
+    assert(built);
+    assert(near(stretchPlan.transform.gainX, 0.5f) && near(stretchPlan.transform.gainY, 640.0f / 720.0f));
+    assert(near(stretchPlan.transform.padX, 0.0f) && near(stretchPlan.transform.padY, 0.0f));
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::buildPlan() stretch");
+
+    // Boxes as cx,cy,w,h,confidence,class scores in model input coordinates of the 1280x720 letterbox
+    ResultPostProcess postprocess;
+    std::vector<float> detections = {
+        100.0f, 290.0f, 100.0f, 100.0f, 0.9f, 0.1f, 1.0f, // frame box 100,200,300,400 of class 1
+        620.0f, 480.0f, 80.0f, 80.0f, 0.8f, 1.0f, 0.0f, // frame box running over the bottom right corner, class 0
+        320.0f, 320.0f, 50.0f, 50.0f, 0.1f, 1.0f, 1.0f // below the threshold
+    };
+    std::vector<std::vector<float> > bboxes;
+    postprocess.getBBoxResults(bboxes, detections.data(), {1, 3, 7}, plan.transform, 720, 1280, 0.25f);
+    assert(bboxes.size()==2);
+    assert(near(bboxes[0][0], 100.0f) && near(bboxes[0][1], 200.0f) && near(bboxes[0][2], 300.0f) && near(bboxes[0][3], 400.0f));
+    assert(near(bboxes[0][4], 1.0f) && near(bboxes[0][5], 0.9f));
+    assert(near(bboxes[1][0], 1160.0f) && near(bboxes[1][1], 600.0f) && near(bboxes[1][2], 1280.0f) && near(bboxes[1][3], 720.0f));
+    assert(near(bboxes[1][4], 0.0f) && near(bboxes[1][5], 0.8f));
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ResultPostProcess::getBBoxResults() through the letterbox");
+
+    // 1000x600 frame in 400x400 tiles overlapping by 100, the last tile of a row or column is moved back inside
+    TilingParams tiling;
+    tiling.tileWidth = 400;
+    tiling.tileHeight = 400;
+    tiling.overlap = 100;
+    std::vector<cv::Rect> tiles = ImagePreProcess::getTiles(1000, 600, tiling);
+    std::vector<cv::Rect> expectedTiles = {
+        cv::Rect(0, 0, 400, 400), cv::Rect(300, 0, 400, 400), cv::Rect(600, 0, 400, 400),
+        cv::Rect(0, 200, 400, 400), cv::Rect(300, 200, 400, 400), cv::Rect(600, 200, 400, 400)
+    };
+    assert(tiles==expectedTiles);
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::getTiles() overlap and edge tiles");
+
+    // Frames smaller than a tile are one tile, tiles without a size are none
+    tiles = ImagePreProcess::getTiles(300, 200, tiling);
+    assert(tiles.size()==1 && tiles[0]==cv::Rect(0, 0, 300, 200));
+    tiles = ImagePreProcess::getTiles(1000, 600, TilingParams());
+    assert(tiles.empty());
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ImagePreProcess::getTiles() small frames");
+
+    // Boxes as x1,y1,x2,y2,class,score: overlapping boxes of one class keep the best, other classes are kept
+    std::vector<std::vector<float> > merged = {
+        {0.0f, 0.0f, 100.0f, 100.0f, 0.0f, 0.9f},
+        {10.0f, 0.0f, 110.0f, 100.0f, 0.0f, 0.8f}, // IoU 0.82 with the first
+        {10.0f, 0.0f, 110.0f, 100.0f, 1.0f, 0.7f}, // same place, other class
+        {200.0f, 200.0f, 300.0f, 300.0f, 0.0f, 0.95f},
+        {250.0f, 200.0f, 350.0f, 300.0f, 0.0f, 0.6f} // IoU 0.33 with the fourth
+    };
+    postprocess.nms(merged, 0.45f);
+    assert(merged.size()==4);
+    assert(near(merged[0][5], 0.95f) && near(merged[1][5], 0.9f) && near(merged[2][5], 0.7f) && near(merged[3][5], 0.6f));
+    assert(near(merged[2][4], 1.0f));
+    LOG_ALWAYS("[TESTS::UTILS::PREPROCESS] Successfully tested ResultPostProcess::nms()");
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * @test.cc
+ * @brief Unit Test for running Synthetic Capture API
+ *
+ * This contains the test for running Synthetic image Capture.
+ * The basic test generates frames without any camera and gathers output as a byte array.
+ *
+ */
+
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdio.h>
+#include <cassert>
+
+#include <edge-ml-accelerator/pipeline/pipeline.h>
+
+using namespace edgeml::utils;
+using namespace edgeml::trigger;
+using namespace edgeml::capture;
+using namespace edgeml::inference;
+using namespace edgeml::output;
+
+int main(int argc, char *argv[])
+{
+    LOG_ALWAYS("[TESTS::CAPTURE::SYNTHETIC] Starting Unit Tests for Synthetic Capture.");
+
+    const char *configFileEnvVar = "all_test_configs/TEST_CONFIG_SYNTHETIC.json"; // config file
+    std::string configFileEnvVarStr(configFileEnvVar);
+    jsonParser::jValue jsonParams_;
+    std::ifstream configFile(configFileEnvVar); // read the config file
+    std::string jsonParamsStr1 = "", jsonParamsStr2;
+    while (getline(configFile, jsonParamsStr2)) jsonParamsStr1 += jsonParamsStr2; // read the file line by line
+    jsonParams_ = jsonParser::parser::parse(jsonParamsStr1); // parse the json file using the jsonParser
+
+    Trigger* pTrigger;
+    Capture* pCapture;
+
+    // Using Synthetic Capture API
+    int cameraIndex = 0;
+    pTrigger = new SoftTrigger(jsonParams_, cameraIndex);
+    pCapture = new SyntheticCapture(jsonParams_, cameraIndex, pTrigger->trigger2camera_);
+    int ret;
+
+    ret = pCapture->initCapture(cameraIndex);
+    assert(ret==CAPTURE_OK && "Synthetic capture could not be initialized");
+    LOG_ALWAYS("[TESTS::CAPTURE::SYNTHETIC] Successfully tested SyntheticCapture->initCapture()");
+
+    // Generating two frames for a subpipeline without any camera attached
+    std::string pipelineName = "pipeline1";
+    pCapture->camera2forward_.insert(pipelineName);
+    for (int i=0; i<2; i++)
+    {
+        MessageT2C message;
+        message.captureTriggersMessage_ = pipelineName;
+        pTrigger->trigger2camera_.produce_message(message);
+    }
+
+    int errc = -100, iter = 1, frameDataSize = 0;
+    unsigned char* frameData = nullptr;
+    pCapture->getCapture(errc, frameData, frameDataSize, iter);
+    assert(errc==CAPTURE_OK && "Synthetic capture could not generate frames");
+    assert(pCapture->camera2forward_.size_queue(pipelineName)==2 && "Synthetic capture did not forward all frames");
+    assert(frameDataSize==pCapture->getInputHeight()*pCapture->getInputWidth()*3 && "Synthetic frame has wrong size");
+
+    auto forwarded = pCapture->camera2forward_.GetMessage(pipelineName);
+    assert(forwarded.safeCaptureContainer_.front()!=nullptr && "Synthetic frame is empty");
+    assert(forwarded.safeCaptureOwnerContainer_.size()==1 && "Synthetic frame is not pooled");
+    assert(forwarded.pixelFormat_==PIXEL_FORMAT_RGB && "Synthetic frame is not tagged with its pixel format");
+    LOG_ALWAYS("[TESTS::CAPTURE::SYNTHETIC] Successfully tested SyntheticCapture->getCapture()");
+
+    // Every frame carries a pyramid, consumers asking for the same size share one level
+    assert(forwarded.framePyramids_.size()==1 && "Synthetic frame has no frame pyramid");
+    const cv::Mat& level = forwarded.framePyramids_[0]->getLevel(320, 180, PIXEL_FORMAT_RGB);
+    const cv::Mat& sharedLevel = forwarded.framePyramids_[0]->getLevel(320, 180, PIXEL_FORMAT_RGB);
+    assert(level.cols==320 && level.rows==180 && level.data==sharedLevel.data && "Frame pyramid level is not shared");
+    assert(forwarded.framePyramids_[0]->getLevel(320, 180, PIXEL_FORMAT_GRAY).channels()==1 && forwarded.framePyramids_[0]->getNumLevels()==2 && "Frame pyramid level has the wrong format");
+    LOG_ALWAYS("[TESTS::CAPTURE::SYNTHETIC] Successfully tested SyntheticCapture->attachFramePyramids()");
+
+    // Regions of interest configured for the subpipeline travel with the frame
+    assert(forwarded.rois_.size()==1 && forwarded.rois_[0].name=="belt" && forwarded.rois_[0].height==320 && "Synthetic frame has no regions of interest");
+    auto crops = ImagePreProcess::getCrops(forwarded.rois_, pCapture->getInputWidth(), pCapture->getInputHeight());
+    assert(crops.size()==1 && crops[0].y==200 && crops[0].width==1280 && "Regions of interest are not cropped inside the frame");
+    LOG_ALWAYS("[TESTS::CAPTURE::SYNTHETIC] Successfully tested SyntheticCapture->attachRois()");
+
+    // A burst of three frames travels as one message
+    for (int i=0; i<2; i++)
+    {
+        MessageT2C message;
+        message.captureTriggersMessage_ = pipelineName;
+        message.captureTriggersMessageFull_["burstCount"] = 3;
+        pTrigger->trigger2camera_.produce_message(message);
+    }
+    pCapture->camera2forward_.GetMessage(pipelineName); // release the frame of the previous test
+    forwarded = MessageCaptureInference();
+    pCapture->getCapture(errc, frameData, frameDataSize, iter);
+    auto burst = pCapture->camera2forward_.GetMessage(pipelineName);
+    assert(burst.safeCaptureContainer_.size()==3 && burst.safeCaptureOwnerContainer_.size()==3 && "Synthetic burst is not a single multi-frame message");
+    assert(burst.inferenceDetailsMap_["burstCount"]==3 && "Synthetic burst details are missing");
+    assert(burst.framePyramids_.size()==3 && "Synthetic burst frames have no frame pyramids");
+    LOG_ALWAYS("[TESTS::CAPTURE::SYNTHETIC] Successfully tested SyntheticCapture->getCapture() with burstCount");
+
+    delete pTrigger;
+    delete pCapture;
+
+    return 0;
+}